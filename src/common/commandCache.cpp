@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "commandCache.h"
+
+/** stable 64 bit hash of the command, names the entry file (FNV-1a) */
+static uint64_t commandHash(const std::string& sCommand) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : sCommand) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static long long nowSeconds() {
+    return (long long)std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+CCommandCache::CCommandCache(const std::string& sDir) {
+    mDir = sDir;
+}
+
+std::string CCommandCache::entryPath(const std::string& sCommand) const {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << commandHash(sCommand) << ".json";
+    return (std::filesystem::path(mDir) / ss.str()).generic_string();
+}
+
+nlohmann::json CCommandCache::stamp(const std::vector<std::string>& vDependencies) {
+    nlohmann::json jStamp = nlohmann::json::array();
+    for (const auto& sPath : vDependencies) {
+        struct stat st;
+        if (stat(sPath.c_str(), &st) != 0) {
+            jStamp.push_back({{"path", sPath}, {"missing", true}});
+            continue;
+        }
+        jStamp.push_back({
+            {"path", sPath},
+            {"inode", (uint64_t)st.st_ino},
+            {"size", (int64_t)st.st_size},
+            {"mtime", (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec},
+            {"ctime", (int64_t)st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec}
+        });
+    }
+    return jStamp;
+}
+
+bool CCommandCache::lookup(const std::string& sCommand, const nlohmann::json& jStamp, long ttlSeconds, std::string& sOutput) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mEntries.find(sCommand);
+    if (it == mEntries.end() && !mDir.empty()) {
+        try {
+            std::ifstream ifs(entryPath(sCommand));
+            if (ifs.is_open()) {
+                it = mEntries.emplace(sCommand, nlohmann::json::parse(ifs)).first;
+            }
+        } catch (const std::exception& e) {
+            std::cout << "invalid command cache entry: " << e.what() << std::endl;
+        }
+    }
+    if (it == mEntries.end()) {
+        return false;
+    }
+
+    const nlohmann::json& jEntry = it->second;
+    //the file name is a hash, the command tells collisions apart
+    if (jEntry.value("command", std::string()) != sCommand || jEntry.value("stamp", nlohmann::json()) != jStamp) {
+        return false;
+    }
+    if (ttlSeconds > 0 && nowSeconds() - jEntry.value("time", 0LL) > ttlSeconds) {
+        return false;
+    }
+    sOutput = jEntry.value("output", std::string());
+    return true;
+}
+
+void CCommandCache::store(const std::string& sCommand, const nlohmann::json& jStamp, const std::string& sOutput) {
+    nlohmann::json jEntry = {
+        {"command", sCommand},
+        {"stamp", jStamp},
+        {"time", nowSeconds()},
+        {"output", sOutput}
+    };
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mDir.empty()) {
+        try {
+            std::filesystem::create_directories(mDir);
+            std::filesystem::permissions(mDir, std::filesystem::perms::owner_all);
+
+            //written aside and renamed, a reader never sees half an entry
+            std::string sPath = entryPath(sCommand);
+            std::string sTemp = sPath + ".tmp";
+            {
+                std::ofstream ofs(sTemp, std::ios::trunc);
+                ofs << jEntry.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+                if (!ofs.good()) {
+                    throw std::runtime_error("write failed: " + sTemp);
+                }
+            }
+            std::filesystem::rename(sTemp, sPath);
+        } catch (const std::exception& e) {
+            std::cout << "command cache not written: " << e.what() << std::endl;
+        }
+    }
+    mEntries[sCommand] = std::move(jEntry);
+}
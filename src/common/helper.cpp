@@ -17,61 +17,29 @@
  *
  */
  
-#ifdef __linux__
-#include <sys/wait.h>
-#endif
-
 #include "helper.h"
+#include "process.h"
 
 /**
  * Executes a command and returns the output as a string.
  *
  * @param cmd The command to be executed.
  * @param dummy An optional dummy parameter.
+ * @param pCancel If set, the command is stopped once the flag turns true;
+ *                the command runs in its own process group then.
  * @return The output of the command as a string.
  */
-std::string Helper::runCmd(const std::string cmd, int dummy) {
-    int fd[2];
-    const int buf_size = 1024;
-    long int num_bytes = 0;
-    pid_t pid;
-    char buf[buf_size];
-    std::string result = "";
-
-    if (pipe(fd) == -1) {
-        std::cout << "couldn't initiate command run" << std::endl;
-        return result;
-    }
-
-    if ((pid = fork()) == -1) {
-        std::cout << "couldn't run command" << std::endl;
-        return result;
-    }
-
-    if (pid == 0) { // child process
-        close(fd[0]); // close reading end in child process
-        dup2(fd[1], 1); // redirect stdout
-        dup2(fd[1], 2); // redirect stderr
-        close(fd[1]);
-        char *CMD[] = {(char *)"/bin/sh", (char *)"-c", (char *)cmd.c_str(), NULL};
-        execve(CMD[0], CMD, NULL);
-        std::cout << "failure in executing command" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    close(fd[1]); // close writing end in parent process
-    //memset(buf, '\0', buf_size);
-    while ((num_bytes = read(fd[0], buf, buf_size)) > 0) {
-        //std::cout << "***" << buf << std::endl;
-        result.append(buf, num_bytes);
-    }
-    //result.push_back('\0');
-
-    close(fd[0]);
-    if (wait(NULL) == -1) {
-        std::cerr << "error in executing child process" << std::endl;
+std::string Helper::runCmd(const std::string cmd, int dummy, const std::atomic<bool>* pCancel) {
+    stProcessOptions options;
+    options.bClearEnv = true;
+    options.pCancel = pCancel;
+
+    stProcessResult result = CProcess::runShell(cmd, options);
+    if (result.bCancelled) {
+        std::cout << "command cancelled: " << cmd << std::endl;
     }
     (void)dummy;
-    return result;
+    return result.output;
 }
 
 
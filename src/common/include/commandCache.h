@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * Output cache for read-only commands. An entry is found by the command and is
+ * valid while the dependency paths declared for it are unchanged (inode, size,
+ * mtime, ctime) and it is younger than the ttl of the lookup. Entries are kept
+ * in memory and, if a directory is given, one file per command there, so they
+ * outlive the process.
+ */
+class CCommandCache {
+
+private:
+    std::string mDir;
+    std::mutex mMutex;
+    std::map<std::string, nlohmann::json> mEntries;
+
+    //coverity
+    CCommandCache(CCommandCache const&) = delete;
+    void operator=(CCommandCache const&) = delete;
+
+    std::string entryPath(const std::string& sCommand) const;
+
+public:
+    /** sDir - directory of the entries, empty keeps them in memory only */
+    explicit CCommandCache(const std::string& sDir = "");
+
+    /** state of the dependency paths, taken before the command runs */
+    static nlohmann::json stamp(const std::vector<std::string>& vDependencies);
+
+    /**
+     * looks up the output of sCommand.
+     * @param jStamp stamp() of its dependencies now.
+     * @param ttlSeconds maximum age of the entry, 0 for no limit.
+     * @return true and sOutput if a valid entry exists.
+     */
+    bool lookup(const std::string& sCommand, const nlohmann::json& jStamp, long ttlSeconds, std::string& sOutput);
+
+    /** stores the output of sCommand, jStamp taken before it ran */
+    void store(const std::string& sCommand, const nlohmann::json& jStamp, const std::string& sOutput);
+};
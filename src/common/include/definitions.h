@@ -34,6 +34,7 @@
 #define MSG_NOT_IMPLEMENTED "service not Implemented"
 #define MSG_INTERNAL_ERROR "internal error"
 #define MSG_MISSING_CLIENTINFO "Invalid request or request missing client info"
+#define MSG_CANCELLED "Request cancelled"
 
 /**Plugin specific : discovery plugin*/
 #define COLLECT_STATUS "collect"
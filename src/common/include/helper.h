@@ -19,6 +19,7 @@
 
 #pragma once
 #include <string>
+#include <atomic>
 #include<iostream> 
 #include<algorithm>
 #include <regex>
@@ -49,7 +50,7 @@ class Helper
 {
 public:
 
-    static std::string runCmd(const std::string cmd, int dummy);
+    static std::string runCmd(const std::string cmd, int dummy, const std::atomic<bool>* pCancel = NULL);
     static void trim( std::string& strTotrim, std::string trimChars = ""); 
     static void trimHead( std::string& strTotrim, std::string trimChars = "");  
     static void trimEnd( std::string& strTotrim, std::string trimChars = "");       
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * Capture policy for commands with a lot of output, consumer of
+ * stProcessOptions::onOutput. Memory is bounded: only the first and the last
+ * bytes of the output are kept. The complete output can go to a file, which is
+ * rotated (to <file>.1) at a size limit, and can be compared with an expected
+ * value while it streams.
+ */
+class COutputCapture {
+
+private:
+    size_t mHeadMax;
+    size_t mTailMax;
+    std::string mHead;
+    /** last bytes, trimmed to mTailMax when it grew to twice that */
+    std::string mTail;
+    size_t mTotal;
+
+    std::string msFile;
+    int mFd;
+    size_t mFileMax;
+    size_t mFileBytes;
+
+    std::string msExpected;
+    size_t mMatched;
+    bool mbMismatch;
+
+    //coverity
+    COutputCapture(COutputCapture const&) = delete;
+    void operator=(COutputCapture const&) = delete;
+
+    void spill(std::string_view chunk);
+
+public:
+    /** headBytes, tailBytes - bytes kept of the start and the end */
+    COutputCapture(size_t headBytes, size_t tailBytes);
+    ~COutputCapture();
+
+    /**
+     * writes the complete output to sFile as well.
+     * @param maxFileBytes the file is moved to <sFile>.1 when it reaches this size, 0 for no limit.
+     * @return false if the file cannot be created.
+     */
+    bool spillTo(const std::string& sFile, size_t maxFileBytes);
+
+    /** compares the output with sExpected, see matched(); the head keeps at least its size */
+    void expect(const std::string& sExpected);
+
+    /** consumes a chunk of output */
+    void write(std::string_view chunk);
+
+    /** the output if it was kept completely, else head, a note of the dropped bytes and tail */
+    std::string text() const;
+
+    /** the complete output equals the expected value */
+    bool matched() const;
+
+    /** bytes of output seen */
+    size_t total() const;
+};
@@ -19,7 +19,27 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
+#include <map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "taskExecutor.h"
+
+/** framework/plugin interface version, bump on incompatible interface changes */
+#define PLUGIN_ABI_VERSION 3
+
+/** pipeline artifacts - results handed from one plugin to the next in memory.
+ *  artifacts are named after the file they replace; plugins look up an artifact
+ *  before reading that file and publish to it instead of (or besides) writing it.
+ */
+#define ARTIFACT_PLATFORM_SNAPSHOT "platform-snapshot.json"
+#define ARTIFACT_GAP_REPORT "gap_report.json"
+/** request key: also write the artifact to disk when running in a pipeline */
+#define ARTIFACT_SAVE "save"
+
+typedef std::map<std::string, nlohmann::json> artifacts_t;
 
     /** any communication from framework to plugins */
 class CProgramContext {
@@ -27,6 +47,9 @@ public:
       std::string version;/*framework*/
       std::string configPath;
       int log_level; // 0[emergency] - 7[debug]
+      artifacts_t *pArtifacts = NULL; // set while a pipeline runs, NULL otherwise
+      CTaskExecutor *pExecutor = NULL; // framework thread pool, run parallel work here
+      const std::atomic<bool> *pCancel = NULL; // true once the request in flight is cancelled, reset by the framework before it starts (abi 3)
       
       /*std::string tojsonString() {
         return "";
@@ -64,9 +87,108 @@ public:
   /** returns capabilities structure in json format */
   virtual std::string getInfo(void* pIn_Context) = 0;
   
+  /** stop the running request; called from another thread while entry runs,
+   *  sRequest is the request being cancelled. must return without waiting.
+   */
   virtual void cancel(void* pIn_Context, std::string sRequest) = 0;
 };
 
+/** receives the response of a request; implemented by the framework.
+ *  the sink decides where the response goes (console, socket, pipeline) and
+ *  serializes it only there, plugins never build the response string.
+ */
+class CResponseSink {
+public:
+  virtual ~CResponseSink() = default;
+
+  /** hand over the complete response */
+  virtual void write(nlohmann::json&& jResponse) = 0;
+
+  /** true if the consumer takes large results piece by piece through writeChunk.
+   *  plugins only emit chunks if this is set, otherwise they respond as a whole.
+   */
+  virtual bool isStreaming() const { return false; }
+
+  /** hand over one part of a large result, before the final write.
+   *  blocks until the consumer has taken it (backpressure); returns false if the
+   *  consumer is gone, the plugin should stop producing then.
+   */
+  virtual bool writeChunk(nlohmann::json&& jChunk) { (void)jChunk; return false; }
+
+  /** progress of a running request, e.g. {"step": 3, "total": 12, "action": "INSTALL"}.
+   *  may be called from a worker thread; ignored unless the consumer wants it.
+   */
+  virtual void writeProgress(nlohmann::json&& jProgress) { (void)jProgress; }
+};
+
+/** keeps the response in memory */
+class CBufferedResponseSink : public CResponseSink {
+public:
+  nlohmann::json jResponse;
+
+  void write(nlohmann::json&& jIn) override {
+    jResponse = std::move(jIn);
+  }
+};
+
+/** version 2 interface - request arrives parsed, response goes to a sink.
+ *  plugins export create_v2 besides create; the framework probes for it.
+ */
+class CPluginInterfaceV2 : public CPluginInterface {
+public:
+  /** called everytime user requests*/
+  virtual void entryV2(void* pIn_Context, const nlohmann::json& jRequest, CResponseSink& sink) = 0;
+
+  /** version 1 entry, for frameworks without version 2 support */
+  std::string entry(void* pIn_Context, std::string sRequest) override {
+    nlohmann::json jRequest = nlohmann::json::parse(sRequest, nullptr, false);
+    if (jRequest.is_discarded()) {
+      return "{\"status\":\"failure\",\"desc\":\"Invalid Request\"}";
+    }
+    CBufferedResponseSink sink;
+    entryV2(pIn_Context, jRequest, sink);
+    return sink.jResponse.dump();
+  }
+};
+
 // class factories
 typedef CPluginInterface* create_t();
 typedef void destroy_t(CPluginInterface*);
+typedef CPluginInterfaceV2* create_v2_t();
+/** optional, plugins without it are treated as abi version 0 */
+typedef int abi_version_t();
+
+/** plugin linked into the executable (BUILTIN_PLUGINS build) instead of loaded from lib/ */
+struct stBuiltinPlugin {
+  const char* name; // as returned by getInfo
+  create_t* create;
+  destroy_t* destroy;
+  create_v2_t* create_v2;
+  abi_version_t* abi_version;
+};
+
+/** built-in plugins, filled before main runs */
+inline std::vector<stBuiltinPlugin>& builtinPlugins() {
+  static std::vector<stBuiltinPlugin> vPlugins;
+  return vPlugins;
+}
+
+class CBuiltinPluginRegistrar {
+public:
+  explicit CBuiltinPluginRegistrar(const stBuiltinPlugin& plugin) {
+    builtinPlugins().push_back(plugin);
+  }
+};
+
+/** factories are exported for dlopen, or kept file local and registered when
+ *  the plugin is linked into the executable. put REGISTER_BUILTIN_PLUGIN after
+ *  the factories, without semicolon.
+ */
+#ifdef BUILTIN_PLUGIN
+#define PLUGIN_FACTORY [[maybe_unused]] static
+#define REGISTER_BUILTIN_PLUGIN(sName) \
+  static CBuiltinPluginRegistrar gBuiltinPluginRegistrar({sName, create, destroy, create_v2, abi_version});
+#else
+#define PLUGIN_FACTORY extern "C"
+#define REGISTER_BUILTIN_PLUGIN(sName)
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+/** option of the tool executable that runs it as privileged helper */
+#define PRIVILEGED_HELPER_OPTION "--privileged-helper"
+
+/**
+ * Privileged helper: the tool executable started once through sudo, so sudo is
+ * authenticated once instead of for every command. It is connected to its stdin
+ * and stdout over a socketpair and runs one command per json request line:
+ *   {"args": ["apt-get", "install", "-y", "x"], "timeout_ms": 0, "max_output": 0}
+ * and answers with a json line holding the stProcessResult; with "stream": true
+ * the output comes before it as "chunk <size>" lines followed by the bytes.
+ * "sched" (nice, io_class, io_level, idle) is the stSchedPolicy of the command. The client stops
+ * the running command with SIGUSR1 (sudo relays it) and the helper with end of file.
+ */
+class CPrivilegedHelper {
+
+private:
+    pid_t mPid;
+    int mFd;
+    /** commands are replayed from a trace, no helper process */
+    bool mbReplay;
+    /** received, not yet parsed */
+    std::string mBuffer;
+
+    //coverity
+    CPrivilegedHelper(CPrivilegedHelper const&) = delete;
+    void operator=(CPrivilegedHelper const&) = delete;
+
+    /** reads what arrived into mBuffer, signals the helper while pCancel is set; false on end of file */
+    bool receive(const std::atomic<bool>* pCancel);
+
+    /** reads the next line; false on end of file */
+    bool readLine(std::string& sLine, const std::atomic<bool>* pCancel);
+
+public:
+    CPrivilegedHelper();
+
+    /** stops the helper */
+    ~CPrivilegedHelper();
+
+    /**
+     * starts the helper, with sudo unless the process is root already.
+     * sudo may ask for the password on the terminal.
+     * @param pCancel stops waiting for the helper, may be NULL.
+     * @param bAskPassword false: sudo -n, the helper only starts if sudo needs no password.
+     * @return true once the helper is ready.
+     */
+    bool start(const std::atomic<bool>* pCancel = NULL, bool bAskPassword = true);
+
+    bool isRunning() const;
+
+    /**
+     * runs vArgs as root. stProcessOptions::bCapture, bClearEnv and onLine do not
+     * apply, the environment is the one of sudo; onOutput streams the output.
+     * @return the result, not started if the helper is gone.
+     */
+    stProcessResult run(const std::vector<std::string>& vArgs, const stProcessOptions& options = stProcessOptions());
+
+    /** ends the helper and waits for it */
+    void stop();
+
+    /** the helper side, run by main for PRIVILEGED_HELPER_OPTION; returns the exit code */
+    static int serve();
+};
+
+/**
+ * Privileged helpers of a deployment, one per action that runs at the same
+ * time. A helper runs one command at a time, so the pool starts another one
+ * while all are busy, up to setMax(). The first one may ask for the password,
+ * the others start with sudo -n once it is authenticated; if one of them does
+ * not start, the commands wait for the helpers already running.
+ */
+class CPrivilegedHelperPool {
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    /** helpers not running a command */
+    std::vector<CPrivilegedHelper*> mIdle;
+    /** helpers running or being started */
+    size_t mStarted;
+    size_t mMax;
+    /** the first helper did not start, commands use sudo each */
+    bool mbFailed;
+    /** the first helper runs, sudo is authenticated */
+    std::atomic<bool> mbReady;
+
+    //coverity
+    CPrivilegedHelperPool(CPrivilegedHelperPool const&) = delete;
+    void operator=(CPrivilegedHelperPool const&) = delete;
+
+    /** an idle or newly started helper, NULL if none can be started */
+    CPrivilegedHelper* acquire(const std::atomic<bool>* pCancel);
+    void release(CPrivilegedHelper* pHelper);
+
+public:
+    CPrivilegedHelperPool();
+
+    /** stop() */
+    ~CPrivilegedHelperPool();
+
+    /** most helpers started, at least 1 */
+    void setMax(size_t max);
+
+    /**
+     * runs vArgs as root in a helper, see CPrivilegedHelper::run.
+     * @param result receives the result.
+     * @return false if no helper can be started, the command did not run.
+     */
+    bool run(const std::vector<std::string>& vArgs, const stProcessOptions& options, stProcessResult& result);
+
+    /** true once a helper started, without waiting for the pool */
+    bool isReady() const { return mbReady; }
+
+    /** number of helpers started, for the report */
+    size_t started();
+
+    /** ends the helpers not running a command */
+    void stop();
+};
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** I/O scheduling classes of ioprio_set(2) */
+#define PROCESS_IO_CLASS_NONE 0
+#define PROCESS_IO_CLASS_REALTIME 1
+#define PROCESS_IO_CLASS_BEST_EFFORT 2
+#define PROCESS_IO_CLASS_IDLE 3
+
+/** CPU and I/O priority a child starts with, lower priority than the tool only */
+struct stSchedPolicy {
+    int nice = 0;               //added to the nice value of the tool, 0 .. 19
+    int ioClass = PROCESS_IO_CLASS_NONE;    //PROCESS_IO_CLASS_*, NONE keeps the tool's
+    int ioLevel = 4;            //0 (highest) .. 7, for REALTIME and BEST_EFFORT
+    bool bIdle = false;         //SCHED_IDLE, runs only when a cpu has nothing else to do
+
+    bool isSet() const { return nice != 0 || ioClass != PROCESS_IO_CLASS_NONE || bIdle; }
+};
+
+/** Outcome of a child process, filled from wait4(). */
+struct stProcessResult {
+    bool bStarted = false;      //spawn succeeded
+    bool bCancelled = false;    //stopped through the cancel flag
+    bool bTimedOut = false;     //stopped after stProcessOptions::timeoutMs
+    bool bTruncated = false;    //output beyond stProcessOptions::maxOutput was dropped
+    int exitCode = -1;          //exit status, -1 if the process did not exit
+    int signal = 0;             //signal that terminated the process, 0 if none
+    long spawnUs = 0;           //time spent in posix_spawn
+    long wallMs = 0;            //spawn to reap
+    long userCpuMs = 0;
+    long systemCpuMs = 0;
+    long maxRssKb = 0;          //peak resident set size of the child
+    bool bSchedApplied = false; //stProcessOptions::sched was set and is in effect for the child
+    std::string output;         //stdout and stderr, when captured and not streamed
+
+    /** started, not stopped and exited with 0 */
+    bool succeeded() const { return bStarted && !bCancelled && !bTimedOut && exitCode == 0; }
+};
+
+/** How a child process is started. */
+struct stProcessOptions {
+    /** collect stdout and stderr in stProcessResult::output, else they are inherited */
+    bool bCapture = true;
+    /** start the child with an empty environment */
+    bool bClearEnv = false;
+    /** if set, the child (its own process group) is stopped once the flag turns true */
+    const std::atomic<bool>* pCancel = NULL;
+    /** wall clock limit, the child (its own process group) is stopped after it; 0 for none */
+    long timeoutMs = 0;
+    /** bytes of output kept, the rest is read and dropped; 0 for no limit.
+     *  with onLine the limit is the length of a line */
+    size_t maxOutput = 0;
+    /** if set, the output is streamed: called for every line (without the newline)
+     *  as it arrives, instead of collecting it. runs on the thread waiting for the child */
+    std::function<void(std::string_view)> onLine;
+    /** if set (and onLine is not), the output is streamed in chunks as it is read,
+     *  instead of collecting it. runs on the thread waiting for the child */
+    std::function<void(std::string_view)> onOutput;
+    /** priority of the child, in effect before it execs */
+    stSchedPolicy sched;
+};
+
+/**
+ * Process launch layer. Children are started with posix_spawn, which does not
+ * copy the page tables of the parent, so the cost of a spawn does not grow with
+ * the memory the tool holds; they are reaped with wait4 for status and usage.
+ * CProcess runs a single command, CProcessMux many at once.
+ */
+class CProcess {
+
+public:
+    /** runs vArgs[0] (searched in PATH) with the arguments vArgs */
+    static stProcessResult run(const std::vector<std::string>& vArgs, const stProcessOptions& options = stProcessOptions());
+
+    /** runs sCommand with /bin/sh -c */
+    static stProcessResult runShell(const std::string& sCommand, const stProcessOptions& options = stProcessOptions());
+};
+
+/**
+ * Runs many children at once from the calling thread. Their output is drained
+ * with epoll into growable buffers; timeouts, cancel and the kill grace period
+ * are handled in the same loop. A stopped child gets SIGTERM and, if it is still
+ * running after the grace period, SIGKILL - sent to its process group.
+ */
+class CProcessMux {
+
+private:
+    struct stChild;
+
+    std::vector<std::unique_ptr<stChild>> mChildren;
+    size_t mMaxRunning;
+    size_t mRunning;
+    size_t mNextPending;
+    int mEpoll;
+
+    //coverity
+    CProcessMux(CProcessMux const&) = delete;
+    void operator=(CProcessMux const&) = delete;
+
+    void start(size_t id);
+    void replay(stChild& child);
+    void drain(stChild& child);
+    void check(stChild& child);
+    void finish(stChild& child);
+    int nextWaitMs();
+
+public:
+    /** maxRunning - children running at the same time, the others wait; 0 for no limit */
+    explicit CProcessMux(size_t maxRunning = 0);
+
+    /** kills and reaps children still running */
+    ~CProcessMux();
+
+    /**
+     * starts vArgs[0] (searched in PATH) with the arguments vArgs,
+     * or queues it while maxRunning children are running.
+     * @return id of the command for result()
+     */
+    size_t add(const std::vector<std::string>& vArgs, const stProcessOptions& options = stProcessOptions());
+
+    /** starts sCommand with /bin/sh -c */
+    size_t addShell(const std::string& sCommand, const stProcessOptions& options = stProcessOptions());
+
+    /** runs until all queued commands have finished */
+    void wait();
+
+    /** result of a command, complete after wait() */
+    stProcessResult& result(size_t id);
+
+    size_t size() const;
+};
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "process.h"
+
+/** record every command of the process layer to this file */
+#define PROCESS_TRACE_RECORD_ENV "FLOW_TOOL_TRACE_RECORD"
+/** serve the commands of the process layer from this file instead of running them */
+#define PROCESS_TRACE_REPLAY_ENV "FLOW_TOOL_TRACE_REPLAY"
+/** "zero" answers replayed commands at once, else they take their recorded wall time */
+#define PROCESS_TRACE_LATENCY_ENV "FLOW_TOOL_TRACE_LATENCY"
+
+/**
+ * Record and replay of the commands run through the process layer, for
+ * benchmarks and reproductions without root, packages or the target system.
+ * The mode is taken from the environment on first use.
+ *
+ * A trace is a sequence of records, each a 4 byte little endian length and a
+ * CBOR map with the argv, the outcome, the timing and the raw output. Records
+ * are appended, several processes or plugin libraries can write one trace.
+ * A replayed command is found by its argv; a command run more often than
+ * recorded gets its last recorded outcome again.
+ */
+class CProcessTrace {
+
+public:
+    static bool isRecording();
+    static bool isReplaying();
+
+    /** replayed commands complete without their recorded wall time */
+    static bool isZeroLatency();
+
+    /** appends a command, its outcome and its complete output to the trace */
+    static void record(const std::vector<std::string>& vArgs, const stProcessResult& result, const std::string& sOutput);
+
+    /**
+     * @param result receives the recorded outcome, output stays empty.
+     * @param sOutput receives the recorded output.
+     * @return false if the command is not in the trace.
+     */
+    static bool replay(const std::vector<std::string>& vArgs, stProcessResult& result, std::string& sOutput);
+
+    /** neither records nor replays in this process, for the privileged helper */
+    static void disable();
+};
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+/** task priorities, a lower value runs first */
+#define TASK_PRIORITY_HIGH 0
+#define TASK_PRIORITY_NORMAL 1
+#define TASK_PRIORITY_LOW 2
+#define TASK_PRIORITY_COUNT 3
+
+/** interval a waiting task group looks for work again (ms) */
+#define TASK_GROUP_WAIT_MS 10
+
+/** thread pool owned by the framework, handed to plugins in CProgramContext.
+ *  all parallel work of the process goes through it so small machines are
+ *  not oversubscribed; plugins use it through CTaskGroup.
+ */
+class CTaskExecutor {
+public:
+  virtual ~CTaskExecutor() = default;
+
+  /** queue a task */
+  virtual void submit(std::function<void()> task, int priority) = 0;
+
+  /** run one queued task if the calling thread is a worker of this executor.
+   *  returns false if nothing was run.
+   */
+  virtual bool runPendingTask() = 0;
+
+  /** number of worker threads */
+  virtual size_t concurrency() const = 0;
+};
+
+/** tasks that are waited for together.
+ *  without executor the tasks run right away in run(), so plugins work the
+ *  same with frameworks that do not provide one.
+ */
+class CTaskGroup {
+private:
+  CTaskExecutor* mpExecutor;
+  int mPriority;
+  const std::atomic<bool>* mpCancelRequest;
+  std::atomic<bool> mbCancel {false};
+
+  std::mutex mMutex;
+  std::condition_variable mCond;
+  size_t mPending = 0;
+  bool mbFailed = false;
+
+  //coverity
+  CTaskGroup(CTaskGroup const&) = delete;
+  void operator=(CTaskGroup const&) = delete;
+
+  void execute(const std::function<void()>& task) {
+    bool bFailed = false;
+    if (!isCancelled()) {
+      try {
+        task();
+      } catch (...) {
+        bFailed = true;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mbFailed = mbFailed || bFailed;
+    if (--mPending == 0) {
+      mCond.notify_all();
+    }
+  }
+
+public:
+  /** pCancelRequest - optional flag that cancels the group as well */
+  explicit CTaskGroup(CTaskExecutor* pExecutor, int priority = TASK_PRIORITY_NORMAL,
+                      const std::atomic<bool>* pCancelRequest = NULL)
+    : mpExecutor(pExecutor), mPriority(priority), mpCancelRequest(pCancelRequest) {}
+
+  ~CTaskGroup() {
+    wait();
+  }
+
+  /** add a task; tasks not started yet are skipped once the group is cancelled */
+  void run(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mPending++;
+    }
+    if (!mpExecutor) {
+      execute(task);
+      return;
+    }
+    mpExecutor->submit([this, task = std::move(task)]() { execute(task); }, mPriority);
+  }
+
+  /** wait for all tasks; a worker thread runs queued tasks meanwhile.
+   *  returns false if a task threw or the group was cancelled.
+   */
+  bool wait() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mPending > 0) {
+      lock.unlock();
+      bool bRan = mpExecutor && mpExecutor->runPendingTask();
+      lock.lock();
+      if (!bRan) {
+        mCond.wait_for(lock, std::chrono::milliseconds(TASK_GROUP_WAIT_MS), [this] { return mPending == 0; });
+      }
+    }
+    return !mbFailed && !isCancelled();
+  }
+
+  /** running tasks check isCancelled themselves */
+  void cancel() { mbCancel = true; }
+
+  bool isCancelled() const {
+    return mbCancel || (mpCancelRequest && *mpCancelRequest);
+  }
+};
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "outputCapture.h"
+
+COutputCapture::COutputCapture(size_t headBytes, size_t tailBytes) {
+    mHeadMax = headBytes;
+    mTailMax = tailBytes;
+    mTotal = 0;
+    mFd = -1;
+    mFileMax = 0;
+    mFileBytes = 0;
+    mMatched = 0;
+    mbMismatch = false;
+}
+
+COutputCapture::~COutputCapture() {
+    if (mFd != -1) {
+        close(mFd);
+    }
+}
+
+bool COutputCapture::spillTo(const std::string& sFile, size_t maxFileBytes) {
+    if (mFd != -1) {
+        close(mFd);
+    }
+    msFile = sFile;
+    mFileMax = maxFileBytes;
+    mFileBytes = 0;
+    mFd = open(sFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (mFd == -1) {
+        std::cout << "output file not created: " << sFile << " " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void COutputCapture::expect(const std::string& sExpected) {
+    msExpected = sExpected;
+    mMatched = 0;
+    mbMismatch = false;
+    if (mHeadMax < sExpected.size()) {
+        mHeadMax = sExpected.size();
+    }
+}
+
+void COutputCapture::spill(std::string_view chunk) {
+    if (mFileMax != 0 && mFileBytes + chunk.size() > mFileMax && mFileBytes > 0) {
+        close(mFd);
+        std::error_code ec;
+        std::filesystem::rename(msFile, msFile + ".1", ec);
+        mFileBytes = 0;
+        mFd = open(msFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (mFd == -1) {
+            return;
+        }
+    }
+    const char* pData = chunk.data();
+    size_t size = chunk.size();
+    while (size > 0) {
+        ssize_t num_bytes = ::write(mFd, pData, size);
+        if (num_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num_bytes <= 0) {
+            std::cout << "output file not written: " << msFile << std::endl;
+            close(mFd);
+            mFd = -1;
+            return;
+        }
+        pData += num_bytes;
+        size -= (size_t)num_bytes;
+        mFileBytes += (size_t)num_bytes;
+    }
+}
+
+void COutputCapture::write(std::string_view chunk) {
+    mTotal += chunk.size();
+
+    if (!mbMismatch) {
+        if (mMatched + chunk.size() > msExpected.size() ||
+            memcmp(msExpected.data() + mMatched, chunk.data(), chunk.size()) != 0) {
+            mbMismatch = true;
+        } else {
+            mMatched += chunk.size();
+        }
+    }
+
+    if (mFd != -1) {
+        spill(chunk);
+    }
+
+    size_t head = std::min(chunk.size(), mHeadMax - mHead.size());
+    mHead.append(chunk.data(), head);
+    chunk.remove_prefix(head);
+    if (!chunk.empty() && mTailMax > 0) {
+        if (chunk.size() >= mTailMax) {
+            mTail.assign(chunk.data() + chunk.size() - mTailMax, mTailMax);
+        } else {
+            mTail.append(chunk.data(), chunk.size());
+            if (mTail.size() >= 2 * mTailMax) {
+                mTail.erase(0, mTail.size() - mTailMax);
+            }
+        }
+    }
+}
+
+std::string COutputCapture::text() const {
+    size_t tail = std::min(mTail.size(), mTailMax);
+    size_t dropped = mTotal - mHead.size() - tail;
+    if (dropped == 0) {
+        return mHead + mTail;
+    }
+    return mHead + "\n[... " + std::to_string(dropped) + " bytes not kept ...]\n" + mTail.substr(mTail.size() - tail);
+}
+
+bool COutputCapture::matched() const {
+    return !mbMismatch && mMatched == msExpected.size();
+}
+
+size_t COutputCapture::total() const {
+    return mTotal;
+}
@@ -0,0 +1,455 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <algorithm>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include "privilegedHelper.h"
+#include "processTrace.h"
+
+extern char **environ;
+
+/** how often a waiting client checks for cancellation (ms) */
+#define PRIVILEGED_HELPER_POLL_MS 100
+
+/** set by SIGUSR1 (client cancel), SIGINT and SIGTERM in the helper */
+static std::atomic<bool> gHelperCancel(false);
+
+static void helperSignalHandler(int signum) {
+    (void)signum;
+    gHelperCancel = true;
+}
+
+/** writes all of sData; no SIGPIPE on a socket, the helper side may be a pipe of sudo */
+static bool writeAll(int fd, const std::string& sData) {
+    size_t offset = 0;
+    bool bSocket = true;
+    while (offset < sData.size()) {
+        ssize_t num_bytes;
+        if (bSocket) {
+            num_bytes = send(fd, sData.data() + offset, sData.size() - offset, MSG_NOSIGNAL);
+            if (num_bytes < 0 && errno == ENOTSOCK) {
+                bSocket = false;
+                continue;
+            }
+        } else {
+            num_bytes = write(fd, sData.data() + offset, sData.size() - offset);
+        }
+        if (num_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num_bytes <= 0) {
+            return false;
+        }
+        offset += (size_t)num_bytes;
+    }
+    return true;
+}
+
+/** splits the first line off sBuffer */
+static bool takeLine(std::string& sBuffer, std::string& sLine) {
+    size_t pos = sBuffer.find('\n');
+    if (pos == std::string::npos) {
+        return false;
+    }
+    sLine = sBuffer.substr(0, pos);
+    sBuffer.erase(0, pos + 1);
+    return true;
+}
+
+CPrivilegedHelper::CPrivilegedHelper() {
+    mPid = -1;
+    mFd = -1;
+    mbReplay = false;
+}
+
+CPrivilegedHelper::~CPrivilegedHelper() {
+    stop();
+}
+
+bool CPrivilegedHelper::isRunning() const {
+    return mFd != -1 || mbReplay;
+}
+
+bool CPrivilegedHelper::start(const std::atomic<bool>* pCancel, bool bAskPassword) {
+    if (isRunning()) {
+        return true;
+    }
+    //the commands were recorded as run by the helper, served from the trace here
+    if (CProcessTrace::isReplaying()) {
+        mbReplay = true;
+        return true;
+    }
+
+    char sExe[PATH_MAX] = {0};
+    ssize_t len = readlink("/proc/self/exe", sExe, sizeof(sExe) - 1);
+    if (len <= 0) {
+        return false;
+    }
+    sExe[len] = '\0';
+
+    std::vector<std::string> vArgs;
+    if (geteuid() != 0) {
+        vArgs = {"sudo"};
+        if (!bAskPassword) {
+            vArgs.push_back("-n");
+        }
+        vArgs.push_back("--");
+    }
+    vArgs.push_back(sExe);
+    vArgs.push_back(PRIVILEGED_HELPER_OPTION);
+    std::vector<char*> argv;
+    for (const auto& sArg : vArgs) {
+        argv.push_back((char *)sArg.c_str());
+    }
+    argv.push_back(NULL);
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == -1) {
+        return false;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, sv[1], 0);
+    posix_spawn_file_actions_adddup2(&actions, sv[1], 1);
+    int err = posix_spawnp(&mPid, argv[0], &actions, NULL, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(sv[1]);
+
+    if (err != 0) {
+        std::cout << "couldn't start privileged helper" << std::endl;
+        close(sv[0]);
+        mPid = -1;
+        return false;
+    }
+    mFd = sv[0];
+
+    //the helper answers once it is running, after sudo authenticated
+    std::string sLine;
+    if (!readLine(sLine, pCancel) || (pCancel && *pCancel)) {
+        std::cout << "privileged helper not available" << std::endl;
+        stop();
+        return false;
+    }
+    return true;
+}
+
+bool CPrivilegedHelper::receive(const std::atomic<bool>* pCancel) {
+    char buf[65536];
+    while (true) {
+        struct pollfd pfd = {mFd, POLLIN, 0};
+        int ready = poll(&pfd, 1, PRIVILEGED_HELPER_POLL_MS);
+        if (pCancel && *pCancel && mPid > 0) {
+            kill(mPid, SIGUSR1); //repeated until the answer arrives, none gets lost
+        }
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            continue;
+        }
+        ssize_t num_bytes = read(mFd, buf, sizeof(buf));
+        if (num_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num_bytes <= 0) {
+            return false;
+        }
+        mBuffer.append(buf, (size_t)num_bytes);
+        return true;
+    }
+}
+
+bool CPrivilegedHelper::readLine(std::string& sLine, const std::atomic<bool>* pCancel) {
+    while (!takeLine(mBuffer, sLine)) {
+        if (!receive(pCancel)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+stProcessResult CPrivilegedHelper::run(const std::vector<std::string>& vArgs, const stProcessOptions& options) {
+    stProcessResult result;
+    if (!isRunning() || vArgs.empty()) {
+        return result;
+    }
+    if (mbReplay) {
+        return CProcess::run(vArgs, options);
+    }
+    //the helper does not record, its commands are recorded here
+    bool bRecord = CProcessTrace::isRecording();
+    std::string sTraceOutput;
+
+    nlohmann::json jRequest;
+    jRequest["args"] = vArgs;
+    jRequest["timeout_ms"] = options.timeoutMs;
+    jRequest["max_output"] = options.maxOutput;
+    jRequest["stream"] = (bool)options.onOutput;
+    if (options.sched.isSet()) {
+        jRequest["sched"] = {{"nice", options.sched.nice}, {"io_class", options.sched.ioClass},
+                             {"io_level", options.sched.ioLevel}, {"idle", options.sched.bIdle}};
+    }
+    std::string sLine;
+    bool bAnswer = writeAll(mFd, jRequest.dump() + "\n") && readLine(sLine, options.pCancel);
+    //streamed output: "chunk <size>" lines, each followed by the bytes
+    while (bAnswer && sLine.compare(0, 6, "chunk ") == 0) {
+        size_t size = std::stoul(sLine.substr(6));
+        while (bAnswer && mBuffer.size() < size) {
+            bAnswer = receive(options.pCancel);
+        }
+        if (bAnswer) {
+            options.onOutput(std::string_view(mBuffer.data(), size));
+            if (bRecord) {
+                sTraceOutput.append(mBuffer.data(), size);
+            }
+            mBuffer.erase(0, size);
+            bAnswer = readLine(sLine, options.pCancel);
+        }
+    }
+    if (!bAnswer) {
+        std::cout << "privileged helper exited" << std::endl;
+        stop();
+        return result;
+    }
+
+    try {
+        nlohmann::json jResult = nlohmann::json::parse(sLine);
+        result.bStarted = jResult.value("started", false);
+        result.bCancelled = jResult.value("cancelled", false);
+        result.bTimedOut = jResult.value("timed_out", false);
+        result.bTruncated = jResult.value("truncated", false);
+        result.exitCode = jResult.value("exit_code", -1);
+        result.signal = jResult.value("signal", 0);
+        result.spawnUs = jResult.value("spawn_us", 0L);
+        result.wallMs = jResult.value("wall_ms", 0L);
+        result.userCpuMs = jResult.value("user_cpu_ms", 0L);
+        result.systemCpuMs = jResult.value("system_cpu_ms", 0L);
+        result.maxRssKb = jResult.value("max_rss_kb", 0L);
+        result.bSchedApplied = jResult.value("sched_applied", false);
+        result.output = jResult.value("output", std::string());
+    } catch (const std::exception& e) {
+        std::cout << "invalid privileged helper answer: " << e.what() << std::endl;
+    }
+    if (bRecord) {
+        CProcessTrace::record(vArgs, result, options.onOutput ? sTraceOutput : result.output);
+    }
+    return result;
+}
+
+void CPrivilegedHelper::stop() {
+    mbReplay = false;
+    if (mFd != -1) {
+        close(mFd); //end of file ends the helper
+        mFd = -1;
+    }
+    if (mPid > 0) {
+        while (waitpid(mPid, NULL, 0) == -1 && errno == EINTR) {
+        }
+        mPid = -1;
+    }
+    mBuffer.clear();
+}
+
+CPrivilegedHelperPool::CPrivilegedHelperPool() {
+    mStarted = 0;
+    mMax = 1;
+    mbFailed = false;
+    mbReady = false;
+}
+
+CPrivilegedHelperPool::~CPrivilegedHelperPool() {
+    stop();
+}
+
+void CPrivilegedHelperPool::setMax(size_t max) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMax = std::max<size_t>(max, 1);
+}
+
+CPrivilegedHelper* CPrivilegedHelperPool::acquire(const std::atomic<bool>* pCancel) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mbFailed) {
+        if (!mIdle.empty()) {
+            CPrivilegedHelper* pHelper = mIdle.back();
+            mIdle.pop_back();
+            return pHelper;
+        }
+        //more helpers only once sudo authenticated for the first, so they do not ask again
+        bool bFirst = mStarted == 0;
+        if (bFirst || (mbReady && mStarted < mMax)) {
+            mStarted++;
+            lock.unlock();
+            CPrivilegedHelper* pHelper = new CPrivilegedHelper();
+            bool bRunning = pHelper->start(pCancel, bFirst);
+            lock.lock();
+            if (bRunning) {
+                mbReady = true;
+                mCond.notify_all();
+                return pHelper;
+            }
+            delete pHelper;
+            mStarted--;
+            if (bFirst) {
+                std::cout << "privileged helper not started, running commands with sudo" << std::endl;
+                mbFailed = true;
+            } else {
+                mMax = mStarted; //sudo -n refused, the running helpers take the commands
+            }
+            mCond.notify_all();
+            continue;
+        }
+        mCond.wait(lock);
+    }
+    return NULL;
+}
+
+void CPrivilegedHelperPool::release(CPrivilegedHelper* pHelper) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (pHelper->isRunning()) {
+        mIdle.push_back(pHelper);
+    } else {
+        delete pHelper; //exited, another one is started when needed
+        mStarted--;
+        mbReady = mStarted > 0;
+    }
+    mCond.notify_one();
+}
+
+bool CPrivilegedHelperPool::run(const std::vector<std::string>& vArgs, const stProcessOptions& options,
+                                stProcessResult& result) {
+    CPrivilegedHelper* pHelper = acquire(options.pCancel);
+    if (!pHelper) {
+        return false;
+    }
+    result = pHelper->run(vArgs, options);
+    release(pHelper);
+    return true;
+}
+
+size_t CPrivilegedHelperPool::started() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStarted;
+}
+
+void CPrivilegedHelperPool::stop() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (CPrivilegedHelper* pHelper : mIdle) {
+        delete pHelper;
+    }
+    mStarted -= mIdle.size();
+    mIdle.clear();
+    mbReady = mStarted > 0;
+}
+
+int CPrivilegedHelper::serve() {
+    CProcessTrace::disable();
+    //stdin and stdout are the channel; commands get /dev/null instead
+    int in = fcntl(0, F_DUPFD_CLOEXEC, 3);
+    int out = fcntl(1, F_DUPFD_CLOEXEC, 3);
+    int devnull = open("/dev/null", O_RDWR);
+    if (in == -1 || out == -1 || devnull == -1) {
+        return 1;
+    }
+    dup2(devnull, 0);
+    dup2(devnull, 1);
+    close(devnull);
+
+    struct sigaction action = {};
+    action.sa_handler = helperSignalHandler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (!writeAll(out, "{\"ready\": true}\n")) {
+        return 1;
+    }
+
+    std::string sBuffer;
+    std::string sLine;
+    char buf[4096];
+    while (true) {
+        if (!takeLine(sBuffer, sLine)) {
+            ssize_t num_bytes = read(in, buf, sizeof(buf));
+            if (num_bytes < 0 && errno == EINTR) {
+                continue;
+            }
+            if (num_bytes <= 0) {
+                return 0;
+            }
+            sBuffer.append(buf, (size_t)num_bytes);
+            continue;
+        }
+
+        nlohmann::json jResult;
+        try {
+            nlohmann::json jRequest = nlohmann::json::parse(sLine);
+            stProcessOptions options;
+            options.pCancel = &gHelperCancel;
+            options.timeoutMs = jRequest.value("timeout_ms", 0L);
+            options.maxOutput = jRequest.value("max_output", (size_t)0);
+            if (jRequest.contains("sched")) {
+                const nlohmann::json& jSched = jRequest.at("sched");
+                options.sched.nice = jSched.value("nice", 0);
+                options.sched.ioClass = jSched.value("io_class", PROCESS_IO_CLASS_NONE);
+                options.sched.ioLevel = jSched.value("io_level", 4);
+                options.sched.bIdle = jSched.value("idle", false);
+            }
+            if (jRequest.value("stream", false)) {
+                options.onOutput = [out](std::string_view chunk) {
+                    writeAll(out, "chunk " + std::to_string(chunk.size()) + "\n" + std::string(chunk));
+                };
+            }
+            //a cancel for an earlier command is over, the client repeats it while it waits
+            gHelperCancel = false;
+            stProcessResult result = CProcess::run(jRequest.at("args").get<std::vector<std::string>>(), options);
+
+            jResult["started"] = result.bStarted;
+            jResult["cancelled"] = result.bCancelled;
+            jResult["timed_out"] = result.bTimedOut;
+            jResult["truncated"] = result.bTruncated;
+            jResult["exit_code"] = result.exitCode;
+            jResult["signal"] = result.signal;
+            jResult["spawn_us"] = result.spawnUs;
+            jResult["wall_ms"] = result.wallMs;
+            jResult["user_cpu_ms"] = result.userCpuMs;
+            jResult["system_cpu_ms"] = result.systemCpuMs;
+            jResult["max_rss_kb"] = result.maxRssKb;
+            jResult["sched_applied"] = result.bSchedApplied;
+            jResult["output"] = std::move(result.output);
+        } catch (const std::exception& e) {
+            jResult["started"] = false;
+            jResult["output"] = std::string("invalid request: ") + e.what();
+        }
+        //command output need not be utf-8
+        if (!writeAll(out, jResult.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) + "\n")) {
+            return 1;
+        }
+    }
+}
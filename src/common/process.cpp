@@ -0,0 +1,575 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "process.h"
+#include "processTrace.h"
+
+extern char **environ;
+
+/** how often a running process checks for cancellation (ms) */
+#define PROCESS_CANCEL_POLL_MS 100
+/** time a stopped process gets to exit before it is killed (ms) */
+#define PROCESS_KILL_GRACE_MS 3000
+/** how often an exit is checked without pidfd, on kernels before 5.3 (ms) */
+#define PROCESS_REAP_POLL_MS 5
+/** read size when draining output */
+#define PROCESS_READ_CHUNK 65536
+
+typedef std::chrono::steady_clock::time_point timepoint_t;
+
+struct CProcessMux::stChild {
+    std::vector<std::string> vArgs;
+    stProcessOptions options;
+    stProcessResult result;
+    pid_t pid = -1;
+    int fd = -1;                //read end of the output pipe, -1 once drained
+    int pidfd = -1;             //readable once the child exited, -1 if not supported
+    std::string partial;        //start of the next line, with onLine
+    bool bRunning = false;
+    bool bOwnGroup = false;
+    bool bStopping = false;
+    bool bReplay = false;       //served from the trace, no process
+    timepoint_t start;
+    timepoint_t deadline;       //timeoutMs, or SIGKILL while stopping; end of a replayed command
+    std::string traceOutput;    //complete output, while recording a trace
+};
+
+/**
+ * Lowers the priority of the calling thread. On Linux nice, the I/O priority
+ * and the scheduling policy are per thread, and a child inherits them from the
+ * thread that spawns it.
+ *
+ * @param sched the priority to take.
+ * @return false if one of them could not be set.
+ */
+static bool applySchedPolicy(const stSchedPolicy& sched) {
+    bool bApplied = true;
+    if (sched.nice != 0) {
+        errno = 0;
+        int current = getpriority(PRIO_PROCESS, 0);
+        if (errno != 0 || setpriority(PRIO_PROCESS, 0, current + sched.nice) == -1) {
+            bApplied = false;
+        }
+    }
+    if (sched.ioClass != PROCESS_IO_CLASS_NONE) {
+        //IOPRIO_PRIO_VALUE(class, level), IOPRIO_WHO_PROCESS; 0 is the calling thread
+        int ioprio = (sched.ioClass << 13) | (sched.ioClass == PROCESS_IO_CLASS_IDLE ? 0 : sched.ioLevel);
+        if (syscall(SYS_ioprio_set, 1, 0, ioprio) == -1) {
+            bApplied = false;
+        }
+    }
+    if (sched.bIdle) {
+        struct sched_param param = {};
+        if (sched_setscheduler(0, SCHED_IDLE, &param) == -1) {
+            bApplied = false;
+        }
+    }
+    return bApplied;
+}
+
+static long toMs(const struct timeval& tv) {
+    return (long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static long elapsedMs(timepoint_t from, timepoint_t to) {
+    return (long)std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+/** epoll data: child index and whether the event is for its pidfd */
+static uint64_t eventData(size_t id, bool bPidfd) {
+    return ((uint64_t)id << 1) | (bPidfd ? 1 : 0);
+}
+
+CProcessMux::CProcessMux(size_t maxRunning) {
+    mMaxRunning = maxRunning;
+    mRunning = 0;
+    mNextPending = 0;
+    mEpoll = epoll_create1(EPOLL_CLOEXEC);
+}
+
+CProcessMux::~CProcessMux() {
+    for (auto& pChild : mChildren) {
+        if (pChild->bRunning && !pChild->bReplay) {
+            kill(pChild->bOwnGroup ? -pChild->pid : pChild->pid, SIGKILL);
+            finish(*pChild);
+        }
+    }
+    if (mEpoll != -1) {
+        close(mEpoll);
+    }
+}
+
+size_t CProcessMux::add(const std::vector<std::string>& vArgs, const stProcessOptions& options) {
+    std::unique_ptr<stChild> pChild(new stChild());
+    pChild->vArgs = vArgs;
+    pChild->options = options;
+    mChildren.push_back(std::move(pChild));
+
+    //keep the start order
+    while (mNextPending < mChildren.size() && (mMaxRunning == 0 || mRunning < mMaxRunning)) {
+        start(mNextPending++);
+    }
+    return mChildren.size() - 1;
+}
+
+size_t CProcessMux::addShell(const std::string& sCommand, const stProcessOptions& options) {
+    return add({"/bin/sh", "-c", sCommand}, options);
+}
+
+stProcessResult& CProcessMux::result(size_t id) {
+    return mChildren.at(id)->result;
+}
+
+size_t CProcessMux::size() const {
+    return mChildren.size();
+}
+
+void CProcessMux::start(size_t id) {
+    stChild& child = *mChildren[id];
+    if (child.vArgs.empty() || mEpoll == -1) {
+        return;
+    }
+    if (CProcessTrace::isReplaying()) {
+        replay(child);
+        return;
+    }
+
+    std::vector<char*> argv;
+    for (const auto& sArg : child.vArgs) {
+        argv.push_back((char *)sArg.c_str());
+    }
+    argv.push_back(NULL);
+    char *emptyEnv[] = {NULL};
+
+    //O_CLOEXEC: children spawned by other threads do not hold the write end open
+    int fd[2] = {-1, -1};
+    if (child.options.bCapture && pipe2(fd, O_CLOEXEC) == -1) {
+        std::cout << "couldn't initiate command run" << std::endl;
+        return;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    if (child.options.bCapture) {
+        posix_spawn_file_actions_adddup2(&actions, fd[1], 1);
+        posix_spawn_file_actions_adddup2(&actions, fd[1], 2);
+    }
+    short flags = POSIX_SPAWN_SETSIGMASK;
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    child.bOwnGroup = child.options.pCancel || child.options.timeoutMs > 0;
+    if (child.bOwnGroup) {
+        flags |= POSIX_SPAWN_SETPGROUP; //own process group, stopped as a whole
+        posix_spawnattr_setpgroup(&attr, 0);
+    }
+    posix_spawnattr_setflags(&attr, flags);
+
+    child.start = std::chrono::steady_clock::now();
+    int err = 0;
+    if (child.options.sched.isSet()) {
+        //spawned from a thread of its own that lowers its priority first, posix_spawn
+        //runs no code in the child, and the priority of this thread could not be raised back
+        std::thread spawner([&]() {
+            child.result.bSchedApplied = applySchedPolicy(child.options.sched);
+            err = posix_spawnp(&child.pid, argv[0], &actions, &attr, argv.data(),
+                               child.options.bClearEnv ? emptyEnv : environ);
+        });
+        spawner.join();
+        if (!child.result.bSchedApplied) {
+            std::cout << "priority not lowered for: " << child.vArgs[0] << std::endl;
+        }
+    } else {
+        err = posix_spawnp(&child.pid, argv[0], &actions, &attr, argv.data(), child.options.bClearEnv ? emptyEnv : environ);
+    }
+    child.result.spawnUs = (long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - child.start).count();
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (child.options.bCapture) {
+        close(fd[1]); // close writing end in parent process
+    }
+
+    if (err != 0) {
+        std::cout << "couldn't run command: " << child.vArgs[0] << std::endl;
+        if (child.options.bCapture) {
+            close(fd[0]);
+        }
+        return;
+    }
+    child.result.bStarted = true;
+    child.bRunning = true;
+    mRunning++;
+    if (child.options.timeoutMs > 0) {
+        child.deadline = child.start + std::chrono::milliseconds(child.options.timeoutMs);
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    if (child.options.bCapture) {
+        child.fd = fd[0];
+        fcntl(child.fd, F_SETFL, fcntl(child.fd, F_GETFL) | O_NONBLOCK);
+        event.data.u64 = eventData(id, false);
+        epoll_ctl(mEpoll, EPOLL_CTL_ADD, child.fd, &event);
+    }
+#ifdef SYS_pidfd_open
+    child.pidfd = (int)syscall(SYS_pidfd_open, child.pid, 0);
+    if (child.pidfd != -1) {
+        fcntl(child.pidfd, F_SETFD, FD_CLOEXEC);
+        event.data.u64 = eventData(id, true);
+        epoll_ctl(mEpoll, EPOLL_CTL_ADD, child.pidfd, &event);
+    }
+#endif
+}
+
+/**
+ * Hands the complete lines of a chunk to onLine, keeps the rest for the next
+ * chunk. Lines inside the chunk are not copied.
+ */
+static void splitLines(const char* pData, size_t size, std::string& partial, size_t maxLine,
+                       const std::function<void(std::string_view)>& onLine, bool& bTruncated) {
+    const char* pEnd = pData + size;
+    while (pData < pEnd) {
+        const char* pNewline = (const char*)memchr(pData, '\n', (size_t)(pEnd - pData));
+        if (!pNewline) {
+            size_t rest = (size_t)(pEnd - pData);
+            if (maxLine != 0 && partial.size() + rest > maxLine) {
+                rest = maxLine > partial.size() ? maxLine - partial.size() : 0;
+                bTruncated = true;
+            }
+            partial.append(pData, rest);
+            return;
+        }
+        size_t length = (size_t)(pNewline - pData);
+        if (partial.empty()) {
+            if (maxLine != 0 && length > maxLine) {
+                length = maxLine;
+                bTruncated = true;
+            }
+            onLine(std::string_view(pData, length));
+        } else {
+            if (maxLine != 0 && partial.size() + length > maxLine) {
+                length = maxLine > partial.size() ? maxLine - partial.size() : 0;
+                bTruncated = true;
+            }
+            partial.append(pData, length);
+            onLine(partial);
+            partial.clear();
+        }
+        pData = pNewline + 1;
+    }
+}
+
+/**
+ * Serves a command from the trace: its output goes through the same options as
+ * the output of a process, it completes after its recorded wall time (at once
+ * with zero latency) or when it is cancelled.
+ */
+void CProcessMux::replay(stChild& child) {
+    std::string sOutput;
+    child.start = std::chrono::steady_clock::now();
+    if (!CProcessTrace::replay(child.vArgs, child.result, sOutput)) {
+        std::string sCommand;
+        for (const std::string& sArg : child.vArgs) {
+            sCommand += (sCommand.empty() ? "" : " ") + sArg;
+        }
+        std::cout << "command not in the trace: " << sCommand << std::endl;
+        return;
+    }
+    child.result.bSchedApplied = child.options.sched.isSet();
+    if (child.options.onLine) {
+        splitLines(sOutput.data(), sOutput.size(), child.partial, child.options.maxOutput, child.options.onLine,
+                   child.result.bTruncated);
+        if (!child.partial.empty()) {
+            child.options.onLine(child.partial);
+            child.partial.clear();
+        }
+    } else if (child.options.onOutput) {
+        if (!sOutput.empty()) {
+            child.options.onOutput(sOutput);
+        }
+    } else if (child.options.bCapture) {
+        if (child.options.maxOutput != 0 && sOutput.size() > child.options.maxOutput) {
+            sOutput.resize(child.options.maxOutput);
+            child.result.bTruncated = true;
+        }
+        child.result.output = std::move(sOutput);
+    }
+    child.bReplay = true;
+    child.bRunning = true;
+    mRunning++;
+    child.deadline = child.start;
+    if (!CProcessTrace::isZeroLatency()) {
+        child.deadline += std::chrono::milliseconds(child.result.wallMs);
+    }
+}
+
+/** reads the available output, closes the pipe at end of file */
+void CProcessMux::drain(stChild& child) {
+    char buf[PROCESS_READ_CHUNK]; //streamed or dropped output
+    std::string& output = child.result.output;
+
+    while (child.fd != -1) {
+        size_t maxOutput = child.options.maxOutput;
+        ssize_t num_bytes;
+        const char* pRead = buf;
+        if (child.options.onLine) {
+            num_bytes = read(child.fd, buf, sizeof(buf));
+            if (num_bytes > 0) {
+                splitLines(buf, (size_t)num_bytes, child.partial, maxOutput, child.options.onLine, child.result.bTruncated);
+            } else if (num_bytes == 0 && !child.partial.empty()) {
+                child.options.onLine(child.partial); //last line without newline
+                child.partial.clear();
+            }
+        } else if (child.options.onOutput) {
+            num_bytes = read(child.fd, buf, sizeof(buf));
+            if (num_bytes > 0) {
+                child.options.onOutput(std::string_view(buf, (size_t)num_bytes));
+            }
+        } else if (maxOutput == 0 || output.size() < maxOutput) {
+            size_t size = output.size();
+            size_t chunk = PROCESS_READ_CHUNK;
+            if (maxOutput != 0 && maxOutput - size < chunk) {
+                chunk = maxOutput - size;
+            }
+            output.resize(size + chunk);
+            num_bytes = read(child.fd, &output[size], chunk);
+            output.resize(size + (num_bytes > 0 ? (size_t)num_bytes : 0));
+            pRead = output.data() + size;
+        } else {
+            num_bytes = read(child.fd, buf, sizeof(buf));
+            if (num_bytes > 0) {
+                child.result.bTruncated = true;
+            }
+        }
+        if (num_bytes > 0 && CProcessTrace::isRecording()) {
+            child.traceOutput.append(pRead, (size_t)num_bytes);
+        }
+
+        if (num_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num_bytes < 0 && errno == EAGAIN) {
+            return;
+        }
+        if (num_bytes <= 0) {
+            epoll_ctl(mEpoll, EPOLL_CTL_DEL, child.fd, NULL);
+            close(child.fd);
+            child.fd = -1;
+        }
+    }
+}
+
+/** stops the child on cancel or timeout, kills it after the grace period, reaps it once it exited */
+void CProcessMux::check(stChild& child) {
+    timepoint_t now = std::chrono::steady_clock::now();
+    if (child.bReplay) {
+        bool bCancel = child.options.pCancel && *child.options.pCancel;
+        if (bCancel || now >= child.deadline) {
+            if (bCancel && now < child.deadline) {
+                child.result.bCancelled = true;
+                child.result.wallMs = elapsedMs(child.start, now);
+            }
+            child.bRunning = false;
+            mRunning--;
+        }
+        return;
+    }
+    pid_t target = child.bOwnGroup ? -child.pid : child.pid;
+
+    if (!child.bStopping) {
+        bool bCancel = child.options.pCancel && *child.options.pCancel;
+        bool bTimeout = child.options.timeoutMs > 0 && now >= child.deadline;
+        if (bCancel || bTimeout) {
+            child.result.bCancelled = bCancel;
+            child.result.bTimedOut = !bCancel;
+            child.bStopping = true;
+            child.deadline = now + std::chrono::milliseconds(PROCESS_KILL_GRACE_MS);
+            kill(target, SIGTERM);
+            //the output of a stopped command is not waited for, a grandchild may hold the pipe
+            if (child.fd != -1) {
+                drain(child);
+            }
+            if (child.fd != -1) {
+                epoll_ctl(mEpoll, EPOLL_CTL_DEL, child.fd, NULL);
+                close(child.fd);
+                child.fd = -1;
+            }
+        }
+    } else if (now >= child.deadline) {
+        kill(target, SIGKILL);
+        child.deadline = now + std::chrono::hours(24);
+    }
+
+    if (child.fd != -1) {
+        return;
+    }
+    int status = 0;
+    struct rusage usage = {};
+    pid_t ret;
+    do {
+        ret = wait4(child.pid, &status, WNOHANG, &usage);
+    } while (ret == -1 && errno == EINTR);
+    if (ret == 0) {
+        return;
+    }
+    if (ret == -1) {
+        std::cerr << "error in waiting for child process" << std::endl;
+    } else if (WIFEXITED(status)) {
+        child.result.exitCode = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        child.result.signal = WTERMSIG(status);
+    }
+    child.result.userCpuMs = toMs(usage.ru_utime);
+    child.result.systemCpuMs = toMs(usage.ru_stime);
+    child.result.maxRssKb = usage.ru_maxrss;
+    child.result.wallMs = elapsedMs(child.start, now);
+    CProcessTrace::record(child.vArgs, child.result, child.traceOutput);
+
+    if (child.pidfd != -1) {
+        epoll_ctl(mEpoll, EPOLL_CTL_DEL, child.pidfd, NULL);
+        close(child.pidfd);
+        child.pidfd = -1;
+    }
+    child.bRunning = false;
+    mRunning--;
+}
+
+/** blocks until the child exited and reaps it, the rest of its output is dropped */
+void CProcessMux::finish(stChild& child) {
+    if (child.fd != -1) {
+        epoll_ctl(mEpoll, EPOLL_CTL_DEL, child.fd, NULL);
+        close(child.fd);
+        child.fd = -1;
+    }
+    while (child.bRunning) {
+        check(child);
+        if (child.bRunning) {
+            usleep(PROCESS_REAP_POLL_MS * 1000);
+        }
+    }
+}
+
+/** epoll timeout: the next deadline, the cancel poll or the exit poll without pidfd */
+int CProcessMux::nextWaitMs() {
+    timepoint_t now = std::chrono::steady_clock::now();
+    long waitMs = -1;
+    auto limit = [&waitMs](long ms) {
+        if (ms < 0) {
+            ms = 0;
+        }
+        if (waitMs < 0 || ms < waitMs) {
+            waitMs = ms;
+        }
+    };
+
+    for (auto& pChild : mChildren) {
+        stChild& child = *pChild;
+        if (!child.bRunning) {
+            continue;
+        }
+        if (child.bReplay) {
+            limit(elapsedMs(now, child.deadline) + 1);
+            if (child.options.pCancel) {
+                limit(PROCESS_CANCEL_POLL_MS);
+            }
+            continue;
+        }
+        if (child.bStopping || child.options.timeoutMs > 0) {
+            limit(elapsedMs(now, child.deadline) + 1);
+        }
+        if (child.options.pCancel && !child.bStopping) {
+            limit(PROCESS_CANCEL_POLL_MS);
+        }
+        if (child.pidfd == -1 && child.fd == -1) {
+            limit(PROCESS_REAP_POLL_MS);
+        }
+    }
+    return (int)waitMs;
+}
+
+void CProcessMux::wait() {
+    struct epoll_event events[32];
+
+    while (mRunning > 0 || mNextPending < mChildren.size()) {
+        while (mNextPending < mChildren.size() && (mMaxRunning == 0 || mRunning < mMaxRunning)) {
+            start(mNextPending++);
+        }
+        if (mRunning == 0) {
+            continue;
+        }
+
+        int count = epoll_wait(mEpoll, events, 32, nextWaitMs());
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "error in waiting for child processes" << std::endl;
+            for (auto& pChild : mChildren) {
+                finish(*pChild);
+            }
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            stChild& child = *mChildren[events[i].data.u64 >> 1];
+            if ((events[i].data.u64 & 1) == 0) {
+                drain(child);
+            } else if (child.pidfd != -1) {
+                //exited, reaped by check() once the output is drained
+                epoll_ctl(mEpoll, EPOLL_CTL_DEL, child.pidfd, NULL);
+                close(child.pidfd);
+                child.pidfd = -1;
+            }
+        }
+        for (auto& pChild : mChildren) {
+            if (pChild->bRunning) {
+                check(*pChild);
+            }
+        }
+    }
+}
+
+stProcessResult CProcess::run(const std::vector<std::string>& vArgs, const stProcessOptions& options) {
+    CProcessMux mux;
+    size_t id = mux.add(vArgs, options);
+    mux.wait();
+    return std::move(mux.result(id));
+}
+
+stProcessResult CProcess::runShell(const std::string& sCommand, const stProcessOptions& options) {
+    return run({"/bin/sh", "-c", sCommand}, options);
+}
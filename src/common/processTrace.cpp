@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#include <nlohmann/json.hpp>
+
+#include "processTrace.h"
+
+struct stTraceEntry {
+    stProcessResult result;
+    std::string output;
+};
+
+/** mode and data of the trace, set up on first use */
+struct stTraceState {
+    std::mutex mutex;
+    bool bDisabled = false;
+    int recordFd = -1;
+    bool bReplay = false;
+    bool bZeroLatency = false;
+    /** recorded commands by argv, in recorded order */
+    std::map<std::string, std::deque<stTraceEntry>> entries;
+};
+
+static std::string argvKey(const std::vector<std::string>& vArgs) {
+    std::string sKey;
+    for (const auto& sArg : vArgs) {
+        sKey += sArg;
+        sKey += '\0';
+    }
+    return sKey;
+}
+
+static void loadTrace(stTraceState& state, const char* pFile) {
+    std::ifstream file(pFile, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t pos = 0;
+    size_t count = 0;
+    while (pos + 4 <= data.size()) {
+        size_t size = (size_t)data[pos] | (size_t)data[pos + 1] << 8 | (size_t)data[pos + 2] << 16 |
+                      (size_t)data[pos + 3] << 24;
+        pos += 4;
+        if (pos + size > data.size()) {
+            std::cout << "trace ends in a partial record: " << pFile << std::endl;
+            break;
+        }
+        try {
+            nlohmann::json jRecord = nlohmann::json::from_cbor(data.begin() + (long)pos, data.begin() + (long)(pos + size));
+            stTraceEntry entry;
+            entry.result.bStarted = jRecord.value("started", false);
+            entry.result.bCancelled = jRecord.value("cancelled", false);
+            entry.result.bTimedOut = jRecord.value("timed_out", false);
+            entry.result.bTruncated = jRecord.value("truncated", false);
+            entry.result.exitCode = jRecord.value("exit_code", -1);
+            entry.result.signal = jRecord.value("signal", 0);
+            entry.result.spawnUs = jRecord.value("spawn_us", 0L);
+            entry.result.wallMs = jRecord.value("wall_ms", 0L);
+            entry.result.userCpuMs = jRecord.value("user_cpu_ms", 0L);
+            entry.result.systemCpuMs = jRecord.value("system_cpu_ms", 0L);
+            entry.result.maxRssKb = jRecord.value("max_rss_kb", 0L);
+            const auto& output = jRecord.at("output").get_binary();
+            entry.output.assign(output.begin(), output.end());
+            state.entries[argvKey(jRecord.at("args").get<std::vector<std::string>>())].push_back(std::move(entry));
+            count++;
+        } catch (const std::exception& e) {
+            std::cout << "invalid trace record: " << e.what() << std::endl;
+        }
+        pos += size;
+    }
+    std::cout << "replaying " << count << " commands from " << pFile << std::endl;
+}
+
+static stTraceState& traceState() {
+    static stTraceState* pState = [] {
+        stTraceState* pNew = new stTraceState(); //not destroyed, commands may run at exit
+        const char* pReplay = getenv(PROCESS_TRACE_REPLAY_ENV);
+        const char* pRecord = getenv(PROCESS_TRACE_RECORD_ENV);
+        if (pReplay && *pReplay) {
+            pNew->bReplay = true;
+            const char* pLatency = getenv(PROCESS_TRACE_LATENCY_ENV);
+            pNew->bZeroLatency = pLatency && std::string(pLatency) == "zero";
+            loadTrace(*pNew, pReplay);
+        } else if (pRecord && *pRecord) {
+            pNew->recordFd = open(pRecord, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+            if (pNew->recordFd == -1) {
+                std::cout << "trace not recorded, cannot open: " << pRecord << std::endl;
+            }
+        }
+        return pNew;
+    }();
+    return *pState;
+}
+
+bool CProcessTrace::isRecording() {
+    stTraceState& state = traceState();
+    return !state.bDisabled && state.recordFd != -1;
+}
+
+bool CProcessTrace::isReplaying() {
+    stTraceState& state = traceState();
+    return !state.bDisabled && state.bReplay;
+}
+
+bool CProcessTrace::isZeroLatency() {
+    return traceState().bZeroLatency;
+}
+
+void CProcessTrace::record(const std::vector<std::string>& vArgs, const stProcessResult& result, const std::string& sOutput) {
+    if (!isRecording()) {
+        return;
+    }
+    nlohmann::json jRecord;
+    jRecord["args"] = vArgs;
+    jRecord["started"] = result.bStarted;
+    jRecord["cancelled"] = result.bCancelled;
+    jRecord["timed_out"] = result.bTimedOut;
+    jRecord["truncated"] = result.bTruncated;
+    jRecord["exit_code"] = result.exitCode;
+    jRecord["signal"] = result.signal;
+    jRecord["spawn_us"] = result.spawnUs;
+    jRecord["wall_ms"] = result.wallMs;
+    jRecord["user_cpu_ms"] = result.userCpuMs;
+    jRecord["system_cpu_ms"] = result.systemCpuMs;
+    jRecord["max_rss_kb"] = result.maxRssKb;
+    jRecord["output"] = nlohmann::json::binary(std::vector<uint8_t>(sOutput.begin(), sOutput.end()));
+
+    std::vector<uint8_t> cbor = nlohmann::json::to_cbor(jRecord);
+    uint32_t size = (uint32_t)cbor.size();
+    uint8_t header[4] = {(uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24)};
+    cbor.insert(cbor.begin(), header, header + 4);
+
+    //one write per record, records of other writers do not interleave
+    stTraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    ssize_t num_bytes;
+    do {
+        num_bytes = write(state.recordFd, cbor.data(), cbor.size());
+    } while (num_bytes < 0 && errno == EINTR);
+    if (num_bytes != (ssize_t)cbor.size()) {
+        std::cout << "trace record not written" << std::endl;
+    }
+}
+
+bool CProcessTrace::replay(const std::vector<std::string>& vArgs, stProcessResult& result, std::string& sOutput) {
+    stTraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.entries.find(argvKey(vArgs));
+    if (it == state.entries.end() || it->second.empty()) {
+        return false;
+    }
+    stTraceEntry& entry = it->second.front();
+    result = entry.result;
+    sOutput = entry.output;
+    if (it->second.size() > 1) {
+        it->second.pop_front();
+    }
+    return true;
+}
+
+void CProcessTrace::disable() {
+    stTraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.bDisabled = true;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+/**
+ * Minimal plugin for the startup benchmark. The plugin name is the library
+ * file name, so one library copied N times gives N distinct plugins.
+ */
+
+#include <dlfcn.h>
+
+#include <filesystem>
+#include <string>
+
+#include "pluginInterface.h"
+
+/** any symbol of this library, to find the library file */
+static int gLibraryAnchor = 0;
+
+class CBenchPlugin : public CPluginInterfaceV2 {
+public:
+    int init(void* pIn_Context) override { (void)pIn_Context; return 0; }
+    void deinit(void* pIn_Context) override { (void)pIn_Context; }
+    void cancel(void* pIn_Context, std::string sRequest) override { (void)pIn_Context; (void)sRequest; }
+
+    /** libbench3.so -> bench3 */
+    std::string getInfo(void* pIn_Context) override {
+        (void)pIn_Context;
+        Dl_info info;
+        if (dladdr((void*)&gLibraryAnchor, &info) == 0 || info.dli_fname == NULL) {
+            return "bench";
+        }
+        std::string sName = std::filesystem::path(info.dli_fname).stem().string();
+        return sName.rfind("lib", 0) == 0 ? sName.substr(3) : sName;
+    }
+
+    void entryV2(void* pIn_Context, const nlohmann::json& jRequest, CResponseSink& sink) override {
+        (void)pIn_Context;
+        (void)jRequest;
+        sink.write({{"status", "success"}});
+    }
+};
+
+extern "C" CPluginInterface* create() {
+    return new CBenchPlugin;
+}
+
+extern "C" void destroy(CPluginInterface* pPlugin) {
+    delete pPlugin;
+}
+
+extern "C" CPluginInterfaceV2* create_v2() {
+    return new CBenchPlugin;
+}
+
+extern "C" int abi_version() {
+    return PLUGIN_ABI_VERSION;
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+/**
+ * Startup benchmark of the flow-tool executable.
+ *
+ * Runs the tool repeatedly in a scratch folder with FLOW_TOOL_STARTUP_TRACE set
+ * and reports the startup phases as json: cold runs (plugin index removed,
+ * executable and plugin libraries dropped from the page cache) and warm runs.
+ *
+ * flow-tool-bench --tool <flow-tool> --plugin-lib <libbench.so> [--plugins N]   synthetic lib/ of N plugins
+ * flow-tool-bench --tool <flow-tool> --lib <lib folder> [--config <config folder>]  real plugins
+ *      [--request <plugin> <json request>] [--runs R]
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "startupTrace.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+#define BENCH_DEFAULT_RUNS 20
+#define BENCH_DEFAULT_PLUGINS 10
+
+struct stOptions {
+    std::string sTool;
+    std::string sPluginLib;
+    std::string sLibDir;
+    std::string sConfigDir;
+    std::string sPlugin;
+    std::string sRequest;
+    int plugins = BENCH_DEFAULT_PLUGINS;
+    int runs = BENCH_DEFAULT_RUNS;
+};
+
+/** samples of one run: phase name -> ms, summed over all occurrences */
+typedef std::map<std::string, double> run_t;
+
+static void usage() {
+    std::cerr << "usage: flow-tool-bench --tool <flow-tool> (--plugin-lib <libbench.so> [--plugins N] | --lib <folder> [--config <folder>])" << std::endl;
+    std::cerr << "                       [--request <plugin> <json request>] [--runs R]" << std::endl;
+}
+
+/** drop a file from the page cache; dirty pages are written first */
+static void dropCache(const fs::path& file) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/** run the tool once; returns false if it could not be run */
+static bool runTool(const stOptions& opt, const fs::path& workDir, const fs::path& traceFile, double& processMs) {
+    fs::remove(traceFile);
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        if (chdir(workDir.c_str()) != 0) {
+            _exit(127);
+        }
+        setenv(STARTUP_TRACE_ENV, traceFile.c_str(), 1);
+        int devNull = open("/dev/null", O_WRONLY);
+        if (devNull >= 0) {
+            dup2(devNull, STDOUT_FILENO);
+            dup2(devNull, STDERR_FILENO);
+        }
+        std::string sPluginArg = "--" + opt.sPlugin;
+        execl(opt.sTool.c_str(), opt.sTool.c_str(), sPluginArg.c_str(), opt.sRequest.c_str(), (char*)NULL);
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    processMs = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count() / 1000.0;
+    return WIFEXITED(status) && WEXITSTATUS(status) != 127;
+}
+
+/** sum the traced phases by name; with bPerPlugin also by "phase:detail" */
+static bool readTrace(const fs::path& traceFile, bool bPerPlugin, run_t& run) {
+    std::ifstream ifs(traceFile);
+    json jTrace = json::parse(ifs, nullptr, false);
+    if (jTrace.is_discarded() || !jTrace.contains("phases")) {
+        return false;
+    }
+    for (const auto& jPhase : jTrace["phases"]) {
+        std::string sPhase = jPhase.value("phase", "");
+        double ms = jPhase.value("ms", 0.0);
+        run[sPhase] += ms;
+        if (bPerPlugin && jPhase.contains("detail") && sPhase != "first_entry") {
+            run[sPhase + ":" + fs::path(jPhase.value("detail", "")).filename().string()] += ms;
+        }
+    }
+    run["total"] = jTrace.value("total_ms", 0.0);
+    return true;
+}
+
+/** min, median, p90, max and mean of every phase */
+static json summarize(const std::vector<run_t>& runs) {
+    std::map<std::string, std::vector<double>> samples;
+    for (const run_t& run : runs) {
+        for (const auto& item : run) {
+            samples[item.first].push_back(item.second);
+        }
+    }
+    json jSummary = json::object();
+    for (auto& item : samples) {
+        std::vector<double>& v = item.second;
+        std::sort(v.begin(), v.end());
+        double sum = 0;
+        for (double d : v) {
+            sum += d;
+        }
+        jSummary[item.first] = {
+            {"min", v.front()},
+            {"median", v[v.size() / 2]},
+            {"p90", v[std::min(v.size() - 1, (v.size() * 9) / 10)]},
+            {"max", v.back()},
+            {"mean", sum / (double)v.size()},
+            {"samples", v.size()}
+        };
+    }
+    return jSummary;
+}
+
+/** set up the scratch folder: lib/ with the plugins, config/ if given.
+ *  returns the number of plugin libraries.
+ */
+static int prepare(const stOptions& opt, const fs::path& workDir) {
+    int plugins = 0;
+    fs::path libDir = workDir / "lib";
+    fs::create_directories(libDir);
+    if (!opt.sPluginLib.empty()) {
+        for (int i = 1; i <= opt.plugins; i++) {
+            fs::copy_file(opt.sPluginLib, libDir / ("libbench" + std::to_string(i) + ".so"));
+            plugins++;
+        }
+    } else {
+        for (const auto& entry : fs::directory_iterator(opt.sLibDir)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".so") {
+                fs::copy_file(entry.path(), libDir / entry.path().filename());
+                plugins++;
+            }
+        }
+    }
+    if (!opt.sConfigDir.empty()) {
+        fs::create_directory_symlink(fs::absolute(opt.sConfigDir), workDir / "config");
+    }
+    return plugins;
+}
+
+int main(int argc, char** argv) {
+    stOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string sArg = argv[i];
+        bool bHasValue = i + 1 < argc;
+        if (sArg == "--tool" && bHasValue) {
+            opt.sTool = argv[++i];
+        } else if (sArg == "--plugin-lib" && bHasValue) {
+            opt.sPluginLib = argv[++i];
+        } else if (sArg == "--plugins" && bHasValue) {
+            opt.plugins = std::max(1, atoi(argv[++i]));
+        } else if (sArg == "--lib" && bHasValue) {
+            opt.sLibDir = argv[++i];
+        } else if (sArg == "--config" && bHasValue) {
+            opt.sConfigDir = argv[++i];
+        } else if (sArg == "--request" && i + 2 < argc) {
+            opt.sPlugin = argv[++i];
+            opt.sRequest = argv[++i];
+        } else if (sArg == "--runs" && bHasValue) {
+            opt.runs = std::max(1, atoi(argv[++i]));
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (opt.sTool.empty() || opt.sPluginLib.empty() == opt.sLibDir.empty()) {
+        usage();
+        return 1;
+    }
+    bool bSynthetic = !opt.sPluginLib.empty();
+    if (opt.sPlugin.empty()) {
+        opt.sPlugin = bSynthetic ? "bench1" : "discovery";
+        opt.sRequest = bSynthetic ? "{}" : "{\"api\":\"status\"}";
+    }
+    opt.sTool = fs::absolute(opt.sTool).string();
+
+    char sTemplate[] = "/tmp/flow-tool-bench.XXXXXX";
+    if (mkdtemp(sTemplate) == NULL) {
+        std::cerr << "unable to create scratch folder" << std::endl;
+        return 1;
+    }
+    fs::path workDir = sTemplate;
+    fs::path traceFile = workDir / "trace.json";
+    int retVal = 0;
+
+    try {
+        int plugins = prepare(opt, workDir);
+        fs::path indexFile = workDir / "lib" / "plugin-index.json";
+
+        std::vector<run_t> coldRuns;
+        std::vector<run_t> warmRuns;
+        for (int cold = 1; cold >= 0; cold--) {
+            std::vector<run_t>& runs = cold ? coldRuns : warmRuns;
+            double processMs = 0;
+            if (!cold) {
+                //first warm run fills the caches and the index
+                runTool(opt, workDir, traceFile, processMs);
+            }
+            for (int i = 0; i < opt.runs; i++) {
+                if (cold) {
+                    fs::remove(indexFile);
+                    dropCache(opt.sTool);
+                    for (const auto& entry : fs::directory_iterator(workDir / "lib")) {
+                        dropCache(entry.path());
+                    }
+                }
+                run_t run;
+                if (!runTool(opt, workDir, traceFile, processMs) || !readTrace(traceFile, !bSynthetic, run)) {
+                    throw std::runtime_error("no startup trace, check --tool and --request");
+                }
+                run["process"] = processMs;
+                runs.push_back(std::move(run));
+            }
+        }
+
+        json jResult = json::object();
+        jResult["tool"] = opt.sTool;
+        jResult["mode"] = bSynthetic ? "synthetic" : "real";
+        jResult["plugins"] = plugins;
+        jResult["request"] = {{"plugin", opt.sPlugin}, {"request", opt.sRequest}};
+        jResult["runs"] = opt.runs;
+        jResult["unit"] = "ms";
+        jResult["cold"] = summarize(coldRuns);
+        jResult["warm"] = summarize(warmRuns);
+        std::cout << jResult.dump(2) << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "benchmark failed: " << e.what() << std::endl;
+        retVal = 1;
+    }
+
+    std::error_code ec;
+    fs::remove_all(workDir, ec);
+    return retVal;
+}
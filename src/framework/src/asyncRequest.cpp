@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <chrono>
+
+#include "asyncRequest.h"
+#include "requestDispatcher.h"
+
+using json = nlohmann::json;
+
+/**
+ * Starts the request on a worker thread.
+ *
+ * @param pDispatcher Dispatches the request, must outlive the handle.
+ * @param jEnvelope The request envelope.
+ * @param pStream Receives chunks and progress, optional.
+ */
+CAsyncRequest::CAsyncRequest(CRequestDispatcher *pDispatcher, json&& jEnvelope, CResponseSink *pStream) {
+    mpDispatcher = pDispatcher;
+    mFuture = std::async(std::launch::async, [pDispatcher, pStream](json jRequest) {
+        return pDispatcher->dispatch(jRequest, pStream);
+    }, std::move(jEnvelope));
+}
+
+CAsyncRequest::~CAsyncRequest() {
+    if (mFuture.valid()) {
+        mFuture.wait();
+    }
+}
+
+bool CAsyncRequest::wait(int timeoutMs) {
+    if (!mFuture.valid()) {
+        return true;
+    }
+    return mFuture.wait_for(std::chrono::milliseconds(timeoutMs)) == std::future_status::ready;
+}
+
+json CAsyncRequest::get() {
+    if (!mFuture.valid()) {
+        return json::object();
+    }
+    return mFuture.get();
+}
+
+void CAsyncRequest::cancel() {
+    mpDispatcher->cancel();
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "batch.h"
+#include "definitions.h"
+#include "helper.h"
+#include "logger.h"
+
+using json = nlohmann::json;
+
+CBatch::CBatch(CProgramContext *pCtx, CRequestDispatcher *pDispatcher) {
+    mpCtx = pCtx;
+    mpDispatcher = pDispatcher;
+}
+
+CBatch::~CBatch() {
+}
+
+/**
+ * Runs a request on a worker, the calling thread watches for interrupts.
+ *
+ * @param jEnvelope The request envelope.
+ * @param pRunning Turns false on SIGINT/SIGTERM, the request is cancelled then.
+ * @return The response envelope.
+ */
+json CBatch::runRequest(json&& jEnvelope, sig_atomic_t volatile *pRunning) {
+    std::unique_ptr<CAsyncRequest> pRequest = mpDispatcher->dispatchAsync(std::move(jEnvelope));
+    while (!pRequest->wait(BATCH_POLL_MS)) {
+        if (pRunning && !*pRunning) {
+            //repeated until the plugin returns, it may not have been listening yet
+            pRequest->cancel();
+        }
+    }
+    return pRequest->get();
+}
+
+/**
+ * Runs the requests line by line.
+ *
+ * @param in Request envelopes, one per line.
+ * @param out Receives one result line per request.
+ * @param pRunning Turns false on SIGINT/SIGTERM; the running request is
+ *        cancelled and no further requests are started.
+ * @return 0 if all requests succeeded, 1 otherwise.
+ */
+int CBatch::run(std::istream& in, std::ostream& out, sig_atomic_t volatile *pRunning) {
+    if (!mpCtx || !mpDispatcher) {
+        return 1;
+    }
+
+    //one artifact store for the whole batch, parsed results are reused
+    artifacts_t artifacts;
+    artifacts_t *pOuterArtifacts = mpCtx->pArtifacts;
+    mpCtx->pArtifacts = &artifacts;
+
+    int retVal = 0;
+    size_t lineNumber = 0;
+    std::string sLine;
+    while ((!pRunning || *pRunning) && std::getline(in, sLine)) {
+        lineNumber++;
+        Helper::trim(sLine);
+        if (sLine.empty() || sLine[0] == '#') {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        json result;
+        json jEnvelope = json::parse(sLine, nullptr, false);
+        if (jEnvelope.is_discarded() || !jEnvelope.is_object()) {
+            result = json::object();
+            result[MSG_STATUS] = MSG_FAILURE;
+            result[MSG_DESC] = MSG_INVALID_REQUEST;
+        } else {
+            PROGRAM_DEBUG("batch line ", lineNumber);
+            result = runRequest(std::move(jEnvelope), pRunning);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        result["line"] = lineNumber;
+        result["elapsed_ms"] = elapsed.count();
+        out << result.dump() << std::endl;
+
+        if (!CRequestDispatcher::succeeded(result)) {
+            PROGRAM_ERROR("batch stopped at line ", lineNumber);
+            retVal = 1;
+            break;
+        }
+    }
+    if (pRunning && !*pRunning) {
+        retVal = 1;
+    }
+
+    mpCtx->pArtifacts = pOuterArtifacts;
+    return retVal;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <future>
+#include <nlohmann/json.hpp>
+
+#include "pluginInterface.h"
+
+class CRequestDispatcher;
+
+/**
+ * Handle of a request running on a worker thread, see CRequestDispatcher::dispatchAsync.
+ * Chunks and progress of the request go to the response sink given at dispatch,
+ * on the worker thread. The destructor waits for the request to finish.
+ */
+class CAsyncRequest {
+
+private:
+    CRequestDispatcher *mpDispatcher;
+    std::future<nlohmann::json> mFuture;
+
+    //coverity
+    CAsyncRequest(CAsyncRequest const&) = delete;
+    void operator=(CAsyncRequest const&) = delete;
+
+public:
+    CAsyncRequest(CRequestDispatcher *pDispatcher, nlohmann::json&& jEnvelope, CResponseSink *pStream);
+    ~CAsyncRequest();
+
+    /** wait up to timeoutMs for the request; true once it is done */
+    bool wait(int timeoutMs);
+
+    /** wait for the request and return the response envelope; call once */
+    nlohmann::json get();
+
+    /** ask the running plugin to stop; returns without waiting */
+    void cancel();
+};
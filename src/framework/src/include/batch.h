@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <signal.h>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include "pluginInterface.h"
+#include "requestDispatcher.h"
+
+/** how often a running batch request checks for interrupts (ms) */
+#define BATCH_POLL_MS 100
+
+/**
+ * Runs a file of requests in one process; plugins are loaded once and stay loaded.
+ *
+ * input : one request envelope per line, see CRequestDispatcher; empty lines
+ *         and lines starting with # are skipped.
+ * output: one line per request, the response envelope with
+ *         "line": <input line number>, "elapsed_ms": <run time of the request>
+ *
+ * Artifacts are kept for the whole batch like in a pipeline: a snapshot
+ * collected by one request is read from memory by the next ones, files are
+ * only written for requests asking for it with "save": true.
+ * The batch stops at the first failing request.
+ */
+class CBatch {
+
+private:
+    CProgramContext *mpCtx;
+    CRequestDispatcher *mpDispatcher;
+
+    //coverity
+    CBatch(CBatch const&) = delete;
+    void operator=(CBatch const&) = delete;
+
+    /** run one envelope, cancel it once *pRunning turns false */
+    nlohmann::json runRequest(nlohmann::json&& jEnvelope, sig_atomic_t volatile *pRunning);
+
+public:
+    CBatch(CProgramContext *pCtx, CRequestDispatcher *pDispatcher);
+    ~CBatch();
+
+    /** run all requests of in, results go to out.
+     *  returns 0 if all requests succeeded.
+     */
+    int run(std::istream& in, std::ostream& out, sig_atomic_t volatile *pRunning);
+};
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "pluginInterface.h"
+#include "requestDispatcher.h"
+
+/**
+ * Runs plugins one after the other in the same process.
+ * Stage results are kept as parsed json in the program context artifacts and
+ * read by the next stage from there; files are only written if a stage asks
+ * for it with "save": true.
+ *
+ * stages: [{"plugin": "discovery", "request": {...}}, {"plugin": "analysis", ...}]
+ *     or  "discovery,analysis,deploy" using the default request of each plugin
+ */
+class CPipeline {
+
+private:
+    CProgramContext *mpCtx;
+    CRequestDispatcher *mpDispatcher;
+
+    //coverity
+    CPipeline(CPipeline const&) = delete;
+    void operator=(CPipeline const&) = delete;
+
+public:
+    CPipeline(CProgramContext *pCtx, CRequestDispatcher *pDispatcher);
+    ~CPipeline();
+
+    /** turn a comma separated plugin list or json stage list into stages.
+     *  returns an empty array if the spec is invalid.
+     */
+    static nlohmann::json parseStages(const std::string& sSpec);
+
+    /** run all stages, stops at the first failing stage; never throws */
+    nlohmann::json run(const nlohmann::json& jStages);
+};
@@ -24,6 +24,32 @@
 #include <filesystem>
 #include "pluginInterface.h"
 #include <memory>
+#include <cstdint>
+
+/** plugin index file name, kept in the plugin folder */
+#define PLUGIN_INDEX_FILE "plugin-index.json"
+
+/** presents a version 1 plugin through the version 2 interface */
+class CPluginV1Adapter : public CPluginInterfaceV2 {
+private:
+  CPluginInterface* mpPlugin;
+
+  //coverity
+  CPluginV1Adapter(CPluginV1Adapter const&) = delete;
+  void operator=(CPluginV1Adapter const&) = delete;
+
+public:
+  CPluginV1Adapter(CPluginInterface* pPlugin) : mpPlugin(pPlugin) {}
+
+  int init(void* pIn_Context) override { return mpPlugin->init(pIn_Context); }
+  void deinit(void* pIn_Context) override { mpPlugin->deinit(pIn_Context); }
+  std::string getInfo(void* pIn_Context) override { return mpPlugin->getInfo(pIn_Context); }
+  void cancel(void* pIn_Context, std::string sRequest) override { mpPlugin->cancel(pIn_Context, sRequest); }
+  std::string entry(void* pIn_Context, std::string sRequest) override { return mpPlugin->entry(pIn_Context, sRequest); }
+
+  /** serializes the request and parses the response on behalf of the plugin */
+  void entryV2(void* pIn_Context, const nlohmann::json& jRequest, CResponseSink& sink) override;
+};
 
 class CPluginManager {
     
@@ -34,14 +60,35 @@ private:
   struct stPluginInfo {
       std::string name;
       void* pHandleDlopen;
-      CPluginInterface* pPlugin;
+      CPluginInterface* pPlugin; //as created by the library
+      CPluginInterfaceV2* pPluginV2; //pPlugin itself or adapter for version 1 plugins
+      std::unique_ptr<CPluginV1Adapter> pAdapter;
+      std::string path;
+      int abi;
+      const stBuiltinPlugin* pBuiltin = NULL; //linked into the executable, no library
+  };
 
+  /** what is known about a plugin library without loading it */
+  struct stPluginIndexEntry {
+      std::string path;
+      int abi;
+      uintmax_t size;
+      int64_t mtime;
   };
+
   //coverity 
   CPluginManager(CPluginManager const&) = delete;
   void operator=(CPluginManager const&) = delete;
 
   std::map<std::string, std::shared_ptr<stPluginInfo>> mapPluginInfo;
+
+  /** plugin name to library, loaded on first use */
+  std::map<std::string, stPluginIndexEntry> mapPluginIndex;
+  /** path to libraries which did not load as plugin, skipped until they change */
+  std::map<std::string, stPluginIndexEntry> mapRejectedIndex;
+
+  std::string msLibPath;
+  bool mbIndexRebuilt;
   
   /** helper function for group loading libraries. */
   int loadPlugins(std::string sdirPath);
@@ -49,6 +96,9 @@ private:
   /** load plugin library */
  int loadPlugin(std::filesystem::path p, std::shared_ptr<stPluginInfo> pstPluginInfo);
 
+  /** create a plugin linked into the executable */
+  CPluginInterfaceV2* loadBuiltinPlugin(const std::string& sPluginName);
+
   /** unload all loaded plugin libraries */
   int unloadPlugins();
   
@@ -57,6 +107,15 @@ private:
   
   /** Destroy plugin instance and remove from the map */
  void unregisterPlugin(std::shared_ptr<stPluginInfo> pstPluginInfo);
+
+  /** read the index, rebuild it if plugin folder content changed */
+  int loadIndex(std::string sdirPath);
+
+  /** load all plugins once and record them in the index */
+  int rebuildIndex(std::string sdirPath);
+
+  /** true if index matches the plugin libraries in the folder */
+  bool isIndexCurrent(std::string sdirPath);
   
 
 public:
@@ -64,7 +123,9 @@ public:
     
     ~CPluginManager();
     
-    CPluginInterface* getPluginHandle(std::string pluginName);
+    /** returns the plugin, loading its library on first use */
+    CPluginInterfaceV2* getPluginHandle(std::string pluginName);
     
-    //fn to retrun all supported plugins
+    /** returns all known plugin names, no plugin is loaded */
+    std::vector<std::string> getPluginNames();
 };
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "asyncRequest.h"
+#include "pluginInterface.h"
+#include "pluginManager.h"
+
+/**
+ * Routes framework level requests to the loaded plugins.
+ *
+ * request envelope : {"id": <optional>, "plugin": "<name>", "request": {...}}
+ *                or  {"id": <optional>, "pipeline": "discovery,analysis" | [request envelope, ...]}
+ * response envelope: {"id": <echoed>, "plugin": "<name>", "status": "...", "response": {...}}
+ * chunk envelope   : {"id": <echoed>, "plugin": "<name>", "chunk": {...}}
+ *                    sent before the response envelope if the caller streams and
+ *                    the plugin splits up a large result.
+ * progress envelope: {"id": <echoed>, "plugin": "<name>", "progress": {...}}
+ *                    handed to the caller's sink while the request runs.
+ *
+ * One request runs at a time; cancel() stops it from another thread.
+ */
+class CRequestDispatcher {
+
+private:
+    CProgramContext *mpCtx;
+    CPluginManager *mpPluginMgr;
+
+    /** plugin and request in flight, for cancel */
+    std::mutex mRunningMutex;
+    CPluginInterfaceV2 *mpRunning;
+    nlohmann::json mRunningRequest;
+    std::atomic<bool> mbCancel;
+
+    //coverity
+    CRequestDispatcher(CRequestDispatcher const&) = delete;
+    void operator=(CRequestDispatcher const&) = delete;
+
+public:
+    CRequestDispatcher(CProgramContext *pCtx, CPluginManager *pPluginMgr);
+    ~CRequestDispatcher();
+
+    /** parse one request envelope and dispatch it; never throws.
+     *  chunk envelopes go to pStream if set and streaming.
+     */
+    nlohmann::json dispatch(const std::string& sEnvelope, CResponseSink *pStream = NULL);
+
+    /** dispatch an already parsed request envelope; never throws */
+    nlohmann::json dispatch(const nlohmann::json& jEnvelope, CResponseSink *pStream = NULL);
+
+    /** run the request on a worker thread, see CAsyncRequest */
+    std::unique_ptr<CAsyncRequest> dispatchAsync(nlohmann::json&& jEnvelope, CResponseSink *pStream = NULL);
+
+    /** stop the request in flight and refuse further stages of it */
+    void cancel();
+
+    /** true if the request was dispatched and the plugin did not report failure */
+    static bool succeeded(const nlohmann::json& jResponse);
+};
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <signal.h>
+#include <deque>
+#include <string>
+
+#include "requestDispatcher.h"
+
+/** default socket name, created in the current path */
+#define SERVICE_SOCKET_NAME "flow-tool.sock"
+
+/** max size of one request line */
+#define SERVICE_MAX_REQUEST_SIZE (1024 * 1024)
+
+/** a client that sends nothing this long (ms) while none of its requests runs is disconnected */
+#define SERVICE_IDLE_TIMEOUT_MS 10000
+
+/**
+ * Long lived service mode.
+ * Keeps plugin manager and plugins resident and serves newline delimited json
+ * requests on a local unix domain socket. Requests are served one at a time,
+ * an idle client is dropped after SERVICE_IDLE_TIMEOUT_MS so the next one is served.
+ * Large results may arrive as chunk lines before the response line, see
+ * CRequestDispatcher; a slow client slows down the plugin producing them.
+ * A running request is stopped by {"id": <id>, "cancel": true} or by shutdown.
+ */
+class CService {
+
+private:
+    CRequestDispatcher *mpDispatcher;
+    std::string msSocketPath;
+    int mListenFd;
+
+    //coverity
+    CService(CService const&) = delete;
+    void operator=(CService const&) = delete;
+
+    /** create, bind and listen on the unix socket */
+    int openSocket();
+
+    /** close and remove the unix socket */
+    void closeSocket();
+
+    /** per connection input state */
+    struct ClientState {
+        std::string sPending;                  //incomplete line
+        std::deque<nlohmann::json> qRequests;  //complete lines, parsed
+        bool bReading = true;                  //false after end of input
+    };
+
+    /** serve all requests of a connected client until it disconnects */
+    void handleClient(int clientFd, sig_atomic_t volatile *pRunning);
+
+    /** read available input into the request queue */
+    bool readRequests(int clientFd, std::string& sPending, std::deque<nlohmann::json>& qRequests);
+
+    /** run one request, watching the client for cancel lines */
+    nlohmann::json runRequest(int clientFd, nlohmann::json&& jEnvelope, CResponseSink *pStream,
+                              sig_atomic_t volatile *pRunning, ClientState& state);
+
+public:
+    CService(CRequestDispatcher *pDispatcher, std::string sSocketPath);
+    ~CService();
+
+    /** serve requests until *pRunning turns false.
+     *  returns 0 on clean shutdown, non-zero if the socket could not be created.
+     */
+    int run(sig_atomic_t volatile *pRunning);
+};
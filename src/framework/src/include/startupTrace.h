@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+/** environment variable naming the file the startup trace is written to */
+#define STARTUP_TRACE_ENV "FLOW_TOOL_STARTUP_TRACE"
+
+/**
+ * Startup phase timing, off unless STARTUP_TRACE_ENV is set.
+ * Phases are measured from main; the trace is written once the first plugin
+ * request returned, or at exit:
+ * {"pid": .., "phases": [{"phase": "plugin_scan", "start_ms": .., "ms": .., "detail": ".."}, ..], "total_ms": ..}
+ */
+class CStartupTrace {
+public:
+    typedef std::chrono::steady_clock clock_t;
+
+    static CStartupTrace& getInstance() {
+        static CStartupTrace instance;
+        return instance;
+    }
+
+    /** called first thing in main, reads STARTUP_TRACE_ENV */
+    void begin();
+
+    bool isEnabled() const { return mbEnabled; }
+
+    /** record a phase that started at start and ends now */
+    void record(const char* sPhase, clock_t::time_point start, const std::string& sDetail = "");
+
+    /** record the first plugin request and write the trace; later calls are ignored */
+    void recordFirstEntry(clock_t::time_point start, const std::string& sPlugin);
+
+    /** write the trace if not written yet */
+    void write();
+
+private:
+    bool mbEnabled = false;
+    bool mbWritten = false;
+    bool mbEntryRecorded = false;
+    std::string msFile;
+    clock_t::time_point mStart;
+    nlohmann::json mPhases = nlohmann::json::array();
+    std::mutex mMutex;
+
+    CStartupTrace() {}
+    ~CStartupTrace() { write(); }
+
+    CStartupTrace(CStartupTrace const&) = delete;
+    void operator=(CStartupTrace const&) = delete;
+};
+
+/** times the enclosing scope as one startup phase */
+class CTracePhase {
+private:
+    const char* msPhase;
+    std::string msDetail;
+    CStartupTrace::clock_t::time_point mStart;
+
+    //coverity
+    CTracePhase(CTracePhase const&) = delete;
+    void operator=(CTracePhase const&) = delete;
+
+public:
+    CTracePhase(const char* sPhase, const std::string& sDetail = "")
+        : msPhase(sPhase), msDetail(sDetail), mStart(CStartupTrace::clock_t::now()) {}
+
+    ~CTracePhase() {
+        CStartupTrace& trace = CStartupTrace::getInstance();
+        if (trace.isEnabled()) {
+            trace.record(msPhase, mStart, msDetail);
+        }
+    }
+};
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "taskExecutor.h"
+
+/**
+ * Work stealing thread pool, the CTaskExecutor of the framework.
+ * Every worker has its own queue per priority. A worker takes the newest task
+ * of its own queue and, when that is empty, steals the oldest task of another
+ * worker; higher priority work is taken first. Tasks submitted by a worker go
+ * to its own queue, others are spread over all workers.
+ */
+class CThreadPool : public CTaskExecutor {
+
+private:
+    struct stWorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks[TASK_PRIORITY_COUNT];
+    };
+
+    std::vector<std::unique_ptr<stWorkerQueue>> mQueues;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCond;
+    std::atomic<size_t> mQueued;
+    std::atomic<size_t> mNextQueue;
+    bool mbStop;
+
+    /** pool and queue index of the calling worker thread */
+    static thread_local CThreadPool *tlsPool;
+    static thread_local size_t tlsIndex;
+
+    //coverity
+    CThreadPool(CThreadPool const&) = delete;
+    void operator=(CThreadPool const&) = delete;
+
+    /** take a task from the own queue or steal one */
+    bool popTask(size_t index, std::function<void()>& task);
+
+    void workerLoop(size_t index);
+
+public:
+    /** threads - number of workers, 0 for defaultConcurrency() */
+    explicit CThreadPool(size_t threads = 0);
+
+    /** runs the queued tasks, then stops the workers */
+    ~CThreadPool();
+
+    /** cpus usable by the process: affinity mask, limited by the cgroup cpu quota */
+    static size_t defaultConcurrency();
+
+    void submit(std::function<void()> task, int priority) override;
+    bool runPendingTask() override;
+    size_t concurrency() const override;
+};
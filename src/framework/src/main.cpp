@@ -18,13 +18,24 @@
  */
  
 #include <iostream>
+#include <fstream>
 #include <filesystem>
 #include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <condition_variable>
 #include <mutex>
 
 #include "pluginManager.h"
+#include "requestDispatcher.h"
+#include "service.h"
+#include "pipeline.h"
+#include "batch.h"
+#include "startupTrace.h"
+#include "threadPool.h"
 #include "logger.h"
+#include "definitions.h"
+#include "privilegedHelper.h"
 
 std::condition_variable conditionVar;
 sig_atomic_t volatile gRunning = true;
@@ -41,7 +52,7 @@ void signalHandler( int signum ) {
     std::cout.flush();
   }
   
-  if (signum == SIGINT) {
+  if (signum == SIGINT || signum == SIGTERM) {
     gRunning = false;
   }
   
@@ -52,8 +63,105 @@ void signalHandler( int signum ) {
   conditionVar.notify_one();
 }
 
+/** prints plugin responses; json is streamed to the console, no response string is built */
+class CConsoleResponseSink : public CResponseSink {
+public:
+  void write(nlohmann::json&& jResponse) override {
+    if (CLogger::getInstance().getLogLevel() >= PROGRAM_NOTICE_LEVEL) {
+      std::cout << PROGRAM_LOG_PREFIX[PROGRAM_NOTICE_LEVEL] << "[Framework] " << jResponse << std::endl;
+    }
+  }
+
+  /** large results are printed one chunk per line */
+  bool isStreaming() const override { return true; }
+
+  bool writeChunk(nlohmann::json&& jChunk) override {
+    write(std::move(jChunk));
+    return true;
+  }
+
+  /** progress is shown with --verbose */
+  void writeProgress(nlohmann::json&& jProgress) override {
+    PROGRAM_INFO(jProgress);
+  }
+};
+
+/** how often the main thread checks for interrupts while a plugin runs (ms) */
+#define REQUEST_POLL_MS 100
+
+/** run a request envelope on a worker and print the response;
+ *  SIGINT/SIGTERM cancel the request.
+ */
+void runRequest(CRequestDispatcher* pDispatcher, nlohmann::json&& jEnvelope, const std::string& sName) {
+  CConsoleResponseSink sink;
+  std::unique_ptr<CAsyncRequest> pRequest = pDispatcher->dispatchAsync(std::move(jEnvelope), &sink);
+  bool bCancelNoticed = false;
+  while (!pRequest->wait(REQUEST_POLL_MS)) {
+    if (!gRunning) {
+      if (!bCancelNoticed) {
+        PROGRAM_NOTICE("cancelling ", sName);
+        bCancelNoticed = true;
+      }
+      //repeated until the plugin returns, it may not have been listening yet
+      pRequest->cancel();
+    }
+  }
+
+  nlohmann::json response = pRequest->get();
+  if (response.contains("response")) {
+    sink.write(std::move(response["response"]));
+  } else {
+    sink.write(std::move(response));
+  }
+}
+
+/** parse the command line plugin param and run it */
+void runPluginRequest(CRequestDispatcher* pDispatcher, const std::string& namePlugin, const std::string& pluginParam) {
+  nlohmann::json jRequest = nlohmann::json::parse(pluginParam, nullptr, false);
+  if (jRequest.is_discarded()) {
+    CConsoleResponseSink sink;
+    sink.write({{MSG_STATUS, MSG_FAILURE}, {MSG_DESC, MSG_INVALID_REQUEST}});
+    return;
+  }
+  runRequest(pDispatcher, {{"plugin", namePlugin}, {"request", std::move(jRequest)}}, namePlugin);
+}
+
+/**
+ * Batch mode without a results file writes the results to stdout. Plugins and
+ * their commands print to stdout too, so the results get a descriptor of
+ * their own and stdout goes to stderr from here on.
+ *
+ * @return the descriptor of the original stdout, -1 if it is not taken.
+ */
+static int takeStdoutForResults(int argc, char** argv) {
+    for (int j = 1; j < argc; ++j) {
+        if (std::string(argv[j]) == "--batch") {
+            if (argc > j+2 && std::string(argv[j+2]).rfind("--", 0) != 0) {
+                return -1; //results file
+            }
+            int resultsFd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+            if (resultsFd != -1 && dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+                close(resultsFd);
+                return -1;
+            }
+            return resultsFd;
+        }
+    }
+    return -1;
+}
+
 /** Application entry */
 int main(int argc, char** argv) {
+    //deploy started the executable through sudo to run its privileged commands,
+    //stdout is the channel to the deploy plugin
+    if (argc == 2 && std::string(argv[1]) == PRIVILEGED_HELPER_OPTION) {
+        return CPrivilegedHelper::serve();
+    }
+
+    int batchResultsFd = takeStdoutForResults(argc, argv);
+
+    CStartupTrace& startupTrace = CStartupTrace::getInstance();
+    startupTrace.begin();
         
     if (__cplusplus == 202101L) std::cout << "C++23";
     else if (__cplusplus == 202002L) std::cout << "C++20";
@@ -66,6 +174,7 @@ int main(int argc, char** argv) {
 
 
     //std::cout << "main " << argc << " arguments:" << "\n";
+    auto tLogger = CStartupTrace::clock_t::now();
     CLogger::getInstance().setLogLevel(PROGRAM_ERROR_LEVEL);
     
     CProgramContext *pCtx = new CProgramContext();
@@ -90,13 +199,22 @@ int main(int argc, char** argv) {
             CLogger::getInstance().setLogLevel(PROGRAM_NOTICE_LEVEL);
           }
     }
+    startupTrace.record("logger", tLogger);
     
 #if defined(DEBUG)|defined(_DEBUG)
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+    //worker threads shared by the framework and all plugins
+    auto tPool = CStartupTrace::clock_t::now();
+    CThreadPool *pPool = new CThreadPool();
+    pCtx->pExecutor = pPool;
+    startupTrace.record("thread_pool", tPool);
+
     //load all plugins
+    auto tScan = CStartupTrace::clock_t::now();
     CPluginManager *pPulginMgr = new CPluginManager(pCtx);
+    startupTrace.record("plugin_scan", tScan);
         
     //register signal SIGINT and signal handler  
     signal(SIGINT, signalHandler); 
@@ -106,7 +224,14 @@ int main(int argc, char** argv) {
     signal(SIGTERM, signalHandler);
 #endif
     
+    bool bService = false;
+    std::string sSocketPath = "";
+    bool bBatch = false;
+    std::string sBatchInput = "";
+    std::string sBatchOutput = "";
+
     /** commands to configure */
+    auto tArgs = CStartupTrace::clock_t::now();
     for (int j = 0; j < argc; ++j) {
         //std::cout << argv[j] << std::endl;
         std::string param = argv[j];
@@ -130,70 +255,148 @@ int main(int argc, char** argv) {
             std::cout << "usage [action] [parameter]" << std::endl;
             std::cout << "if no parameter is provided, the default value will be used" << std::endl;
             std::cout << "--<plugin name> <json plugin param> " << std::endl;
+            std::cout << "--pipeline <plugin,plugin,..|json stage list> run plugins in order, results handed over in memory" << std::endl;
+            std::cout << "--service [socket path] run as service, one json request per line: " << std::endl;
+            std::cout << "    {\"id\": 1, \"plugin\": \"<plugin name>\", \"request\": {<json plugin param>}}" << std::endl;
+            std::cout << "--batch <requests file|-> [results file] run the requests (same format as --service) in one process," << std::endl;
+            std::cout << "    one result line per request, - reads stdin" << std::endl;
         } else if (param == "--service") {
             //start as interactive service
+            bService = true;
+            if (argc > j+1 && std::string(argv[j+1]).rfind("--", 0) != 0) {
+                sSocketPath = argv[j+1];
+                j++;
+            }
+        } else if (param == "--batch") {
+            //run a file of requests
+            if (argc > j+1) {
+                bBatch = true;
+                sBatchInput = argv[j+1];
+                j++;
+                if (argc > j+1 && std::string(argv[j+1]).rfind("--", 0) != 0) {
+                    sBatchOutput = argv[j+1];
+                    j++;
+                }
+            }
         }
     }
+
+    startupTrace.record("args", tArgs);
+
+    /** service mode - plugins stay loaded and requests are served until interrupted */
+    if (bService) {
+        int retVal = 0;
+        {
+            CRequestDispatcher dispatcher(pCtx, pPulginMgr);
+            CService service(&dispatcher, sSocketPath);
+            retVal = service.run(&gRunning);
+        }
+        delete pPulginMgr;
+        delete pPool;
+        delete pCtx;
+        std::cout << "exit program" << std::endl;
+        return retVal;
+    }
     
-    /** action commands */
-    for (int i = 0; i < argc; ++i) {
-        //std::cout << argv[i] << std::endl;
-        std::string pluginName = argv[i];
-        if (pluginName == "--deploy") {
-            CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "handling --deploy");
-            if (argc > i+1) {
-                std::string pluginParam = argv[i+1];
-                //std::cout << pluginParam << std::endl;
-                PROGRAM_INFO(pluginParam);
+    /** batch mode - a file of requests, results one per line */
+    if (bBatch) {
+        int retVal = 1;
+        {
+            std::ifstream inFile;
+            std::ofstream outFile;
+            if (sBatchInput != "-") {
+                inFile.open(sBatchInput);
+            }
+            if (!sBatchOutput.empty()) {
+                outFile.open(sBatchOutput, std::ios_base::trunc | std::ios_base::out);
+            } else if (batchResultsFd != -1) {
+                //the stdout the tool was started with, nothing was written to it
+                outFile.open("/dev/fd/" + std::to_string(batchResultsFd), std::ios_base::app | std::ios_base::out);
+            }
+            if (sBatchInput != "-" && !inFile.is_open()) {
+                PROGRAM_ERROR("unable to read ", sBatchInput);
+            } else if ((!sBatchOutput.empty() || batchResultsFd != -1) && !outFile.is_open()) {
+                PROGRAM_ERROR("unable to write ", sBatchOutput.empty() ? "stdout" : sBatchOutput);
+            } else {
+                CRequestDispatcher dispatcher(pCtx, pPulginMgr);
+                CBatch batch(pCtx, &dispatcher);
+                retVal = batch.run(inFile.is_open() ? inFile : std::cin,
+                                   outFile.is_open() ? outFile : std::cout, &gRunning);
+            }
+        }
+        if (batchResultsFd != -1) {
+            close(batchResultsFd);
+        }
+        delete pPulginMgr;
+        delete pPool;
+        delete pCtx;
+        std::cout << "exit program" << std::endl;
+        return retVal;
+    }
+
+    /** action commands - the dispatcher ends before the context and plugins it refers to */
+    {
+        CRequestDispatcher dispatcher(pCtx, pPulginMgr);
+        for (int i = 0; i < argc && gRunning; ++i) {
+            //std::cout << argv[i] << std::endl;
+            std::string pluginName = argv[i];
+            if (pluginName == "--deploy") {
+                CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "handling --deploy");
+                if (argc > i+1) {
+                    std::string pluginParam = argv[i+1];
+                    //std::cout << pluginParam << std::endl;
+                    PROGRAM_INFO(pluginParam);
                 
-                if(pPulginMgr) {
+                    if(pPulginMgr) {
+    
+                        CPluginInterfaceV2* pPlugin = pPulginMgr->getPluginHandle("deploy");
+                        if(pPlugin != NULL) {
+                            //CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "got plugin handle");
+                            PROGRAM_DEBUG("got plugin handle");
+                            runPluginRequest(&dispatcher, "deploy", pluginParam);
+                        } else {
+                            CLogger::getInstance().log(PROGRAM_ERROR_LEVEL, "Unable to get plugin handle");
+                        }
     
-                    CPluginInterface* pPlugin = pPulginMgr->getPluginHandle("deploy");
-                    if(pPlugin != NULL) {
-                        //CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "got plugin handle");
-                        PROGRAM_DEBUG("got plugin handle");
-                        std::string retString = pPlugin->entry((void*)pCtx, pluginParam);
-                        CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "results: " + retString);
-                        #if(PROGRAM_NOTICE_LEVEL == 5)
-			 PROGRAM_NOTICE(retString);
-		        #endif
                     } else {
-                        CLogger::getInstance().log(PROGRAM_ERROR_LEVEL, "Unable to get plugin handle");
+                        PROGRAM_ERROR("Memory unavailable");
                     }
-    
-                } else {
-                    PROGRAM_ERROR("Memory unavailable");
                 }
-            }
             
-            i++;// skip next item - plugin param
-        } else {
-            if(!pPulginMgr) {
-                PROGRAM_ERROR("invalid plugin loader handler.");
+                i++;// skip next item - plugin param
+            } else if (pluginName == "--pipeline") {
+                if (argc > i+1 && pPulginMgr) {
+                    nlohmann::json jStages = CPipeline::parseStages(argv[i+1]);
+                    if (jStages.empty()) {
+                        PROGRAM_ERROR("invalid pipeline: ", argv[i+1]);
+                    } else {
+                        runRequest(&dispatcher, {{"pipeline", std::move(jStages)}}, "pipeline");
+                    }
+                }
+                i++;// skip next item - pipeline spec
             } else {
-                //change --sample to sample
-                std::string namePlugin = pluginName;
-                //example --deploy to deploy
-                #if __cplusplus > 202101L
-                    namePlugin.erase (std::remove(namePlugin.begin(), namePlugin.end(), '-'), namePlugin.end());
-                #else
-                    namePlugin.erase (0, 2);
-                #endif
-                CPluginInterface* pPlugin = pPulginMgr->getPluginHandle(namePlugin);
-                if(pPlugin != NULL) {
-                    PROGRAM_DEBUG("got plugin handle");
-                    std::string pluginParam = argv[i+1];
-                    i++;// skip next item - plugin param
-                    PROGRAM_INFO(pluginParam);
-                    std::string retString = pPlugin->entry((void*)pCtx, pluginParam);
-                    //release version
-                    #if(PROGRAM_NOTICE_LEVEL == 5)
-			 PROGRAM_NOTICE(retString);
-		    #endif
-                    PROGRAM_DEBUG(retString);
-
+                if(!pPulginMgr) {
+                    PROGRAM_ERROR("invalid plugin loader handler.");
                 } else {
-                    PROGRAM_INFO("Unable to get plugin");
+                    //change --sample to sample
+                    std::string namePlugin = pluginName;
+                    //example --deploy to deploy
+                    #if __cplusplus > 202101L
+                        namePlugin.erase (std::remove(namePlugin.begin(), namePlugin.end(), '-'), namePlugin.end());
+                    #else
+                        namePlugin.erase (0, 2);
+                    #endif
+                    CPluginInterfaceV2* pPlugin = pPulginMgr->getPluginHandle(namePlugin);
+                    if(pPlugin != NULL) {
+                        PROGRAM_DEBUG("got plugin handle");
+                        std::string pluginParam = (argc > i+1) ? argv[i+1] : "";
+                        i++;// skip next item - plugin param
+                        PROGRAM_INFO(pluginParam);
+                        runPluginRequest(&dispatcher, namePlugin, pluginParam);
+
+                    } else {
+                        PROGRAM_INFO("Unable to get plugin");
+                    }
                 }
             }
         }
@@ -204,6 +407,7 @@ int main(int argc, char** argv) {
         pCtx = NULL;
     }
     if(pPulginMgr)delete pPulginMgr;
+    delete pPool;
     std::cout << "exit program" << std::endl;
     return 0;
 }
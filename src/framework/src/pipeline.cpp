@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <sstream>
+
+#include "definitions.h"
+#include "helper.h"
+#include "logger.h"
+#include "pipeline.h"
+
+using json = nlohmann::json;
+
+/** request used for a stage given by plugin name only */
+static json defaultStageRequest(const std::string& sPlugin) {
+    if (sPlugin == "discovery") {
+        return json{{"api", "collect"}, {"nameonly", true}};
+    } else if (sPlugin == "analysis") {
+        return json{{"api", "execute"}};
+    } else if (sPlugin == "deploy") {
+        return json{{"api", "deploy"}, {"manifest", "pkg-manifest.json"}};
+    }
+    return json();
+}
+
+CPipeline::CPipeline(CProgramContext *pCtx, CRequestDispatcher *pDispatcher) {
+    mpCtx = pCtx;
+    mpDispatcher = pDispatcher;
+}
+
+CPipeline::~CPipeline() {
+}
+
+/**
+ * Builds the stage list.
+ *
+ * @param sSpec "discovery,analysis,deploy" or a json array of request envelopes.
+ * @return stage array, empty on invalid spec.
+ */
+json CPipeline::parseStages(const std::string& sSpec) {
+    json jStages = json::array();
+    std::string sTrimmed = sSpec;
+    Helper::trim(sTrimmed);
+
+    if (!sTrimmed.empty() && sTrimmed[0] == '[') {
+        json jParsed = json::parse(sTrimmed, nullptr, false);
+        if (jParsed.is_discarded() || !jParsed.is_array()) {
+            return json::array();
+        }
+        for (auto& jStage : jParsed) {
+            if (!jStage.is_object() || !jStage.contains("plugin")) {
+                return json::array();
+            }
+            if (!jStage.contains("request")) {
+                jStage["request"] = defaultStageRequest(jStage.value("plugin", ""));
+            }
+            jStages.push_back(jStage);
+        }
+        return jStages;
+    }
+
+    std::istringstream iss(sTrimmed);
+    std::string sPlugin;
+    while (std::getline(iss, sPlugin, ',')) {
+        Helper::trim(sPlugin);
+        if (sPlugin.empty()) {
+            continue;
+        }
+        json jRequest = defaultStageRequest(sPlugin);
+        if (jRequest.is_null()) {
+            PROGRAM_ERROR("no default request for plugin ", sPlugin);
+            return json::array();
+        }
+        jStages.push_back(json{{"plugin", sPlugin}, {"request", jRequest}});
+    }
+    return jStages;
+}
+
+/**
+ * Runs the stages in order with a shared in-memory artifact store.
+ *
+ * @param jStages request envelopes, see CRequestDispatcher.
+ * @return {"status": ..., "stages": [response envelopes], "artifacts": [names]}
+ */
+json CPipeline::run(const json& jStages) {
+    json response = json::object();
+    response["stages"] = json::array();
+
+    if (!mpCtx || !mpDispatcher || !jStages.is_array() || jStages.empty()) {
+        response[MSG_STATUS] = MSG_FAILURE;
+        response[MSG_DESC] = MSG_MISSING_INFO;
+        return response;
+    }
+
+    //a pipeline stage may itself be a pipeline; it gets its own artifacts
+    artifacts_t artifacts;
+    artifacts_t *pOuterArtifacts = mpCtx->pArtifacts;
+    mpCtx->pArtifacts = &artifacts;
+
+    bool bSuccess = true;
+    for (const auto& jStage : jStages) {
+        PROGRAM_DEBUG("pipeline stage ", jStage.value("plugin", ""));
+        json jStageResponse = mpDispatcher->dispatch(jStage);
+        bSuccess = CRequestDispatcher::succeeded(jStageResponse);
+        response["stages"].push_back(std::move(jStageResponse));
+        if (!bSuccess) {
+            PROGRAM_ERROR("pipeline stopped at stage ", jStage.value("plugin", ""));
+            break;
+        }
+    }
+
+    mpCtx->pArtifacts = pOuterArtifacts;
+
+    response["artifacts"] = json::array();
+    for (auto& item : artifacts) {
+        response["artifacts"].push_back(item.first);
+    }
+    response[MSG_STATUS] = bSuccess ? MSG_SUCCESS : MSG_FAILURE;
+    return response;
+}
@@ -25,18 +25,25 @@
 #include <filesystem> //current exe folder
 #include <system_error> //filesystem exceptions
 #include <iostream>
+#include <fstream>
+#include <set>
+#include <algorithm>
+#include <nlohmann/json.hpp>
 
 #include "logger.h"
 #include "pluginManager.h"
+#include "startupTrace.h"
 
 CPluginManager::CPluginManager(CProgramContext *pCtx) {
     mpCtx = pCtx;
+    mbIndexRebuilt = false;
     try {
         std::filesystem::path lib_fspath = std::filesystem::current_path() / "lib";
         std::string path_lib = lib_fspath.generic_string();
         PROGRAM_DEBUG(path_lib);
         if(std::filesystem::exists(lib_fspath)) {
-            loadPlugins(path_lib);
+            msLibPath = path_lib;
+            loadIndex(path_lib);
         } else {
             CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "lib folder not found in current path");
         }
@@ -65,13 +72,30 @@ int CPluginManager::loadPlugins(std::string sdirPath) {
             //std::cout << p.path() << std::endl;
             PROGRAM_INFO(p.path());
           if (p.is_regular_file() && (/*p.path().extension() == ".dll" ||*/ p.path().extension() == ".so")) {
-              std::shared_ptr<stPluginInfo> pstPluginInfo = std::make_shared<stPluginInfo>();
+              //already loaded plugins are kept, handles to them may be in use
+              std::shared_ptr<stPluginInfo> pstPluginInfo = NULL;
+              for (auto & item : mapPluginInfo) {
+                  if (item.second && item.second->path == p.path().generic_string()) {
+                      pstPluginInfo = item.second;
+                  }
+              }
+              bool bLoaded = (pstPluginInfo != NULL);
+              if (!bLoaded) {
+                  pstPluginInfo = std::make_shared<stPluginInfo>();
+              }
             //std::cout <<"load**" << std::endl;
-            if(loadPlugin(p.path(), pstPluginInfo) == 0) {
-                if(mapPluginInfo.find(pstPluginInfo->name) != mapPluginInfo.end()) {
-                    mapPluginInfo[pstPluginInfo->name] = pstPluginInfo;
-                } 
-            } 
+            bool bPlugin = bLoaded || loadPlugin(p.path(), pstPluginInfo) == 0;
+            stPluginIndexEntry entry;
+            entry.path = p.path().generic_string();
+            entry.abi = pstPluginInfo->abi;
+            entry.size = p.file_size();
+            entry.mtime = (int64_t)p.last_write_time().time_since_epoch().count();
+            if(bPlugin) {
+                mapPluginIndex[pstPluginInfo->name] = entry;
+            } else {
+                //failed to load, wrong abi or shadowed; indexed so it is not loaded again until it changes
+                mapRejectedIndex[entry.path] = entry;
+            }
             
           }
         }
@@ -96,9 +120,25 @@ int CPluginManager::loadPlugin(std::filesystem::path p, std::shared_ptr<stPlugin
         PROGRAM_DEBUG(p.string().c_str());
         dlerror();    /* Clear any existing error */
 
+        pstPluginInfo->path = p.generic_string();
+        auto tOpen = CStartupTrace::clock_t::now();
         pstPluginInfo->pHandleDlopen = dlopen (p.string().c_str(), RTLD_LAZY);
+        CStartupTrace::getInstance().record("dlopen", tOpen, pstPluginInfo->path);
         if (pstPluginInfo->pHandleDlopen) {
             CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "PLUGIN: Load SUCCESS");
+            //plugins without version symbol predate it and are treated as version 0
+            pstPluginInfo->abi = 0;
+            abi_version_t* abi_version = (abi_version_t*) dlsym(pstPluginInfo->pHandleDlopen, "abi_version");
+            dlerror();
+            if (abi_version) {
+                pstPluginInfo->abi = abi_version();
+            }
+            if (pstPluginInfo->abi > PLUGIN_ABI_VERSION) {
+                PROGRAM_ERROR("unsupported plugin interface version ", pstPluginInfo->abi, " ", p.string());
+                dlclose(pstPluginInfo->pHandleDlopen);
+                pstPluginInfo->pHandleDlopen = NULL;
+                return 1;
+            }
             std::string sInfo = registerPlugin(pstPluginInfo);
             if(!sInfo.empty()) {
                 //std::cout << "PLUGIN: Registering plugin " << p << "\n";
@@ -144,16 +184,48 @@ std::string CPluginManager::registerPlugin(std::shared_ptr<stPluginInfo> pstPlug
     try {
         dlerror();    /* Clear any existing error */
        
-        create_t* create_plugin_factory = (create_t*) dlsym(pstPluginInfo->pHandleDlopen, "create");
-        const char* dlsym_error = dlerror();
+        //prefer version 2 interface, version 1 plugins are wrapped
+        create_v2_t* create_v2_plugin_factory = NULL;
+        create_t* create_plugin_factory = NULL;
+        const char* dlsym_error = NULL;
+        if (pstPluginInfo->pBuiltin) {
+            create_v2_plugin_factory = pstPluginInfo->pBuiltin->create_v2;
+            create_plugin_factory = pstPluginInfo->pBuiltin->create;
+        } else {
+            create_v2_plugin_factory = (create_v2_t*) dlsym(pstPluginInfo->pHandleDlopen, "create_v2");
+            dlerror();
+            if (create_v2_plugin_factory == NULL) {
+                create_plugin_factory = (create_t*) dlsym(pstPluginInfo->pHandleDlopen, "create");
+            }
+            dlsym_error = dlerror();
+        }
         if (dlsym_error) {
             PROGRAM_ERROR("Cannot load symbol create:");
             PROGRAM_ERROR(dlsym_error);
         } else {
-            pstPluginInfo->pPlugin = create_plugin_factory();
+            auto tCreate = CStartupTrace::clock_t::now();
+            if (create_v2_plugin_factory) {
+                pstPluginInfo->pPluginV2 = create_v2_plugin_factory();
+                pstPluginInfo->pPlugin = pstPluginInfo->pPluginV2;
+            } else {
+                pstPluginInfo->pPlugin = create_plugin_factory();
+                if (pstPluginInfo->pPlugin) {
+                    pstPluginInfo->pAdapter = std::make_unique<CPluginV1Adapter>(pstPluginInfo->pPlugin);
+                    pstPluginInfo->pPluginV2 = pstPluginInfo->pAdapter.get();
+                }
+            }
+            CStartupTrace::getInstance().record("create", tCreate,
+                pstPluginInfo->pBuiltin ? std::string(pstPluginInfo->pBuiltin->name) : pstPluginInfo->path);
             if(pstPluginInfo->pPlugin) {
+                auto tInfo = CStartupTrace::clock_t::now();
                 sInfo = pstPluginInfo->pPlugin->getInfo((void*)mpCtx);
-                if(mapPluginInfo.find(sInfo) == mapPluginInfo.end()) {
+                CStartupTrace::getInstance().record("getInfo", tInfo, sInfo);
+                //a library does not replace the built-in plugin of the same name
+                bool bShadowed = !pstPluginInfo->pBuiltin &&
+                    std::any_of(builtinPlugins().begin(), builtinPlugins().end(),
+                                [&sInfo](const stBuiltinPlugin& builtin) { return sInfo == builtin.name; });
+                if(!bShadowed && mapPluginInfo.find(sInfo) == mapPluginInfo.end()) {
+                    pstPluginInfo->name = sInfo;
                     mapPluginInfo[sInfo] = pstPluginInfo;
                     PROGRAM_DEBUG("plugin registration successful");
                     PROGRAM_DEBUG(sInfo);
@@ -174,6 +246,13 @@ std::string CPluginManager::registerPlugin(std::shared_ptr<stPluginInfo> pstPlug
 void CPluginManager::unregisterPlugin(std::shared_ptr<stPluginInfo> pstPluginInfo) {
     PROGRAM_DEBUG("unregistering plugin");
     try {
+        if (pstPluginInfo->pBuiltin) {
+            pstPluginInfo->pPluginV2 = NULL;
+            pstPluginInfo->pAdapter.reset();
+            pstPluginInfo->pBuiltin->destroy(pstPluginInfo->pPlugin);
+            return;
+        }
+
         dlerror();    /* Clear any existing error */
                   
         destroy_t* destroy_plugin_factory = (destroy_t*) dlsym(pstPluginInfo->pHandleDlopen, "destroy");
@@ -181,6 +260,8 @@ void CPluginManager::unregisterPlugin(std::shared_ptr<stPluginInfo> pstPluginInf
         if (dlsym_error) {
             std::cout << "Cannot load symbol destroy: " << dlsym_error << '\n';
         } else {
+            pstPluginInfo->pPluginV2 = NULL;
+            pstPluginInfo->pAdapter.reset();
             destroy_plugin_factory(pstPluginInfo->pPlugin);
             dlclose(pstPluginInfo->pHandleDlopen);
         }
@@ -194,15 +275,238 @@ void CPluginManager::unregisterPlugin(std::shared_ptr<stPluginInfo> pstPluginInf
 }
 
 /** return handle to plugin class instance */
-CPluginInterface* CPluginManager::getPluginHandle(std::string sPluginName) {
-    for (auto & item : mapPluginInfo) {
-        std::string sName = item.first;
-        if(sPluginName.compare(sName) ==0 ) {
-          std::shared_ptr<stPluginInfo> pstPluginInfo = item.second;
-            if(pstPluginInfo) {
-                return pstPluginInfo->pPlugin;
-            }
+CPluginInterfaceV2* CPluginManager::getPluginHandle(std::string sPluginName) {
+    auto itLoaded = mapPluginInfo.find(sPluginName);
+    if (itLoaded != mapPluginInfo.end() && itLoaded->second) {
+        return itLoaded->second->pPluginV2;
+    }
+
+    //built-in plugins take precedence over libraries of the same name
+    CPluginInterfaceV2* pBuiltin = loadBuiltinPlugin(sPluginName);
+    if (pBuiltin) {
+        return pBuiltin;
+    }
+
+    //load on first use
+    auto itIndex = mapPluginIndex.find(sPluginName);
+    if (itIndex == mapPluginIndex.end()) {
+        return NULL;
+    }
+    PROGRAM_DEBUG("loading plugin on demand ", sPluginName);
+    std::shared_ptr<stPluginInfo> pstPluginInfo = std::make_shared<stPluginInfo>();
+    if (loadPlugin(itIndex->second.path, pstPluginInfo) == 0) {
+        itLoaded = mapPluginInfo.find(sPluginName);
+        if (itLoaded != mapPluginInfo.end() && itLoaded->second) {
+            return itLoaded->second->pPluginV2;
+        }
+    }
+
+    //library replaced or removed since the index was checked. refresh once.
+    if (!mbIndexRebuilt && !msLibPath.empty()) {
+        PROGRAM_INFO("plugin ", sPluginName, " changed, refreshing plugin index");
+        rebuildIndex(msLibPath);
+        itLoaded = mapPluginInfo.find(sPluginName);
+        if (itLoaded != mapPluginInfo.end() && itLoaded->second) {
+            return itLoaded->second->pPluginV2;
         }
     }
     return NULL;
 }
+
+/**
+ * Creates a plugin linked into the executable, through the same factories a
+ * library exports.
+ *
+ * @param sPluginName name the plugin registered with.
+ * @return the plugin, NULL if there is no such built-in plugin.
+ */
+CPluginInterfaceV2* CPluginManager::loadBuiltinPlugin(const std::string& sPluginName) {
+    for (const stBuiltinPlugin& builtin : builtinPlugins()) {
+        if (sPluginName != builtin.name) {
+            continue;
+        }
+        PROGRAM_DEBUG("creating built-in plugin ", sPluginName);
+        std::shared_ptr<stPluginInfo> pstPluginInfo = std::make_shared<stPluginInfo>();
+        pstPluginInfo->pBuiltin = &builtin;
+        pstPluginInfo->path = "";
+        pstPluginInfo->abi = builtin.abi_version ? builtin.abi_version() : 0;
+        if (registerPlugin(pstPluginInfo) != sPluginName) {
+            PROGRAM_ERROR("built-in plugin name mismatch ", sPluginName);
+            return NULL;
+        }
+        return pstPluginInfo->pPluginV2;
+    }
+    return NULL;
+}
+
+/** version 1 plugins take and return json strings */
+void CPluginV1Adapter::entryV2(void* pIn_Context, const nlohmann::json& jRequest, CResponseSink& sink) {
+    std::string sRequest = jRequest.is_string() ? jRequest.get<std::string>() : jRequest.dump();
+    std::string retString = mpPlugin->entry(pIn_Context, sRequest);
+    nlohmann::json jResponse = nlohmann::json::parse(retString, nullptr, false);
+    if (jResponse.is_discarded()) {
+        jResponse = retString;
+    }
+    sink.write(std::move(jResponse));
+}
+
+/** return all known plugin names */
+std::vector<std::string> CPluginManager::getPluginNames() {
+    std::vector<std::string> vNames;
+    for (const stBuiltinPlugin& builtin : builtinPlugins()) {
+        vNames.push_back(builtin.name);
+    }
+    for (auto & item : mapPluginIndex) {
+        if (std::find(vNames.begin(), vNames.end(), item.first) == vNames.end()) {
+            vNames.push_back(item.first);
+        }
+    }
+    return vNames;
+}
+
+/**
+ * Reads the plugin index from the plugin folder.
+ * The index is rebuilt if it is missing, unreadable or any library was added,
+ * removed or modified since it was written.
+ *
+ * @param sdirPath plugin folder
+ * @return 0 on success
+ */
+int CPluginManager::loadIndex(std::string sdirPath) {
+    std::filesystem::path indexPath = std::filesystem::path(sdirPath) / PLUGIN_INDEX_FILE;
+    try {
+        std::ifstream ifs(indexPath);
+        nlohmann::json jIndex = nlohmann::json::parse(ifs, nullptr, false);
+        if (!jIndex.is_discarded() && jIndex.is_object()
+            && jIndex.value("abi", -1) == PLUGIN_ABI_VERSION
+            && jIndex.contains("plugins") && jIndex["plugins"].is_object()) {
+            for (auto & item : jIndex["plugins"].items()) {
+                stPluginIndexEntry entry;
+                entry.path = item.value().at("path").get<std::string>();
+                entry.abi = item.value().at("abi").get<int>();
+                entry.size = item.value().at("size").get<uintmax_t>();
+                entry.mtime = item.value().at("mtime").get<int64_t>();
+                mapPluginIndex[item.key()] = entry;
+            }
+            if (jIndex.contains("rejected") && jIndex["rejected"].is_object()) {
+                for (auto & item : jIndex["rejected"].items()) {
+                    stPluginIndexEntry entry;
+                    entry.path = item.key();
+                    entry.abi = item.value().at("abi").get<int>();
+                    entry.size = item.value().at("size").get<uintmax_t>();
+                    entry.mtime = item.value().at("mtime").get<int64_t>();
+                    mapRejectedIndex[entry.path] = entry;
+                }
+            }
+        }
+    } catch (...) {
+        PROGRAM_INFO("invalid plugin index ", indexPath.string());
+        mapPluginIndex.clear();
+        mapRejectedIndex.clear();
+    }
+
+    if ((mapPluginIndex.empty() && mapRejectedIndex.empty()) || !isIndexCurrent(sdirPath)) {
+        return rebuildIndex(sdirPath);
+    }
+    PROGRAM_DEBUG("plugin index is current");
+    return 0;
+}
+
+/**
+ * Compares the index against the libraries in the plugin folder.
+ * Only the folder listing and file attributes are read, no library is loaded.
+ */
+bool CPluginManager::isIndexCurrent(std::string sdirPath) {
+    try {
+        std::set<std::string> setIndexed;
+        for (auto & item : mapPluginIndex) {
+            setIndexed.insert(item.second.path);
+        }
+        for (auto & item : mapRejectedIndex) {
+            setIndexed.insert(item.first);
+        }
+
+        std::set<std::string> setFound;
+        for (auto const& p : std::filesystem::directory_iterator(sdirPath)) {
+            if (!p.is_regular_file() || p.path().extension() != ".so") {
+                continue;
+            }
+            std::string sPath = p.path().generic_string();
+            setFound.insert(sPath);
+            if (setIndexed.find(sPath) == setIndexed.end()) {
+                return false;
+            }
+        }
+        //rejected libraries are checked as well, they are retried once they change
+        for (auto* pIndex : {&mapPluginIndex, &mapRejectedIndex}) {
+            for (auto & item : *pIndex) {
+                const stPluginIndexEntry& entry = item.second;
+                if (setFound.find(entry.path) == setFound.end()) {
+                    return false;
+                }
+                if (std::filesystem::file_size(entry.path) != entry.size ||
+                    (int64_t)std::filesystem::last_write_time(entry.path).time_since_epoch().count() != entry.mtime) {
+                    return false;
+                }
+            }
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loads every plugin in the folder once to learn its name and writes the index.
+ * Plugins stay loaded, they were paid for already.
+ */
+int CPluginManager::rebuildIndex(std::string sdirPath) {
+    PROGRAM_INFO("building plugin index");
+    mbIndexRebuilt = true;
+    mapPluginIndex.clear();
+    mapRejectedIndex.clear();
+    loadPlugins(sdirPath);
+
+    nlohmann::json jIndex = nlohmann::json::object();
+    jIndex["abi"] = PLUGIN_ABI_VERSION;
+    jIndex["plugins"] = nlohmann::json::object();
+    for (auto & item : mapPluginIndex) {
+        nlohmann::json jEntry = nlohmann::json::object();
+        jEntry["path"] = item.second.path;
+        jEntry["abi"] = item.second.abi;
+        jEntry["size"] = item.second.size;
+        jEntry["mtime"] = item.second.mtime;
+        jIndex["plugins"][item.first] = jEntry;
+    }
+    jIndex["rejected"] = nlohmann::json::object();
+    for (auto & item : mapRejectedIndex) {
+        nlohmann::json jEntry = nlohmann::json::object();
+        jEntry["abi"] = item.second.abi;
+        jEntry["size"] = item.second.size;
+        jEntry["mtime"] = item.second.mtime;
+        jEntry["loadable"] = false;
+        jIndex["rejected"][item.first] = jEntry;
+    }
+
+    //write to a temporary file and rename, readers never see a partial index
+    std::filesystem::path indexPath = std::filesystem::path(sdirPath) / PLUGIN_INDEX_FILE;
+    std::filesystem::path tmpPath = indexPath;
+    tmpPath += ".tmp";
+    try {
+        {
+            std::ofstream ofs(tmpPath, std::ios::trunc);
+            if (!ofs) {
+                PROGRAM_INFO("plugin index not writable ", indexPath.string());
+                return 1;
+            }
+            ofs << jIndex.dump(4) << std::endl;
+        }
+        std::filesystem::rename(tmpPath, indexPath);
+    } catch (...) {
+        PROGRAM_INFO("unable to save plugin index ", indexPath.string());
+        std::error_code ec;
+        std::filesystem::remove(tmpPath, ec);
+        return 1;
+    }
+    return 0;
+}
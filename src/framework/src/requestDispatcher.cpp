@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include "definitions.h"
+#include "logger.h"
+#include "requestDispatcher.h"
+#include "pipeline.h"
+#include "startupTrace.h"
+
+using json = nlohmann::json;
+
+/** keeps the plugin response, passes chunks on wrapped in a chunk envelope */
+class CEnvelopeSink : public CResponseSink {
+private:
+    json mHeader;
+    CResponseSink *mpStream;
+
+public:
+    json jResponse;
+
+    CEnvelopeSink(json&& jHeader, CResponseSink *pStream) : mHeader(std::move(jHeader)), mpStream(pStream) {}
+
+    void write(json&& jIn) override {
+        jResponse = std::move(jIn);
+    }
+
+    bool isStreaming() const override {
+        return mpStream && mpStream->isStreaming();
+    }
+
+    void writeProgress(json&& jProgress) override {
+        if (mpStream) {
+            json jEnvelope = mHeader;
+            jEnvelope["progress"] = std::move(jProgress);
+            mpStream->writeProgress(std::move(jEnvelope));
+        }
+    }
+
+    bool writeChunk(json&& jChunk) override {
+        if (!isStreaming()) {
+            return false;
+        }
+        json jEnvelope = mHeader;
+        jEnvelope["chunk"] = std::move(jChunk);
+        return mpStream->writeChunk(std::move(jEnvelope));
+    }
+};
+
+CRequestDispatcher::CRequestDispatcher(CProgramContext *pCtx, CPluginManager *pPluginMgr) {
+    mpCtx = pCtx;
+    mpPluginMgr = pPluginMgr;
+    mpRunning = NULL;
+    mbCancel = false;
+}
+
+CRequestDispatcher::~CRequestDispatcher() {
+    if (mpCtx && mpCtx->pCancel == &mbCancel) {
+        mpCtx->pCancel = NULL;
+    }
+}
+
+/**
+ * Parses a request envelope and dispatches it to the named plugin.
+ *
+ * @param sEnvelope The request envelope in json format.
+ * @param pStream Receives chunk envelopes, optional.
+ * @return The response envelope.
+ */
+json CRequestDispatcher::dispatch(const std::string& sEnvelope, CResponseSink *pStream) {
+    json jEnvelope = json::parse(sEnvelope, nullptr, false);
+    if (jEnvelope.is_discarded() || !jEnvelope.is_object()) {
+        json response = json::object();
+        response[MSG_STATUS] = MSG_FAILURE;
+        response[MSG_DESC] = MSG_INVALID_REQUEST;
+        return response;
+    }
+    return dispatch(jEnvelope, pStream);
+}
+
+/**
+ * Dispatches a request envelope to the named plugin.
+ *
+ * @param jEnvelope The request envelope.
+ * @param pStream Receives chunk envelopes, optional.
+ * @return The response envelope with the plugin response embedded.
+ */
+json CRequestDispatcher::dispatch(const json& jEnvelope, CResponseSink *pStream) {
+    json response = json::object();
+    try {
+        if (jEnvelope.contains("id")) { response["id"] = jEnvelope.at("id"); }
+
+        //{"pipeline": [envelope, ...]} runs the stages with in-memory handoff
+        if (jEnvelope.contains("pipeline")) {
+            const json& jSpec = jEnvelope.at("pipeline");
+            json jStages = jSpec.is_string() ? CPipeline::parseStages(jSpec.get<std::string>()) : jSpec;
+            CPipeline pipeline(mpCtx, this);
+            json jResult = pipeline.run(jStages);
+            response[MSG_STATUS] = jResult[MSG_STATUS];
+            response["response"] = std::move(jResult);
+            return response;
+        }
+
+        std::string sPlugin = "";
+        if (jEnvelope.contains("plugin")) { sPlugin = jEnvelope.at("plugin").get<std::string>(); }
+        response["plugin"] = sPlugin;
+
+        if (sPlugin.empty() || !jEnvelope.contains("request")) {
+            response[MSG_STATUS] = MSG_FAILURE;
+            response[MSG_DESC] = MSG_MISSING_INFO;
+            return response;
+        }
+
+        CPluginInterfaceV2* pPlugin = mpPluginMgr ? mpPluginMgr->getPluginHandle(sPlugin) : NULL;
+        if (pPlugin == NULL) {
+            PROGRAM_INFO("Unable to get plugin ", sPlugin);
+            response[MSG_STATUS] = MSG_FAILURE;
+            response[MSG_DESC] = MSG_API_NOT_SUPPORTED;
+            return response;
+        }
+
+        //request may also be given as json string
+        const json& jRequestIn = jEnvelope.at("request");
+        json jParsed;
+        if (jRequestIn.is_string()) {
+            jParsed = json::parse(jRequestIn.get<std::string>(), nullptr, false);
+            if (jParsed.is_discarded()) {
+                response[MSG_STATUS] = MSG_FAILURE;
+                response[MSG_DESC] = MSG_INVALID_REQUEST;
+                return response;
+            }
+        }
+        const json& jRequest = jRequestIn.is_string() ? jParsed : jRequestIn;
+        PROGRAM_DEBUG("dispatch ", sPlugin);
+
+        json jHeader = json::object();
+        if (response.contains("id")) { jHeader["id"] = response["id"]; }
+        jHeader["plugin"] = sPlugin;
+        CEnvelopeSink sink(std::move(jHeader), pStream);
+        {
+            std::lock_guard<std::mutex> lock(mRunningMutex);
+            if (mbCancel) {
+                response[MSG_STATUS] = MSG_FAILURE;
+                response[MSG_DESC] = MSG_CANCELLED;
+                return response;
+            }
+            mpRunning = pPlugin;
+            mRunningRequest = jRequest;
+            mpCtx->pCancel = &mbCancel; //cleared before the request is published, see dispatchAsync
+        }
+        auto tEntry = CStartupTrace::clock_t::now();
+        try {
+            pPlugin->entryV2((void*)mpCtx, jRequest, sink);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mRunningMutex);
+            mpRunning = NULL;
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mRunningMutex);
+            mpRunning = NULL;
+        }
+        CStartupTrace::getInstance().recordFirstEntry(tEntry, sPlugin);
+
+        response[MSG_STATUS] = MSG_SUCCESS;
+        response["response"] = std::move(sink.jResponse);
+    } catch (const std::exception& e) {
+        PROGRAM_ERROR("Exception dispatching request ", e.what());
+        response[MSG_STATUS] = MSG_FAILURE;
+        response[MSG_DESC] = MSG_INTERNAL_ERROR;
+    } catch (...) {
+        PROGRAM_ERROR("Exception dispatching request");
+        response[MSG_STATUS] = MSG_FAILURE;
+        response[MSG_DESC] = MSG_INTERNAL_ERROR;
+    }
+    return response;
+}
+
+/**
+ * Starts a request on a worker thread. Clears an earlier cancel.
+ *
+ * @param jEnvelope The request envelope.
+ * @param pStream Receives chunk and progress envelopes, optional.
+ * @return handle to wait for, or cancel, the request.
+ */
+std::unique_ptr<CAsyncRequest> CRequestDispatcher::dispatchAsync(json&& jEnvelope, CResponseSink *pStream) {
+    mbCancel = false;
+    return std::unique_ptr<CAsyncRequest>(new CAsyncRequest(this, std::move(jEnvelope), pStream));
+}
+
+/**
+ * Checks a response envelope; plugins report their own status inside the response.
+ *
+ * @param jResponse The response envelope.
+ * @return false if dispatching or the plugin failed.
+ */
+bool CRequestDispatcher::succeeded(const json& jResponse) {
+    if (jResponse.value(MSG_STATUS, "") != MSG_SUCCESS) {
+        return false;
+    }
+    if (jResponse.contains("response") && jResponse["response"].is_object() &&
+        jResponse["response"].value(MSG_STATUS, "") == MSG_FAILURE) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Forwards cancel to the plugin running the request. Safe to call repeatedly
+ * and from any thread; a pipeline does not start further stages.
+ */
+void CRequestDispatcher::cancel() {
+    mbCancel = true;
+    std::lock_guard<std::mutex> lock(mRunningMutex);
+    if (mpRunning) {
+        try {
+            mpRunning->cancel((void*)mpCtx, mRunningRequest.dump());
+        } catch (...) {
+            PROGRAM_ERROR("Exception cancelling request");
+        }
+    }
+}
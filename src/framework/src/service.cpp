@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include <chrono>
+#include <filesystem>
+
+#include "definitions.h"
+#include "logger.h"
+#include "service.h"
+
+/** poll interval to check for shutdown requests (ms) */
+#define SERVICE_POLL_TIMEOUT 500
+/** poll interval to check for cancel while a request runs (ms) */
+#define SERVICE_CANCEL_POLL_MS 100
+
+CService::CService(CRequestDispatcher *pDispatcher, std::string sSocketPath) {
+    mpDispatcher = pDispatcher;
+    mListenFd = -1;
+    msSocketPath = sSocketPath;
+    if (msSocketPath.empty()) {
+        msSocketPath = (std::filesystem::current_path() / SERVICE_SOCKET_NAME).generic_string();
+    }
+}
+
+CService::~CService() {
+    closeSocket();
+}
+
+/**
+ * Creates the unix domain socket. Socket is accessible by the owner only.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+int CService::openSocket() {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (msSocketPath.size() >= sizeof(addr.sun_path)) {
+        PROGRAM_ERROR("socket path too long: ", msSocketPath);
+        return 1;
+    }
+    strncpy(addr.sun_path, msSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    //remove stale socket left behind by previous instance
+    struct stat st;
+    if (lstat(msSocketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(msSocketPath.c_str());
+    }
+
+    mListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (mListenFd < 0) {
+        PROGRAM_ERROR("unable to create socket: ", strerror(errno));
+        return 1;
+    }
+
+    mode_t oldMask = umask(0177);
+    int retVal = bind(mListenFd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(oldMask);
+    if (retVal != 0) {
+        PROGRAM_ERROR("unable to bind socket ", msSocketPath, ": ", strerror(errno));
+        close(mListenFd);
+        mListenFd = -1;
+        return 1;
+    }
+
+    if (listen(mListenFd, 8) != 0) {
+        PROGRAM_ERROR("unable to listen on socket: ", strerror(errno));
+        closeSocket();
+        return 1;
+    }
+    return 0;
+}
+
+void CService::closeSocket() {
+    if (mListenFd >= 0) {
+        close(mListenFd);
+        mListenFd = -1;
+        unlink(msSocketPath.c_str());
+    }
+}
+
+/**
+ * Writes a newline terminated response to the client.
+ * Blocks while the socket buffer is full.
+ *
+ * @return false if the client is gone.
+ */
+static bool writeLine(int clientFd, const std::string& sLine) {
+    std::string sOut = sLine + "\n";
+    size_t offset = 0;
+    while (offset < sOut.size()) {
+        ssize_t n = send(clientFd, sOut.data() + offset, sOut.size() - offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            PROGRAM_INFO("client write failed: ", strerror(errno));
+            return false;
+        }
+        offset += (size_t)n;
+    }
+    return true;
+}
+
+/** writes chunk and progress envelopes to the client as they arrive */
+class CSocketStreamSink : public CResponseSink {
+private:
+    int mClientFd;
+
+public:
+    explicit CSocketStreamSink(int clientFd) : mClientFd(clientFd) {}
+
+    //the response envelope is written by the service
+    void write(nlohmann::json&& jResponse) override { (void)jResponse; }
+
+    bool isStreaming() const override { return true; }
+
+    bool writeChunk(nlohmann::json&& jChunk) override {
+        return writeLine(mClientFd, jChunk.dump());
+    }
+
+    void writeProgress(nlohmann::json&& jProgress) override {
+        writeLine(mClientFd, jProgress.dump());
+    }
+};
+
+/** {"id": <id>, "cancel": true} stops the running request with that id (any if no id) */
+static bool isCancelRequest(const nlohmann::json& jEnvelope) {
+    return jEnvelope.is_object() && jEnvelope.contains("cancel") && jEnvelope["cancel"] == true;
+}
+
+/**
+ * Reads what the client sent and queues the complete request lines, parsed.
+ * Lines that are no valid json are queued as discarded values.
+ *
+ * @return false on end of input, error, or a request line above SERVICE_MAX_REQUEST_SIZE.
+ */
+bool CService::readRequests(int clientFd, std::string& sPending, std::deque<nlohmann::json>& qRequests) {
+    char buf[4096];
+    ssize_t n = read(clientFd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR) {
+        return true;
+    }
+    if (n <= 0) {
+        return false; //client closed connection
+    }
+    sPending.append(buf, (size_t)n);
+
+    size_t pos;
+    while ((pos = sPending.find('\n')) != std::string::npos) {
+        std::string sLine = sPending.substr(0, pos);
+        sPending.erase(0, pos + 1);
+        if (!sLine.empty() && sLine.back() == '\r') sLine.pop_back();
+        if (sLine.empty()) continue;
+        qRequests.push_back(nlohmann::json::parse(sLine, nullptr, false));
+    }
+    return sPending.size() <= SERVICE_MAX_REQUEST_SIZE;
+}
+
+/**
+ * Runs one request on a worker. Meanwhile the client is read for cancel lines,
+ * other requests are queued. Shutdown cancels the request.
+ *
+ * @return the response envelope.
+ */
+nlohmann::json CService::runRequest(int clientFd, nlohmann::json&& jEnvelope, CResponseSink *pStream,
+                                    sig_atomic_t volatile *pRunning, ClientState& state) {
+    nlohmann::json jId = jEnvelope.contains("id") ? jEnvelope["id"] : nlohmann::json();
+    std::unique_ptr<CAsyncRequest> pRequest = mpDispatcher->dispatchAsync(std::move(jEnvelope), pStream);
+
+    while (!pRequest->wait(SERVICE_CANCEL_POLL_MS)) {
+        bool bCancel = !*pRunning;
+        if (state.bReading) {
+            struct pollfd pfd = {clientFd, POLLIN, 0};
+            if (poll(&pfd, 1, 0) > 0) {
+                state.bReading = readRequests(clientFd, state.sPending, state.qRequests);
+            }
+            for (auto it = state.qRequests.begin(); it != state.qRequests.end();) {
+                if (isCancelRequest(*it)) {
+                    if (!it->contains("id") || (*it)["id"] == jId) {
+                        bCancel = true;
+                    }
+                    it = state.qRequests.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        if (bCancel) {
+            pRequest->cancel();
+        }
+    }
+    return pRequest->get();
+}
+
+/**
+ * Reads newline delimited requests from the client, dispatches them and writes
+ * one response line per request. Cancel lines get no response of their own,
+ * the cancelled request answers with its (failure) response.
+ */
+void CService::handleClient(int clientFd, sig_atomic_t volatile *pRunning) {
+    ClientState state;
+    CSocketStreamSink streamSink(clientFd);
+    auto tLastInput = std::chrono::steady_clock::now();
+
+    while (*pRunning) {
+        if (state.qRequests.empty()) {
+            if (!state.bReading) {
+                break; //all requests answered
+            }
+            struct pollfd pfd = {clientFd, POLLIN, 0};
+            int ready = poll(&pfd, 1, SERVICE_POLL_TIMEOUT);
+            if (ready == 0 || (ready < 0 && errno == EINTR)) {
+                //clients are served one at a time, an idle one would block the others
+                if (std::chrono::steady_clock::now() - tLastInput > std::chrono::milliseconds(SERVICE_IDLE_TIMEOUT_MS)) {
+                    PROGRAM_INFO("client idle, disconnected");
+                    break;
+                }
+                continue;
+            }
+            if (ready < 0) {
+                break;
+            }
+            state.bReading = readRequests(clientFd, state.sPending, state.qRequests);
+            tLastInput = std::chrono::steady_clock::now();
+        } else {
+            nlohmann::json jEnvelope = std::move(state.qRequests.front());
+            state.qRequests.pop_front();
+            if (isCancelRequest(jEnvelope)) {
+                continue; //nothing running
+            }
+
+            nlohmann::json response;
+            if (jEnvelope.is_discarded() || !jEnvelope.is_object()) {
+                response[MSG_STATUS] = MSG_FAILURE;
+                response[MSG_DESC] = MSG_INVALID_REQUEST;
+            } else {
+                response = runRequest(clientFd, std::move(jEnvelope), &streamSink, pRunning, state);
+            }
+            if (!writeLine(clientFd, response.dump())) {
+                return;
+            }
+            tLastInput = std::chrono::steady_clock::now(); //idle from the response on
+        }
+
+        if (state.sPending.size() > SERVICE_MAX_REQUEST_SIZE) {
+            nlohmann::json response = nlohmann::json::object();
+            response[MSG_STATUS] = MSG_FAILURE;
+            response[MSG_DESC] = MSG_INVALID_REQUEST;
+            writeLine(clientFd, response.dump());
+            return;
+        }
+    }
+}
+
+/**
+ * Service loop. Accepts one client at a time and serves it until it disconnects.
+ *
+ * @param pRunning cleared by the signal handler to stop the service.
+ * @return 0 on clean shutdown, non-zero on failure.
+ */
+int CService::run(sig_atomic_t volatile *pRunning) {
+    if (!mpDispatcher || openSocket() != 0) {
+        return 1;
+    }
+    PROGRAM_NOTICE("service listening on ", msSocketPath);
+
+    while (*pRunning) {
+        struct pollfd pfd = {mListenFd, POLLIN, 0};
+        int ready = poll(&pfd, 1, SERVICE_POLL_TIMEOUT);
+        if (ready <= 0) {
+            continue; //timeout or interrupted - recheck running flag
+        }
+
+        int clientFd = accept4(mListenFd, NULL, NULL, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            continue;
+        }
+        PROGRAM_DEBUG("client connected");
+        try {
+            handleClient(clientFd, pRunning);
+        } catch (...) {
+            PROGRAM_ERROR("Exception serving client");
+        }
+        close(clientFd);
+        PROGRAM_DEBUG("client disconnected");
+    }
+
+    closeSocket();
+    PROGRAM_NOTICE("service stopped");
+    return 0;
+}
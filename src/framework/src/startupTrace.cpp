@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include "startupTrace.h"
+
+using json = nlohmann::json;
+
+/** milliseconds with microsecond resolution */
+static double toMs(CStartupTrace::clock_t::duration d) {
+    return (double)std::chrono::duration_cast<std::chrono::microseconds>(d).count() / 1000.0;
+}
+
+void CStartupTrace::begin() {
+    mStart = clock_t::now();
+    const char* sFile = getenv(STARTUP_TRACE_ENV);
+    if (sFile && *sFile) {
+        msFile = sFile;
+        mbEnabled = true;
+    }
+}
+
+void CStartupTrace::record(const char* sPhase, clock_t::time_point start, const std::string& sDetail) {
+    if (!mbEnabled) {
+        return;
+    }
+    json jPhase = json::object();
+    jPhase["phase"] = sPhase;
+    jPhase["start_ms"] = toMs(start - mStart);
+    jPhase["ms"] = toMs(clock_t::now() - start);
+    if (!sDetail.empty()) {
+        jPhase["detail"] = sDetail;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPhases.push_back(std::move(jPhase));
+}
+
+void CStartupTrace::recordFirstEntry(clock_t::time_point start, const std::string& sPlugin) {
+    if (!mbEnabled) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mbEntryRecorded) {
+            return;
+        }
+        mbEntryRecorded = true;
+    }
+    record("first_entry", start, sPlugin);
+    write();
+}
+
+void CStartupTrace::write() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mbEnabled || mbWritten) {
+        return;
+    }
+    mbWritten = true;
+
+    json jTrace = json::object();
+    jTrace["pid"] = (int)getpid();
+    jTrace["phases"] = mPhases;
+    jTrace["total_ms"] = toMs(clock_t::now() - mStart);
+
+    std::ofstream ofs(msFile, std::ios_base::trunc | std::ios_base::out);
+    if (ofs.is_open()) {
+        ofs << jTrace.dump() << std::endl;
+    }
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <sched.h>
+
+#include <fstream>
+#include <string>
+
+#include "logger.h"
+#include "threadPool.h"
+
+thread_local CThreadPool *CThreadPool::tlsPool = NULL;
+thread_local size_t CThreadPool::tlsIndex = 0;
+
+/**
+ * Reads the cpu quota of the cgroup (v2 cpu.max, v1 cfs quota/period).
+ *
+ * @return number of cpus the quota allows, 0 if there is no quota.
+ */
+static size_t cgroupCpuLimit() {
+    long quota = -1;
+    long period = 0;
+
+    std::ifstream cpuMax("/sys/fs/cgroup/cpu.max");
+    if (cpuMax.is_open()) {
+        std::string sQuota;
+        if (cpuMax >> sQuota >> period && sQuota != "max") {
+            quota = std::stol(sQuota);
+        }
+    } else {
+        std::ifstream cfsQuota("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+        std::ifstream cfsPeriod("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+        if (!(cfsQuota >> quota) || !(cfsPeriod >> period)) {
+            quota = -1;
+        }
+    }
+
+    if (quota <= 0 || period <= 0) {
+        return 0;
+    }
+    //round up, a quota of 1.5 cpus keeps two threads busy part time
+    return (size_t)((quota + period - 1) / period);
+}
+
+size_t CThreadPool::defaultConcurrency() {
+    size_t count = std::thread::hardware_concurrency();
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+        count = (size_t)CPU_COUNT(&cpuSet);
+    }
+
+    try {
+        size_t limit = cgroupCpuLimit();
+        if (limit > 0 && limit < count) {
+            count = limit;
+        }
+    } catch (...) {
+        //unreadable quota - keep the affinity count
+    }
+    return count > 0 ? count : 1;
+}
+
+CThreadPool::CThreadPool(size_t threads) {
+    mQueued = 0;
+    mNextQueue = 0;
+    mbStop = false;
+
+    if (threads == 0) {
+        threads = defaultConcurrency();
+    }
+    for (size_t i = 0; i < threads; i++) {
+        mQueues.emplace_back(new stWorkerQueue());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        mThreads.emplace_back(&CThreadPool::workerLoop, this, i);
+    }
+    PROGRAM_DEBUG("thread pool workers: ", threads);
+}
+
+CThreadPool::~CThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mbStop = true;
+    }
+    mSleepCond.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+size_t CThreadPool::concurrency() const {
+    return mThreads.size();
+}
+
+/**
+ * Queues a task. A worker queues to its own queue, which it works on newest
+ * first; other threads spread the tasks over the workers.
+ *
+ * @param task The task, exceptions are caught and logged.
+ * @param priority TASK_PRIORITY_HIGH .. TASK_PRIORITY_LOW.
+ */
+void CThreadPool::submit(std::function<void()> task, int priority) {
+    if (priority < 0 || priority >= TASK_PRIORITY_COUNT) {
+        priority = TASK_PRIORITY_NORMAL;
+    }
+    size_t index = (tlsPool == this) ? tlsIndex : (mNextQueue++ % mQueues.size());
+    {
+        std::lock_guard<std::mutex> lock(mQueues[index]->mutex);
+        mQueues[index]->tasks[priority].push_back(std::move(task));
+    }
+    mQueued++;
+    {
+        //pairs with the wait in workerLoop, no wakeup gets lost
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mSleepCond.notify_one();
+}
+
+bool CThreadPool::popTask(size_t index, std::function<void()>& task) {
+    size_t count = mQueues.size();
+    for (int priority = 0; priority < TASK_PRIORITY_COUNT; priority++) {
+        //own queue, newest first
+        {
+            std::lock_guard<std::mutex> lock(mQueues[index]->mutex);
+            auto& tasks = mQueues[index]->tasks[priority];
+            if (!tasks.empty()) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+                mQueued--;
+                return true;
+            }
+        }
+        //steal the oldest from the others
+        for (size_t i = 1; i < count; i++) {
+            stWorkerQueue& victim = *mQueues[(index + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto& tasks = victim.tasks[priority];
+            if (!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                mQueued--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool CThreadPool::runPendingTask() {
+    if (tlsPool != this) {
+        return false;
+    }
+    std::function<void()> task;
+    if (!popTask(tlsIndex, task)) {
+        return false;
+    }
+    try {
+        task();
+    } catch (const std::exception& e) {
+        PROGRAM_ERROR("Exception in task ", e.what());
+    } catch (...) {
+        PROGRAM_ERROR("Exception in task");
+    }
+    return true;
+}
+
+void CThreadPool::workerLoop(size_t index) {
+    tlsPool = this;
+    tlsIndex = index;
+
+    while (true) {
+        if (runPendingTask()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleepCond.wait(lock, [this] { return mbStop || mQueued > 0; });
+        if (mbStop && mQueued == 0) {
+            break;
+        }
+    }
+}
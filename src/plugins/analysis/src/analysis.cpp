@@ -26,6 +26,7 @@
 #include <sstream>
 #include <nlohmann/json-schema.hpp>
 #include <filesystem>
+#include <fstream>
 
 using nlohmann::json;
 
@@ -50,7 +51,7 @@ std::string CAnalysis::handleInfo(std::string sReq) {
 /**
 * validate the schema
 */
-std::string CAnalysis::handleValidate(std::string message)
+json CAnalysis::handleValidate(const json& jReq)
 {
    
    std::filesystem::path currentToolPath = std::filesystem::current_path();
@@ -71,14 +72,26 @@ std::string CAnalysis::handleValidate(std::string message)
            result = "analysis: failed to open schema" ;
            response[MSG_STATUS] = MSG_FAILURE;
            response[MSG_DESC] = result;
-           return response.dump();
+           return response;
        }
-        bool status = CValidator::validateSchema(schema, manifestFile);
+        bool status = false;
+        if (mpArtifacts && mpArtifacts->count(ARTIFACT_GAP_REPORT)) {
+            status = CValidator::validateJson(schema, mpArtifacts->at(ARTIFACT_GAP_REPORT));
+        } else {
+            status = CValidator::validateSchema(schema, manifestFile);
+        }
         if(status)
         {
           validateFlag = true;
             //since each call is running within it's own instance repopulate the map.
           loadSnapfiles(); 
+          if (*mpCancel) {
+              validateFlag = false;
+              response[MSG_STATUS] = MSG_FAILURE;
+              response[MSG_DESC] = MSG_CANCELLED;
+              deInit();
+              return response;
+          }
             //get the diff for dpkg
             const std::map<std::string, pkgrules::packageContent_t>& output = pRules->schemajsonOutput();
            validateFlag = false;
@@ -111,13 +124,13 @@ std::string CAnalysis::handleValidate(std::string message)
     }
     
    deInit();
-   return response.dump();
+   return response;
 }
 
 /**
 * process the snap files and return status
 */
-std::string CAnalysis::handleExecute(std::string message) {
+json CAnalysis::handleExecute(const json& jsonObj) {
 
  bool bverbCheck = false;
  std::string status = "success";
@@ -126,8 +139,6 @@ std::string CAnalysis::handleExecute(std::string message) {
 
  try {
   
-     //POST request
-     json jsonObj = json::parse(message);
     //get the post data
     if (jsonObj.contains("post")) {
        filename = jsonObj["post"];
@@ -137,7 +148,11 @@ std::string CAnalysis::handleExecute(std::string message) {
     if(!bverbCheck)
       status = loadSnapfiles(); 
 
-    if (status.find("failed") != std::string::npos) {
+    if (*mpCancel) {
+       response[MSG_DESC] = MSG_CANCELLED;
+       response[MSG_STATUS] = MSG_FAILURE;
+    }
+    else if (status.find("failed") != std::string::npos) {
        response[MSG_DESC] = status;
        response[MSG_STATUS] = MSG_FAILURE;
     }
@@ -152,7 +167,7 @@ std::string CAnalysis::handleExecute(std::string message) {
         response[MSG_DESC] = msg;
     }
 
- return response.dump();
+ return response;
 }
 
 /**
@@ -162,25 +177,53 @@ int CAnalysis::cancelRequest(int requestID) {
     return 0;
 }
 
+/**
+ * cancel the running request from another thread; it stops before its next step
+ */
+std::string CAnalysis::handleCancel(std::string sReq) {
+
+    auto response = json::object();
+    try{
+        mbCancel = true;
+        response[MSG_STATUS] = MSG_SUCCESS;
+	} catch (const std::exception& e) {
+        std::string msg = "Exception : ";
+		msg.append(e.what());
+        response[MSG_STATUS] = MSG_FAILURE;
+        response[MSG_DESC] = msg;
+	}
+
+	return response.dump();
+}
+
 /**
  * entry point. f
  */
-std::string CAnalysis::handleEntry(std::string sReq) {
+json CAnalysis::handleEntry(const json& jReq, artifacts_t* pArtifacts, CTaskExecutor* pExecutor,
+                            const std::atomic<bool>* pCancel) {
 
     auto response = json::object();
+    mpArtifacts = pArtifacts;
+    mpExecutor = pExecutor;
+    if (!pCancel) {
+        mbCancel = false; //a framework without its own flag, a cancel before this point is lost
+    }
+    mpCancel = pCancel ? pCancel : &mbCancel;
    
     try {
        // init();
         //parse request
         std::string api = "";
-        json jReq = json::parse(sReq);
         if(jReq.contains("api")) { 
            api = jReq.at("api").get<std::string>();
         }
+        //in a pipeline the report is handed over in memory, file is optional
+        mbSave = (mpArtifacts == NULL);
+        if(jReq.contains(ARTIFACT_SAVE)) { mbSave = jReq.at(ARTIFACT_SAVE).get<bool>(); }
         if(api.compare("execute") ==0) {
-            return handleExecute(sReq);
+            return handleExecute(jReq);
         }else if(api.compare("validate") ==0) {
-            return handleValidate(sReq);
+            return handleValidate(jReq);
         } 
         else {
             response[MSG_STATUS] = MSG_FAILURE;
@@ -193,7 +236,7 @@ std::string CAnalysis::handleEntry(std::string sReq) {
            response[MSG_DESC] = msg;
 	}        
         
-	return response.dump();
+	return response;
 }   
 
 /**
@@ -208,6 +251,24 @@ void CAnalysis::deInit() {
  
 }
 
+/**
+ * parseSnapfile read a snapshot file, safe to call from a worker thread
+ */
+nlohmann::json CAnalysis::parseSnapfile(const std::filesystem::path& snapfile)
+{
+    nlohmann::json snapInst;
+    try {
+        std::ifstream fileHandler(snapfile);
+        if (fileHandler.is_open()) {
+            fileHandler >> snapInst;
+        }
+    } catch (const std::exception& e) {
+        std::cout << "analysis error:   "  << e.what() <<  std::endl;
+        snapInst = nlohmann::json();
+    }
+    return snapInst;
+}
+
 /**
  * loadSnapfiles load the snapfiles
  */
@@ -234,8 +295,11 @@ std::string CAnalysis::loadSnapfiles(const std::string& filename)
            RefSnapFile = currentToolPath / folderPath / file;
         }
        
+       //platform snapshot handed over by the discovery stage of a pipeline
+       bool bSnapInMemory = mpArtifacts && mpArtifacts->count(ARTIFACT_PLATFORM_SNAPSHOT);
+
        // Check if the file exists
-       if (!std::filesystem::exists(PlatSnapFile)) {
+       if (!bSnapInMemory && !std::filesystem::exists(PlatSnapFile)) {
           return "failed: platform snapshot file doesn't exist";
         }
        if (!std::filesystem::exists(RefSnapFile)) {
@@ -243,11 +307,31 @@ std::string CAnalysis::loadSnapfiles(const std::string& filename)
         }
         
        init(); 
-         // Load the first JSON file
-       nlohmann::json snapPlt = pRules->load_snapfile(PlatSnapFile); 
-       nlohmann::json snapRef = pRules->load_snapfile(RefSnapFile); 
+       //parse both snapshots in parallel, the rules read their metadata in order after
+       nlohmann::json snapPlt;
+       nlohmann::json snapRef;
+       {
+           CTaskGroup tasks(mpExecutor);
+           if (!bSnapInMemory) {
+               tasks.run([&]() { snapPlt = parseSnapfile(PlatSnapFile); });
+           }
+           tasks.run([&]() { snapRef = parseSnapfile(RefSnapFile); });
+           tasks.wait();
+       }
+       if (*mpCancel) {
+           deInit();
+           return "failed: " MSG_CANCELLED;
+       }
+         // Load the first JSON file, the artifact is read in place
+       const nlohmann::json& jPlt = bSnapInMemory ? mpArtifacts->at(ARTIFACT_PLATFORM_SNAPSHOT) : snapPlt;
+       if (!jPlt.empty()) {
+           pRules->load_snapjson(jPlt, bSnapInMemory ? ARTIFACT_PLATFORM_SNAPSHOT : PlatSnapFile.string());
+       }
+       if (!snapRef.empty()) {
+           pRules->load_snapjson(snapRef, RefSnapFile.string());
+       }
        
-	if(snapPlt.empty() ) {
+	if(jPlt.empty() ) {
 	   deInit();
 	   return "analysis: failed loading platform snapshot file";
 	}
@@ -256,13 +340,13 @@ std::string CAnalysis::loadSnapfiles(const std::string& filename)
            return "analysis: failed loading reference snapshot file";
         }   
         //compare the files
-	if (snapPlt == snapRef) {
+	if (jPlt == snapRef) {
            result =  "failed: no diff found in the packages";
 	} else {
-           bool status = pRules->comparefiles(snapPlt,snapRef,bverbCheck);
+           bool status = pRules->comparefiles(jPlt,snapRef,bverbCheck);
 		   
-	   if(status) {
-      	      result = pRules->generateReport();
+	   if(status && !*mpCancel) {
+      	      result = pRules->generateReport(mpArtifacts, mbSave);
 	   }
         }
     } catch (const std::exception &e) {
@@ -18,8 +18,10 @@
  */
 #pragma once
 
+#include <atomic>
 #include <nlohmann/json.hpp>
 #include "pkgrules.h"
+#include "pluginInterface.h"
 
 class CAnalysis  {
 
@@ -28,9 +30,19 @@ private:
     /*! class pointer variable to handle config info  */     
     pkgrules *pRules = NULL;
     bool validateFlag = false;
+    /*! pipeline artifacts of the current request, NULL outside a pipeline */
+    artifacts_t *mpArtifacts = NULL;
+    /*! framework thread pool, NULL if the framework has none */
+    CTaskExecutor *mpExecutor = NULL;
+    /*! write the gap report file */
+    bool mbSave = true;
+    /*! set by handleCancel from another thread, polled between the analysis steps */
+    std::atomic<bool> mbCancel {false};
+    /*! cancel flag of the current request: the framework one, else mbCancel */
+    const std::atomic<bool> *mpCancel = &mbCancel;
     
     /*! function pointer */
-    typedef std::string (CAnalysis::*fPtr)(std::string);
+    typedef nlohmann::json (CAnalysis::*fPtr)(const nlohmann::json&);
     /*! map of functional pointers and http_request string */  
     std::map<std::string, fPtr> map_string_fPtr;
     
@@ -38,9 +50,11 @@ private:
     /** Load from config file if present*/
     bool readPkgRules(std::filesystem::path cfgPath);
     /*! handle API call */ 
-    std::string handleValidate(std::string message);
+    nlohmann::json handleValidate(const nlohmann::json& jReq);
     /*! handle API call */ 
-    std::string handleExecute(std::string message);
+    nlohmann::json handleExecute(const nlohmann::json& jReq);
+    /*! parse a snap file */ 
+    static nlohmann::json parseSnapfile(const std::filesystem::path& snapfile);
     /*! load the snap files */ 
     std::string loadSnapfiles(const std::string& filename = "");
 
@@ -57,7 +71,8 @@ public:
      /*! handle API info for status endpoint */ 
     std::string handleInfo(std::string sReq);
      /*! handle API for entry endpoint */ 
-    std::string handleEntry(std::string sReq);
+    nlohmann::json handleEntry(const nlohmann::json& jReq, artifacts_t* pArtifacts = NULL, CTaskExecutor* pExecutor = NULL,
+                               const std::atomic<bool>* pCancel = NULL);
      /** handleCancel*/
     std::string handleCancel(std::string sReq);
    
@@ -23,6 +23,7 @@
 #include <vector>
 #include <nlohmann/json.hpp>
 #include <map>
+#include "pluginInterface.h"
 
 class pkgrules
 {
@@ -48,12 +49,15 @@ public:
     
     /*! load the snap files for parsing */ 
     nlohmann::json load_snapfile(std::string snapfile);
+    /*! use an already parsed snap file in place, name as the file it replaces */ 
+    void load_snapjson(const nlohmann::json& snapjson, std::string snapname);
 
     /*! get the diff */
-    bool comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, bool flag);
+    bool comparefiles(const nlohmann::json& snapjson, const nlohmann::json& snapjson2, bool flag);
    /*! return the delta from snap files */
     const std::map<std::string, packageContent_t>& schemajsonOutput() const;
-    std::string generateReport(); 
+    /*! publish the report as pipeline artifact and/or write the report file */
+    std::string generateReport(artifacts_t* pArtifacts = NULL, bool bSave = true); 
 
 private:
 
@@ -85,7 +89,7 @@ private:
     bool getDiffRef();
 
 	/*! retrieve the metadata */
-    nlohmann::json readMetadata(nlohmann::json snapjson, std::string file);
+    nlohmann::json readMetadata(const nlohmann::json& snapjson, std::string file);
 
 
   
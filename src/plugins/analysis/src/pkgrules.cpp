@@ -29,6 +29,23 @@ pkgrules::pkgrules() {
 pkgrules::~pkgrules() {
 }
 
+/**
+ * member  : member of a snapshot object read in place, null if missing
+ *           (a snapshot may be a pipeline artifact, it is not copied or changed)
+ */
+static const nlohmann::json& member(const nlohmann::json& snapjson, const char* key)
+{
+    static const nlohmann::json jNull;
+    if (snapjson.is_null()) {
+        return jNull;
+    }
+    if (!snapjson.is_object()) {
+        return snapjson.at(key); //throws type_error
+    }
+    auto it = snapjson.find(key);
+    return it != snapjson.end() ? *it : jNull;
+}
+
 /**
  * load_snapfile  : snap file instances
  */
@@ -54,24 +71,31 @@ nlohmann::json pkgrules::load_snapfile(std::string snapfile)
     return snapInst;
 }
 
+/**
+ * load_snapjson  : snap file instance already in memory
+ */
+void pkgrules::load_snapjson(const nlohmann::json& snapjson, std::string snapname)
+{
+    readMetadata(snapjson, snapname);
+}
+
 /**
  * readMetadata  : read the content into the vector
  */
-nlohmann::json pkgrules::readMetadata(nlohmann::json snapjson, std::string file)
+nlohmann::json pkgrules::readMetadata(const nlohmann::json& snapjson, std::string file)
 {
     nlohmann::json snapInst;
 
     try {
          if(file.find("platform") != std::string::npos){
-          nlohmann::json meta_info = snapjson["metadata"]; 
-          pltmetainfo.date = meta_info["build"]["date"]; 
-          pltmetainfo.identifier = meta_info["identifier"]; 
-          pltmetainfo.version = meta_info["version"];
+          const nlohmann::json& meta_info = member(snapjson, "metadata"); 
+          pltmetainfo.date = member(member(meta_info, "build"), "date"); 
+          pltmetainfo.identifier = member(meta_info, "identifier"); 
+          pltmetainfo.version = member(meta_info, "version");
          } 
         //load the applicablity data
 	 if (snapjson.find("applicability") != snapjson.end()) {
-	         nlohmann::json applicabilityInfo = snapjson["applicability"];
-            applicability.push_back(applicabilityInfo);
+            applicability.push_back(snapjson.at("applicability"));
 
         }
 
@@ -86,7 +110,7 @@ nlohmann::json pkgrules::readMetadata(nlohmann::json snapjson, std::string file)
 /**
  * comparefiles  : compare the snap file instances
  */
-bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, bool flag) {  
+bool pkgrules::comparefiles(const nlohmann::json& snapjson, const nlohmann::json& snapjson2, bool flag) {  
 
   refcontent.clear();
   pltcontent.clear(); 
@@ -95,7 +119,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
   bVerbCheck = flag;
  
   try {
-       nlohmann::json platform_info = snapjson["platform info"];
+       const nlohmann::json& platform_info = member(snapjson, "platform info");
        for (const auto& item : platform_info) {
             for (auto it = item.begin(); it != item.end(); ++it) {
               // std::cout << "it.key()  " <<  it.key() << std::endl;
@@ -114,10 +138,10 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
                    }
 	      } 
          } 
-          nlohmann::json software_info = platform_info["software"];
+          const nlohmann::json& software_info = member(platform_info, "software");
 
           //iterate to read the name and version for dpkg 
-          nlohmann::json dpkg_info = software_info["dpkglist"];
+          const nlohmann::json& dpkg_info = member(software_info, "dpkglist");
            for (const auto& content : dpkg_info) {
                packageContent_t pltPkginfo;
               
@@ -127,8 +151,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
             }
         
           //iterate to get the local build data
-         nlohmann::json local_info = software_info["localInstall"];
-         const auto& locals = software_info["localInstall"];
+         const auto& locals = member(software_info, "localInstall");
          for (auto it = locals.begin(); it != locals.end(); ++it) {
             packageContent_t pltPkginfo;
             pltPkginfo.name = it.key();
@@ -136,7 +159,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
           }
 
       //read the golden snapshot file  
-      for (const auto& package : snapjson2["software"]["localInstall"]) 
+      for (const auto& package : member(member(snapjson2, "software"), "localInstall")) 
       {    
 	     packageContent_t goldenRefInfo;
 	     
@@ -153,7 +176,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
      //load the preact data from golden manifest
      if (snapjson2.find("preact") != snapjson2.end()) {
      
-        for (const auto& item : snapjson2["preact"]) {
+        for (const auto& item : snapjson2.at("preact")) {
              nlohmann::json preactInfo;
              preactInfo["desc"] = item["desc"];   
              preactInfo["action"] = item["action"]; 
@@ -163,7 +186,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
      }
      
      //read the snaplist 
-     nlohmann::json snap_info = software_info["snaplist"];
+     const nlohmann::json& snap_info = member(software_info, "snaplist");
      for (const auto& content : snap_info) {
           packageContent_t pltPkginfo;
               
@@ -172,7 +195,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
 	      pltcontent.push_back(pltPkginfo);
      }
      //read the appimage
-     nlohmann::json appimage_info = software_info["appimage"];
+     const nlohmann::json& appimage_info = member(software_info, "appimage");
      for (const auto& content : appimage_info) {
           packageContent_t pltPkginfo;
               
@@ -181,7 +204,7 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
 	      pltcontent.push_back(pltPkginfo);
      }
      //read the goldenconfig dpkglist
-      for (const auto& package : snapjson2["software"]["dpkglist"]) 
+      for (const auto& package : member(member(snapjson2, "software"), "dpkglist")) 
       {  //  std::cout << "reached here dpkglist golden:" << std::endl;
 	 packageContent_t goldenRefInfo;
 	     
@@ -190,11 +213,11 @@ bool pkgrules::comparefiles(nlohmann::json snapjson, nlohmann::json snapjson2, b
          refcontent.push_back(goldenRefInfo);
      }
         //get the snap2 
-        nlohmann::json ref_info = snapjson2["platform info"]; 
-        nlohmann::json softwareRef_info = ref_info["software"];
+        const nlohmann::json& ref_info = member(snapjson2, "platform info"); 
+        const nlohmann::json& softwareRef_info = member(ref_info, "software");
   
         //iterate to read the name and version for dpkg 
-        nlohmann::json dpkgRef_info = softwareRef_info["dpkglist"];
+        const nlohmann::json& dpkgRef_info = member(softwareRef_info, "dpkglist");
 
         for (const auto& content : dpkgRef_info) {
              packageContent_t refPkginfo;
@@ -288,7 +311,7 @@ const std::map<std::string, pkgrules::packageContent_t>& pkgrules::schemajsonOut
 /**
  * generateReport  : generate the gap report file
  */
-std::string pkgrules::generateReport()
+std::string pkgrules::generateReport(artifacts_t* pArtifacts, bool bSave)
 {
 
     std::string result;
@@ -328,13 +351,22 @@ std::string pkgrules::generateReport()
       jsonmanifest["act"] = contentOutput;
     
       //create the file
-      std::ofstream outputmanifestFile(reportFile, std::ios::out);
-      if (outputmanifestFile.is_open()) {
-          outputmanifestFile<< std::setw(1) << jsonmanifest << std::endl;
-          outputmanifestFile.close();
-          result = "created path: " + reportFile;
-      } else {
-          result = "failed to create report file " ;
+      if (bSave) {
+          std::ofstream outputmanifestFile(reportFile, std::ios::out);
+          if (outputmanifestFile.is_open()) {
+              outputmanifestFile<< std::setw(1) << jsonmanifest << std::endl;
+              outputmanifestFile.close();
+              result = "created path: " + reportFile;
+          } else {
+              return "failed to create report file " ;
+          }
+      }
+
+      if (pArtifacts) {
+          (*pArtifacts)[ARTIFACT_GAP_REPORT] = std::move(jsonmanifest);
+          if (!bSave) {
+              result = std::string("created artifact: ") + ARTIFACT_GAP_REPORT;
+          }
       }
 
     } catch (const std::exception& ex) {
@@ -29,7 +29,7 @@
  * @brief Creates an instance of the plugin.
  * @return A pointer to the created instance of the CPlugin class.
  */
-extern "C" CPluginInterface* create() {
+PLUGIN_FACTORY CPluginInterface* create() {
     return new CPlugin;
 }
 
@@ -37,10 +37,30 @@ extern "C" CPluginInterface* create() {
  * @brief Destroys the plugin object.
  * @param pPlugin A pointer to the plugin object to be destroyed.
  */
-extern "C" void destroy(CPluginInterface* pPlugin) {
+PLUGIN_FACTORY void destroy(CPluginInterface* pPlugin) {
     delete pPlugin;
 }
 
+/**
+ * @brief Creates an instance of the CPlugin class, version 2 interface.
+ *
+ * @return A pointer to the created instance of the CPlugin class.
+ */
+PLUGIN_FACTORY CPluginInterfaceV2* create_v2() {
+    return new CPlugin;
+}
+
+/**
+ * @brief Interface version the plugin was built against.
+ *
+ * @return PLUGIN_ABI_VERSION
+ */
+PLUGIN_FACTORY int abi_version() {
+    return PLUGIN_ABI_VERSION;
+}
+
+REGISTER_BUILTIN_PLUGIN("analysis")
+
 /**
  * \brief Default constructor for the CPlugin class.
  * \param[in] param A pointer to the parameter object.
@@ -75,12 +95,14 @@ std::string CPlugin::getInfo(void* pCxt) {
 /**
  * \brief Entry point for the analysis plugin.
  * \param pCxt A void pointer representing the context.
- * \param sReq A string representing the request.
- * \return A string representing the response.
+ * \param jReq The parsed request.
+ * \param sink Receives the response.
  */
-std::string CPlugin::entry(void* pCxt, std::string sReq) {
+void CPlugin::entryV2(void* pCxt, const nlohmann::json& jReq, CResponseSink& sink) {
     CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, " analysis service entry");
-    return pInstance->handleEntry(sReq);
+    CProgramContext* pCtx = (CProgramContext*)pCxt;
+    sink.write(pInstance->handleEntry(jReq, pCtx ? pCtx->pArtifacts : NULL, pCtx ? pCtx->pExecutor : NULL,
+                                      pCtx ? pCtx->pCancel : NULL));
 }
 
 /**
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <algorithm>
+
+#include "actionScheduler.h"
+
+CActionScheduler::CActionScheduler(std::vector<stScheduledAction> vActions) {
+    mActions = std::move(vActions);
+    mWaitingFor.assign(mActions.size(), 0);
+    mDependents.resize(mActions.size());
+    mStarted.assign(mActions.size(), false);
+    mFinished = 0;
+    for (size_t i = 0; i < mActions.size(); i++) {
+        std::vector<size_t>& vDepends = mActions[i].vDepends;
+        //only earlier actions, once each
+        std::vector<size_t> vValid;
+        for (size_t dep : vDepends) {
+            if (dep < i && std::find(vValid.begin(), vValid.end(), dep) == vValid.end()) {
+                vValid.push_back(dep);
+                mDependents[dep].push_back(i);
+            }
+        }
+        vDepends = std::move(vValid);
+        mWaitingFor[i] = vDepends.size();
+    }
+}
+
+size_t CActionScheduler::next() {
+    for (size_t i = 0; i < mActions.size(); i++) {
+        if (mStarted[i] || mWaitingFor[i] > 0) {
+            continue;
+        }
+        bool bFree = true;
+        for (size_t running : mRunning) {
+            for (const std::string& sHeld : mActions[running].vResources) {
+                for (const std::string& sWanted : mActions[i].vResources) {
+                    if (conflicts(sHeld, sWanted)) {
+                        bFree = false;
+                        break;
+                    }
+                }
+                if (!bFree) {
+                    break;
+                }
+            }
+            if (!bFree) {
+                break;
+            }
+        }
+        if (bFree) {
+            mStarted[i] = true;
+            mRunning.push_back(i);
+            return i;
+        }
+    }
+    return npos;
+}
+
+void CActionScheduler::finish(size_t index) {
+    auto it = std::find(mRunning.begin(), mRunning.end(), index);
+    if (it == mRunning.end()) {
+        return;
+    }
+    mRunning.erase(it);
+    mFinished++;
+    for (size_t dependent : mDependents[index]) {
+        mWaitingFor[dependent]--;
+    }
+}
+
+size_t CActionScheduler::running() const {
+    return mRunning.size();
+}
+
+bool CActionScheduler::isDone() const {
+    return mFinished == mActions.size();
+}
+
+bool CActionScheduler::conflicts(const std::string& sFirst, const std::string& sSecond) {
+    if (sFirst == sSecond || sFirst == SCHEDULER_RESOURCE_ALL || sSecond == SCHEDULER_RESOURCE_ALL) {
+        return true;
+    }
+    const size_t prefix = sizeof(SCHEDULER_RESOURCE_PATH) - 1;
+    if (sFirst.compare(0, prefix, SCHEDULER_RESOURCE_PATH) != 0 || sSecond.compare(0, prefix, SCHEDULER_RESOURCE_PATH) != 0) {
+        return false;
+    }
+    //a path and everything below it: /opt/x conflicts with /opt/x/y, not with /opt/xy
+    const std::string& sShort = sFirst.size() <= sSecond.size() ? sFirst : sSecond;
+    const std::string& sLong = sFirst.size() <= sSecond.size() ? sSecond : sFirst;
+    if (sLong.compare(0, sShort.size(), sShort) != 0) {
+        return false;
+    }
+    return sShort.back() == '/' || sLong[sShort.size()] == '/';
+}
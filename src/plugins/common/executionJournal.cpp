@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "executionJournal.h"
+
+CExecutionJournal::CExecutionJournal() {
+    mLastSync = std::chrono::steady_clock::now();
+}
+
+CExecutionJournal::~CExecutionJournal() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFd >= 0) {
+        syncLocked();
+        close(mFd);
+        mFd = -1;
+    }
+}
+
+bool CExecutionJournal::open(const std::string& sFile, const std::string& sContentHash) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    msFile = sFile;
+    mRecords.clear();
+    msLastNode.clear();
+    std::string sRecordedContent;
+    //records made for other content before the last "#content" line
+    bool bMixed = false;
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(sFile).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+
+    //complete lines only, the last one may have been cut off by a crash
+    off_t validBytes = 0;
+    {
+        std::ifstream file(sFile, std::ios::binary);
+        std::string sContent((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t pos = 0;
+        size_t end;
+        while ((end = sContent.find('\n', pos)) != std::string::npos) {
+            std::istringstream iss(sContent.substr(pos, end - pos));
+            if (sContent.compare(pos, sizeof(JOURNAL_CONTENT_TAG) - 1, JOURNAL_CONTENT_TAG) == 0) {
+                std::string sTag;
+                std::string sHash;
+                std::getline(iss, sTag, '\t');
+                std::getline(iss, sHash);
+                bMixed = bMixed || (!mRecords.empty() && sHash != sRecordedContent);
+                sRecordedContent = sHash;
+                pos = end + 1;
+                continue;
+            }
+            std::string sNode;
+            stJournalRecord record;
+            if (!std::getline(iss, sNode, '\t') || !std::getline(iss, record.sHash, '\t') ||
+                !(iss >> record.startMs >> record.endMs >> record.result)) {
+                break;
+            }
+            mRecords[sNode] = record;
+            msLastNode = sNode;
+            pos = end + 1;
+        }
+        validBytes = (off_t)pos;
+    }
+
+    mFd = ::open(sFile.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (mFd < 0) {
+        return false;
+    }
+    if (ftruncate(mFd, validBytes) != 0) {
+        close(mFd);
+        mFd = -1;
+        return false;
+    }
+    mUnsynced = 0;
+    mLastSync = std::chrono::steady_clock::now();
+    mbContentCurrent = mRecords.empty() ||
+                       (!bMixed && !sContentHash.empty() && sContentHash == sRecordedContent);
+    //the records from here on are made for this content
+    if (!sContentHash.empty() && sContentHash != sRecordedContent) {
+        std::string sLine = std::string(JOURNAL_CONTENT_TAG) + "\t" + sContentHash + "\n";
+        if (::write(mFd, sLine.data(), sLine.size()) == (ssize_t)sLine.size()) {
+            mUnsynced++;
+        }
+    }
+    return true;
+}
+
+size_t CExecutionJournal::size() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRecords.size();
+}
+
+bool CExecutionJournal::lookup(const std::string& sNode, const std::string& sHash, stJournalRecord& record) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mRecords.find(sNode);
+    if (it == mRecords.end() || it->second.sHash != sHash) {
+        return false;
+    }
+    record = it->second;
+    return true;
+}
+
+bool CExecutionJournal::lookup(const std::string& sNode, stJournalRecord& record) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mRecords.find(sNode);
+    if (it == mRecords.end()) {
+        return false;
+    }
+    record = it->second;
+    return true;
+}
+
+bool CExecutionJournal::isContentCurrent() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mbContentCurrent;
+}
+
+bool CExecutionJournal::last(std::string& sNode, stJournalRecord& record) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (msLastNode.empty()) {
+        return false;
+    }
+    sNode = msLastNode;
+    record = mRecords.at(msLastNode);
+    return true;
+}
+
+void CExecutionJournal::record(const std::string& sNode, const stJournalRecord& record) {
+    std::string sId = sNode;
+    for (char& c : sId) {
+        if (c == '\t' || c == '\n') {
+            c = ' ';
+        }
+    }
+    std::string sLine = sId + "\t" + record.sHash + "\t" + std::to_string(record.startMs) + "\t" +
+                        std::to_string(record.endMs) + "\t" + std::to_string(record.result) + "\n";
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRecords[sId] = record;
+    msLastNode = sId;
+    if (mFd < 0) {
+        return;
+    }
+    //one write per record: with O_APPEND a line is not mixed with another one
+    if (::write(mFd, sLine.data(), sLine.size()) != (ssize_t)sLine.size()) {
+        return; //the node runs again after a crash
+    }
+    mUnsynced++;
+    auto elapsed = std::chrono::steady_clock::now() - mLastSync;
+    if (mUnsynced >= JOURNAL_SYNC_RECORDS || elapsed >= std::chrono::milliseconds(JOURNAL_SYNC_MS)) {
+        syncLocked();
+    }
+}
+
+void CExecutionJournal::sync() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    syncLocked();
+}
+
+void CExecutionJournal::syncLocked() {
+    if (mFd >= 0 && mUnsynced > 0) {
+        fdatasync(mFd);
+    }
+    mUnsynced = 0;
+    mLastSync = std::chrono::steady_clock::now();
+}
+
+void CExecutionJournal::remove() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFd >= 0) {
+        close(mFd);
+        mFd = -1;
+    }
+    if (!msFile.empty()) {
+        std::remove(msFile.c_str());
+    }
+    mRecords.clear();
+    msLastNode.clear();
+    mUnsynced = 0;
+}
+
+std::string CExecutionJournal::hash(const std::string& sInput) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : sInput) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char sHex[17];
+    snprintf(sHex, sizeof(sHex), "%016llx", (unsigned long long)hash);
+    return sHex;
+}
+
+int64_t CExecutionJournal::nowMs() {
+    return (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
@@ -99,69 +99,13 @@ void CGraph::deinit() {
  * @param result will receive either 1 or 0. 0 means success and 1 means failure
  */
 Node* CGraph::receive_next_node(Node* current, int result) {
-    cout << endl;
-    cout << "Current Node Executed: " << current->data->param << endl;
-    cout << endl;
-
-    return traverseAndFindNextNode(vNodes[0], current, result);
-}
-
-/**
- * @brief Helper function to perform the traversal
- * @param result will receive either 1 or 0. 0 means success and 1 means failure
- */
-Node* CGraph::traverseAndFindNextNode(Node* node, Node* current, int result) {
-    if (!node) return endNode; // Return endNode if node is null
-
-    // If the current node is found, check for success or failure tags
-    if (node == current) {
-        // Case 1: If the node has onsuccess and the result is "success"
-        // result == 0 means the result is "success"
-        if (!node->data->onsuccess_tag.empty() && result == 0) {
-            if (!node->next_nodes.empty()) {
-                return node->next_nodes[0]; // Return the first next node
-            } else {
-                return endNode; // No next nodes, return endNode
-            }
-        }
-
-        // Case 2: If the node has onfailure
-        if (!node->data->onfailure_tag.empty()) {
-            // result == 1 means the result is "failure"
-            if (result == 1) {
-                if (!node->next_nodes.empty()) {
-                    return node->next_nodes[0]; // Return the first next node
-                } else {
-                    return endNode; // No next nodes, return endNode
-                }
-            }
-            // result == 0 means the result is "success"
-            else if (result == 0) {
-                if (!node->next_nodes.empty()) {
-                    return node->next_nodes[1]; // Return the second next node
-                } else {
-                    return endNode; // No next nodes, return endNode
-                }
-            }
-        }
+    if (!current) return endNode;
 
-        // Case 3: If no tags match or no tags are present, return the next node
-        if (!node->next_nodes.empty()) {
-            return node->next_nodes[0]; // Return the first next node
-        } else {
-            return endNode; // No next nodes, return endNode
-        }
-    }
-
-    // Recursively search in next nodes
-    for (Node* next : node->next_nodes) {
-        Node* resultNode = traverseAndFindNextNode(next, current, result);
-        if (resultNode != nullptr && resultNode != endNode) {
-            return resultNode; // Found the next node, return it
-        }
+    Node* branch = (result == 0) ? current->pOnSuccess : current->pOnFailure;
+    if (branch) {
+        return branch;
     }
-
-    return endNode; // If no next node is found, return endNode
+    return current->pNext ? current->pNext : endNode;
 }
 
 /**
@@ -389,15 +333,40 @@ int CGraph::printNode(Node* curNode) {
     return 0;
 }
 
+void CGraph::linkSuccessors(vector<Node*>& nodes, size_t i) {
+    Node* current = nodes[i];
+    current->pNext = (i + 1 < nodes.size()) ? nodes[i + 1] : endNode;
+
+    auto tagHead = [this](const string& tag) -> Node* {
+        auto it = mapGraphList.find(tag);
+        return (it != mapGraphList.end() && !it->second.empty()) ? it->second[0] : nullptr;
+    };
+    if (!current->data->onsuccess_tag.empty()) {
+        current->pOnSuccess = tagHead(current->data->onsuccess_tag);
+    }
+    if (!current->data->onfailure_tag.empty()) {
+        current->pOnFailure = tagHead(current->data->onfailure_tag);
+    }
+}
+
 void CGraph::handlingTag(Node* current, const string& tag) {
     // Check if the tag exists in the map
     if (mapGraphList.find(tag) != mapGraphList.end()) {
         // Get the corresponding list of nodes for the tag
         vector<Node*>& totalTagActions = mapGraphList[tag];
 
+        // Reached again from its own actions: a cycle, linked but not expanded again
+        if (!expandingTags.insert(tag).second) {
+            if (!totalTagActions.empty()) {
+                addEdge(current, totalTagActions[0]);
+            }
+            return;
+        }
+
         // Build a DAG for the actions inside the tag
         for (size_t i = 0; i < totalTagActions.size(); ++i) {
             Node* currentTagNode = totalTagActions[i];
+            linkSuccessors(totalTagActions, i);
 
             if (currentTagNode->data->onfailure_tag.empty() && currentTagNode->data->onsuccess_tag.empty()){
                 if (i + 1 < totalTagActions.size()) {
@@ -424,6 +393,8 @@ void CGraph::handlingTag(Node* current, const string& tag) {
             }
         }
 
+        expandingTags.erase(tag);
+
         // Link the original node to the first action of the tag
         if (!totalTagActions.empty()) {
             addEdge(current, totalTagActions[0]);
@@ -434,6 +405,7 @@ void CGraph::handlingTag(Node* current, const string& tag) {
 void CGraph::buildingDAG() {
     for (size_t i = 0; i < vNodes.size(); ++i) {
         Node* current = vNodes[i];
+        linkSuccessors(vNodes, i);
 
         // If no success/failure tags, just go to the next node
         if (current->data->onfailure_tag.empty() && current->data->onsuccess_tag.empty()) {
@@ -682,8 +654,12 @@ void CGraph::traverseAndPrintPaths(Node* node, vector<string>& path) {
     // Add current node to the path
     path.push_back(node->data->action + " " + node->data->param);
 
-    // If this is a leaf node, print the path
-    if (node->next_nodes.empty()) {
+    // If this is a leaf node, print the path; a path longer than the graph runs in a cycle
+    bool bCycle = path.size() > vNodesTotal.size() + 1;
+    if (bCycle) {
+        path.push_back("(cycle)");
+    }
+    if (node->next_nodes.empty() || bCycle) {
         for (size_t i = 0; i < path.size(); ++i) {
             cout << path[i];
             if (i < path.size() - 1) {
@@ -691,6 +667,9 @@ void CGraph::traverseAndPrintPaths(Node* node, vector<string>& path) {
             }
         }
         cout << endl;
+        if (bCycle) {
+            path.pop_back();
+        }
     } else {
         // Recursively visit all next nodes
         for (Node* next : node->next_nodes) {
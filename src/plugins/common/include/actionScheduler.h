@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+/** resource held by an action that conflicts with every other action */
+#define SCHEDULER_RESOURCE_ALL "*"
+/** prefix of a path resource, it conflicts with the same path, its parents and children */
+#define SCHEDULER_RESOURCE_PATH "path:"
+
+/** an action of a parallel run */
+struct stScheduledAction {
+    /** indices of the actions that have to finish first, lower than the own index */
+    std::vector<size_t> vDepends;
+    /** names of what the action changes; two running actions never share one */
+    std::vector<std::string> vResources;
+};
+
+/**
+ * Decides which actions of a list may run at the same time: an action starts
+ * once the actions it depends on are finished and none of the running actions
+ * holds a conflicting resource. Ready actions start in list order. It does not
+ * run anything, the caller starts the actions next() hands out and reports
+ * them with finish().
+ */
+class CActionScheduler {
+
+private:
+    std::vector<stScheduledAction> mActions;
+    /** per action: dependencies not finished yet */
+    std::vector<size_t> mWaitingFor;
+    /** per action: the actions that depend on it */
+    std::vector<std::vector<size_t>> mDependents;
+    std::vector<bool> mStarted;
+    /** started, not finished */
+    std::vector<size_t> mRunning;
+    size_t mFinished;
+
+public:
+    /** index of no action */
+    static const size_t npos = (size_t)-1;
+
+    /** dependencies on the own or later indices are dropped, the list cannot form a cycle */
+    explicit CActionScheduler(std::vector<stScheduledAction> vActions);
+
+    /** the first action that can start now, marked running; npos if there is none */
+    size_t next();
+
+    /** a running action is done, the actions depending on it may start */
+    void finish(size_t index);
+
+    size_t running() const;
+
+    /** all actions finished */
+    bool isDone() const;
+
+    /** resources that cannot be held at the same time: equal, SCHEDULER_RESOURCE_ALL, or
+     *  path resources where one path is the other or below it */
+    static bool conflicts(const std::string& sFirst, const std::string& sSecond);
+};
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/** records appended before they are synced to disk */
+#define JOURNAL_SYNC_RECORDS 8
+/** longest time a record stays unsynced (ms), checked when the next one is appended */
+#define JOURNAL_SYNC_MS 1000
+
+/** starts the line with the hash of the input the following records are made for */
+#define JOURNAL_CONTENT_TAG "#content"
+
+/** a node completed by an earlier run */
+struct stJournalRecord {
+    /** hash of the node input, a changed node is not taken as done */
+    std::string sHash;
+    /** wall clock, ms since the epoch */
+    int64_t startMs = 0;
+    int64_t endMs = 0;
+    int result = 0;
+};
+
+/**
+ * Append-only journal of the nodes a run completed, so that a run stopped by
+ * a reboot or a crash goes on where it stopped. One line per node, written
+ * with a single write: node id, input hash, start, end and result, separated
+ * by tabs. The file is synced every JOURNAL_SYNC_RECORDS records or
+ * JOURNAL_SYNC_MS, and on sync(); a line cut off by a crash is dropped when
+ * the journal is opened again. A "#content" line holds the hash of the input
+ * the records after it were made for, so an unchanged input is recognized
+ * without hashing every node again; once the input changed, the node hashes
+ * decide.
+ */
+class CExecutionJournal {
+
+private:
+    std::string msFile;
+    int mFd = -1;
+    mutable std::mutex mMutex;
+    std::unordered_map<std::string, stJournalRecord> mRecords;
+    std::string msLastNode;
+    bool mbContentCurrent = true;
+    size_t mUnsynced = 0;
+    std::chrono::steady_clock::time_point mLastSync;
+
+    //coverity
+    CExecutionJournal(CExecutionJournal const&) = delete;
+    void operator=(CExecutionJournal const&) = delete;
+
+    void syncLocked();
+
+public:
+    CExecutionJournal();
+    /** syncs and closes the file */
+    ~CExecutionJournal();
+
+    /**
+     * opens the journal, creates it and its directory if needed, and reads the
+     * records of an earlier run.
+     * @param sContentHash hash of the whole input of the run, recorded if it changed.
+     * @return false if it cannot be written.
+     */
+    bool open(const std::string& sFile, const std::string& sContentHash = std::string());
+    bool isOpen() const { return mFd >= 0; }
+
+    /** number of nodes recorded */
+    size_t size() const;
+
+    /** true and the record if sNode completed with the same input hash */
+    bool lookup(const std::string& sNode, const std::string& sHash, stJournalRecord& record) const;
+
+    /** true and the record if sNode completed; for an input known to be unchanged */
+    bool lookup(const std::string& sNode, stJournalRecord& record) const;
+
+    /**
+     * true if all records were made for the content hash given to open, or
+     * there are none. Records left from other content keep it false until the
+     * journal is removed.
+     */
+    bool isContentCurrent() const;
+
+    /** the node recorded last, false if there is none */
+    bool last(std::string& sNode, stJournalRecord& record) const;
+
+    /** appends the record of a completed node, safe from several threads */
+    void record(const std::string& sNode, const stJournalRecord& record);
+
+    /** writes the records appended so far to disk */
+    void sync();
+
+    /** closes and deletes the journal: the run is complete */
+    void remove();
+
+    /** stable 64 bit hash (FNV-1a) as hex, of node inputs and of journal names */
+    static std::string hash(const std::string& sInput);
+
+    /** wall clock now, ms since the epoch */
+    static int64_t nowMs();
+};
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>       // Stores key-value pairs and provides fast lookups.
+#include <unordered_set>
 #include <map>
 #include <iostream>
 #include <list>
@@ -47,6 +48,9 @@ struct Node {
     NodeData* data;
     void* pDataRef;
     vector<Node*> next_nodes;       // List of subsequent nodes to traverse.
+    Node* pNext = nullptr;          // Following node of the same list, the end node after the last.
+    Node* pOnSuccess = nullptr;     // First node of the on_success tag, if there is one.
+    Node* pOnFailure = nullptr;     // First node of the on_failure tag, if there is one.
     //vector<Node*> vNextNodes;       // List of subsequent nodes to traverse.
 };
 
@@ -58,6 +62,7 @@ class CGraph {
 
 private:
     map<int, list<int> > adjList; // Adjacency list to store the graph
+    unordered_set<string> expandingTags; // tags handlingTag is inside of, a tag reached again closes a cycle
 
 public:
     // Function to add an edge between vertices u and v of
@@ -131,8 +136,12 @@ public:
      */
     // Node* get_next_node(Node* current, const string& prev_node_result);
 
+    /**
+     * @brief Returns the node to run after current, in constant time.
+     * @param result 0 for success: the on_success tag, else the following node;
+     *               anything else for failure: the on_failure tag, else the following node.
+     */
     Node* receive_next_node(Node* current, int result);
-    Node* traverseAndFindNextNode(Node* node, Node* current, int result);
 
     int insertNewNode(void* data, NodeData* info);
     int insertNewNodeTags(void* data, const string& tagName, NodeData* info);
@@ -193,6 +202,13 @@ protected: //for unit test case access
 
     void handlingTag(Node* current, const string& tag);
 
+    /**
+     * @brief Sets the successors of a node of a list: following node and tag heads.
+     * @param nodes The list (main list or tag).
+     * @param i Index of the node in the list.
+     */
+    void linkSuccessors(vector<Node*>& nodes, size_t i);
+
     /**
      * @brief Traverses and prints all nodes in the graph.
      * @param nodeVectors A vector containing node vectors.
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+/** buckets per power of two (2^SUB_BITS) and the largest value recorded */
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#define LATENCY_HISTOGRAM_MAX_BITS 42
+#define LATENCY_HISTOGRAM_MAX ((uint64_t(1) << LATENCY_HISTOGRAM_MAX_BITS) - 1)
+
+/**
+ * Latency histogram in fixed memory, HDR style: values below 64 are counted
+ * exactly, above that every power of two is split into 32 buckets, so a
+ * recorded value is off by less than 1/32 (about 3%). Values are unitless,
+ * the caller picks ms or us. Values above LATENCY_HISTOGRAM_MAX are counted as
+ * LATENCY_HISTOGRAM_MAX.
+ */
+class CLatencyHistogram {
+
+private:
+    std::vector<uint64_t> mCounts;
+    uint64_t mTotal;
+    uint64_t mMin;
+    uint64_t mMax;
+    /** sum of the recorded values, for the mean */
+    double mSum;
+
+    static size_t indexOf(uint64_t value);
+    /** highest value counted in a bucket */
+    static uint64_t highestOf(size_t index);
+
+public:
+    CLatencyHistogram();
+
+    void record(uint64_t value);
+
+    /** adds the counts of another histogram */
+    void merge(const CLatencyHistogram& other);
+
+    uint64_t count() const;
+    uint64_t min() const;
+    uint64_t max() const;
+    double mean() const;
+
+    /**
+     * @param percentile 0 .. 100.
+     * @return the highest value of the bucket holding the percentile, 0 if empty.
+     */
+    uint64_t valueAtPercentile(double percentile) const;
+
+    /** count, min, max, mean, p50, p90, p99, p999 */
+    nlohmann::json toJson() const;
+};
@@ -48,6 +48,12 @@ class CManifestPropData {
 public:
     int retry = 0;
     std::string order;
+    /** cpu and i/o priority of all actions: nice, io_class, io_level, idle */
+    nlohmann::json priority;
+    /** actions of a phase running at the same time, 1 runs them one after another */
+    int parallel = 1;
+    /** downloads, repositories and apt packages are fetched in the background ahead of their actions */
+    bool prefetch = true;
    
     std::string tojsonString();
     int setValues(nlohmann::json jTag);
@@ -84,6 +90,17 @@ public:
     std::string expected; 
     std::string condition;
     std::string desc;
+    /** cpu and i/o priority of this action, over the one of the manifest */
+    nlohmann::json priority;
+    /** name other actions of the phase refer to in depends_on */
+    std::string id;
+    /** ids the action waits for when the manifest runs actions in parallel, null: the previous action */
+    nlohmann::json dependsOn;
+    /** what the action changes, null: derived from the verb */
+    nlohmann::json resources;
+    /** list the action is in: preact, act, postact or its tag, and its index there */
+    std::string phase;
+    size_t phaseIndex = 0;
     
     std::string tojsonString();
     int setValues(nlohmann::json jTag);
@@ -178,5 +195,6 @@ public:
     
     int WriteToFile(std::string filepath);
     int readFromFile(std::string filepath);
+    int readFromJson(const nlohmann::json& jsonManifestFileData);
     NodeData* convertManifestToNodeData(const CManifestActData& manifestData);
 };
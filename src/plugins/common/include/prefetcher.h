@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "process.h"
+
+/** output kept of a fetch command, it is not used */
+#define PREFETCH_MAX_OUTPUT (64 * 1024)
+
+/** runs a command as root; the result is not started if it cannot */
+typedef std::function<stProcessResult(const std::vector<std::string>&, const stProcessOptions&)> rootRunner_t;
+
+/**
+ * Fetches the artifacts of a deployment in the background while the actions
+ * before them run: files (http, https, ftp with wget; file:// is copied), git
+ * repositories (as mirror) and apt packages (apt-get install --download-only,
+ * into the apt cache). A fixed number of threads work on the items in the order
+ * they were added. An action waits for its item only while it is fetched; an
+ * item that has not started yet is dropped and the action fetches itself.
+ */
+class CPrefetcher {
+
+public:
+    enum ePrefetchKind {
+        ePREFETCH_URL,
+        ePREFETCH_GIT,
+        ePREFETCH_APT
+    };
+
+private:
+    enum eState {
+        /** waits for release() */
+        eHELD,
+        eQUEUED,
+        eRUNNING,
+        eDONE,
+        eFAILED,
+        /** its action did not wait for it */
+        eSKIPPED
+    };
+
+    struct stItem {
+        ePrefetchKind kind;
+        /** url or repository */
+        std::string sSource;
+        std::vector<std::string> vPackages;
+        /** file or mirror in the prefetch directory, empty for apt */
+        std::string sPath;
+        eState state;
+        long wallMs;
+    };
+
+    std::string msDir;
+    rootRunner_t mRunAsRoot;
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    /** items do not move when more are added */
+    std::deque<stItem> mItems;
+    std::vector<std::thread> mThreads;
+    bool mbStop;
+    /** stops the running fetches */
+    std::atomic<bool> mbCancel;
+
+    //coverity
+    CPrefetcher(CPrefetcher const&) = delete;
+    void operator=(CPrefetcher const&) = delete;
+
+    size_t add(stItem item);
+    void workerLoop();
+    /** runs without the lock; true if the item is there */
+    bool fetch(const stItem& item);
+
+public:
+    /**
+     * @param sDir directory for files and mirrors, created when needed.
+     * @param runAsRoot runs the apt pass; without it apt items fail.
+     */
+    explicit CPrefetcher(const std::string& sDir, rootRunner_t runAsRoot = rootRunner_t());
+
+    /** stop() */
+    ~CPrefetcher();
+
+    /** stops the running fetches and waits for the threads, the items left are not fetched */
+    void stop();
+
+    /** @return id of the item, for wait() */
+    size_t addUrl(const std::string& sUrl);
+    size_t addGit(const std::string& sRepository);
+    /** bHeld - not started before release(), e.g. until the package lists are updated */
+    size_t addApt(const std::vector<std::string>& vPackages, bool bHeld);
+
+    /** a held item may start */
+    void release(size_t id);
+
+    /** starts the threads; items added later are fetched as well */
+    void start(size_t threads);
+
+    /**
+     * waits while the item is fetched.
+     * @param bDrop an item that has not started is not fetched any more, else it stays queued.
+     * @return the file or mirror (empty for apt) and true if the item is there;
+     *         false if it failed or had not started.
+     */
+    bool wait(size_t id, std::string& sPath, bool bDrop = true);
+
+    /**
+     * waits until the item is fetched or failed, a queued item is not dropped
+     * and a held one waits for release(); it returns at stop() as well.
+     * @return the file or mirror (empty for apt) and true if the item is there.
+     */
+    bool waitFetched(size_t id, std::string& sPath);
+
+    /** kind, source, state and wall time of every item */
+    nlohmann::json toJson();
+};
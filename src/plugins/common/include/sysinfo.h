@@ -21,6 +21,7 @@
 
 #include <iostream>
 #include <vector>
+#include <nlohmann/json.hpp>
 #include "helper.h"
 
  struct sysinfoData {
@@ -48,7 +49,7 @@ private:
     bool getDistroInfo(std::string distroName,std::vector<std::string> osdistroversions,std::string pkgset );
     bool getPltInfo(std::vector<std::string> platversions);
     //bool getHWInfo(std::vector<std::string> platHW);
-    bool readSnapfile(sysinfoData& osInfo);
+    bool readSnapfile(sysinfoData& osInfo, const nlohmann::json* pSnapshot);
     std::string removeSpace(std::string& input);
     void trimKernelString(std::string& input);
 
@@ -58,7 +59,7 @@ public:
   /** info struct initialize*/
   //typedef sysinfoData systeminfoData ;
   
-  /** get the info **/
-  static bool getSysInfo(const sysinfoData& sysdata  );
+  /** get the info; snapshot is read from file unless already in memory **/
+  static bool getSysInfo(const sysinfoData& sysdata, const nlohmann::json* pSnapshot = NULL);
 };
 
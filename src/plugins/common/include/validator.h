@@ -21,11 +21,14 @@
 
 #include <iostream>
 #include <string>
+#include <nlohmann/json.hpp>
 
 /** validator class */
 class CValidator  {
 public:    
     /** Validates json data against schema **/
     static bool validateSchema(const std::string schemaFile, const std::string jsonData);
+    /** Validates json data already in memory against schema **/
+    static bool validateJson(const std::string schemaFile, const nlohmann::json& jsonData);
 };
 
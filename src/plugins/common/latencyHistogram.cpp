@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "latencyHistogram.h"
+
+#define SUB_BUCKETS (size_t(1) << LATENCY_HISTOGRAM_SUB_BITS)
+
+CLatencyHistogram::CLatencyHistogram() {
+    //exact values below 2 * SUB_BUCKETS, then SUB_BUCKETS per power of two up to the max
+    mCounts.resize(indexOf(LATENCY_HISTOGRAM_MAX) + 1, 0);
+    mTotal = 0;
+    mMin = 0;
+    mMax = 0;
+    mSum = 0;
+}
+
+size_t CLatencyHistogram::indexOf(uint64_t value) {
+    if (value < 2 * SUB_BUCKETS) {
+        return (size_t)value;
+    }
+    size_t msb = 63 - (size_t)__builtin_clzll(value);
+    size_t shift = msb - LATENCY_HISTOGRAM_SUB_BITS;
+    return shift * SUB_BUCKETS + (size_t)(value >> shift);
+}
+
+uint64_t CLatencyHistogram::highestOf(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    size_t shift = index / SUB_BUCKETS - 1;
+    uint64_t low = (uint64_t)(index - shift * SUB_BUCKETS) << shift;
+    return low + (uint64_t(1) << shift) - 1;
+}
+
+void CLatencyHistogram::record(uint64_t value) {
+    value = std::min(value, LATENCY_HISTOGRAM_MAX);
+    mCounts[indexOf(value)]++;
+    if (mTotal == 0 || value < mMin) {
+        mMin = value;
+    }
+    mMax = std::max(mMax, value);
+    mTotal++;
+    mSum += (double)value;
+}
+
+void CLatencyHistogram::merge(const CLatencyHistogram& other) {
+    if (other.mTotal == 0) {
+        return;
+    }
+    for (size_t i = 0; i < mCounts.size(); i++) {
+        mCounts[i] += other.mCounts[i];
+    }
+    mMin = mTotal == 0 ? other.mMin : std::min(mMin, other.mMin);
+    mMax = std::max(mMax, other.mMax);
+    mTotal += other.mTotal;
+    mSum += other.mSum;
+}
+
+uint64_t CLatencyHistogram::count() const {
+    return mTotal;
+}
+
+uint64_t CLatencyHistogram::min() const {
+    return mMin;
+}
+
+uint64_t CLatencyHistogram::max() const {
+    return mMax;
+}
+
+double CLatencyHistogram::mean() const {
+    return mTotal == 0 ? 0 : mSum / (double)mTotal;
+}
+
+uint64_t CLatencyHistogram::valueAtPercentile(double percentile) const {
+    if (mTotal == 0) {
+        return 0;
+    }
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t rank = (uint64_t)std::ceil(percentile / 100.0 * (double)mTotal);
+    rank = std::max(rank, uint64_t(1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < mCounts.size(); i++) {
+        seen += mCounts[i];
+        if (seen >= rank) {
+            //the bucket bound may be above anything recorded
+            return std::min(highestOf(i), mMax);
+        }
+    }
+    return mMax;
+}
+
+nlohmann::json CLatencyHistogram::toJson() const {
+    nlohmann::json jHist;
+    jHist["count"] = mTotal;
+    jHist["min"] = mMin;
+    jHist["max"] = mMax;
+    jHist["mean"] = std::round(mean() * 10) / 10;
+    jHist["p50"] = valueAtPercentile(50);
+    jHist["p90"] = valueAtPercentile(90);
+    jHist["p99"] = valueAtPercentile(99);
+    jHist["p999"] = valueAtPercentile(99.9);
+    return jHist;
+}
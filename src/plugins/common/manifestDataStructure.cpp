@@ -17,6 +17,7 @@
  *
  */
 
+#include <algorithm>
 #include<fstream>
 #include "validator.h"
 #include "manifestDataStructure.h"
@@ -208,11 +209,17 @@ int CManifestApplicabilityData::setValues(nlohmann::json jTag) {
 std::string CManifestPropData::tojsonString() {
     nlohmann::json jData;
     jData["retry"] = retry;
+    if(!priority.is_null()) { jData["priority"] = priority; }
+    jData["parallel"] = parallel;
+    jData["prefetch"] = prefetch;
     return jData.dump();
 }
 
 int CManifestPropData::setValues(nlohmann::json jTag) {
     if(jTag.contains("retry")) { retry = jTag.at("retry").get<std::int16_t>(); }
+    if(jTag.contains("priority") && jTag.at("priority").is_object()) { priority = jTag.at("priority"); }
+    if(jTag.contains("parallel")) { parallel = std::max(jTag.at("parallel").get<int>(), 1); }
+    if(jTag.contains("prefetch")) { prefetch = jTag.at("prefetch").get<bool>(); }
     return 0;
 }
 
@@ -230,6 +237,10 @@ int CManifestActData::setValues(nlohmann::json jTag) {
         if(jTag.contains("reference")) { reference = jTag.at("reference").get<std::string>(); }
         if(jTag.contains("on_failure")) { onFailure = jTag.at("on_failure").get<std::string>(); }
         if(jTag.contains("on_success")) { onSuccess = jTag.at("on_success").get<std::string>(); }
+        if(jTag.contains("priority") && jTag.at("priority").is_object()) { priority = jTag.at("priority"); }
+        if(jTag.contains("id")) { id = jTag.at("id").get<std::string>(); }
+        if(jTag.contains("depends_on") && jTag.at("depends_on").is_array()) { dependsOn = jTag.at("depends_on"); }
+        if(jTag.contains("resources") && jTag.at("resources").is_array()) { resources = jTag.at("resources"); }
         expected = "0";
         if(jTag.contains("expected")) { expected = jTag.at("expected").get<std::string>(); }
     
@@ -257,6 +268,10 @@ std::string CManifestActData::tojsonString() {
     jData["onSuccess"] = onSuccess;
     jData["expected"] = expected;    
     jData["condition"] = condition;     
+    if(!priority.is_null()) { jData["priority"] = priority; }
+    if(!id.empty()) { jData["id"] = id; }
+    if(!dependsOn.is_null()) { jData["depends_on"] = dependsOn; }
+    if(!resources.is_null()) { jData["resources"] = resources; }
         
     return jData.dump();
 }
@@ -412,7 +427,22 @@ int CPkgManifest::readFromFile(std::string filepath) {
             std::cout << "unable to open manifest file" << std::endl;
             return 1;
         }
-        
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    return readFromJson(jsonManifestFileData);
+}
+
+/**
+ * @brief Populates the data structure from an already parsed manifest.
+ * @param jsonManifestFileData The manifest content.
+ * @return Returns 0 if the manifest is successfully parsed, otherwise returns 1.
+ */
+int CPkgManifest::readFromJson(const nlohmann::json& jsonManifestFileData) {
+    
+    try {
         //fill in datastructure
         if(jsonManifestFileData.contains("meta")) {
             pPkgMetaData = new CManifestMetaData();
@@ -457,6 +487,8 @@ int CPkgManifest::readFromFile(std::string filepath) {
                 CManifestActData *pPreActDataItem = new CManifestActData();
                 if(pPreActDataItem) {
                     pPreActDataItem->setValues(it_preactitem);
+                    pPreActDataItem->phase = "preact";
+                    pPreActDataItem->phaseIndex = vPkgPreActData.size();
                     vPkgPreActData.push_back(pPreActDataItem);
                     graph.insertNewNode(pPreActDataItem, convertManifestToNodeData(*pPreActDataItem));
                 }
@@ -472,6 +504,8 @@ int CPkgManifest::readFromFile(std::string filepath) {
                 CManifestActData *pActDataItem = new CManifestActData();
                 if(pActDataItem) {
                     pActDataItem->setValues(it_actitem);
+                    pActDataItem->phase = "act";
+                    pActDataItem->phaseIndex = vPkgActData.size();
                     vPkgActData.push_back(pActDataItem);
                     graph.insertNewNode(pActDataItem, convertManifestToNodeData(*pActDataItem));
                 }
@@ -487,6 +521,8 @@ int CPkgManifest::readFromFile(std::string filepath) {
                 CManifestActData *pPostActDataItem = new CManifestActData();
                 if(pPostActDataItem) {
                     pPostActDataItem->setValues(it_postactitem);
+                    pPostActDataItem->phase = "postact";
+                    pPostActDataItem->phaseIndex = vPkgPostActData.size();
                     vPkgPostActData.push_back(pPostActDataItem);
                     graph.insertNewNode(pPostActDataItem, convertManifestToNodeData(*pPostActDataItem));
                 }
@@ -502,6 +538,8 @@ int CPkgManifest::readFromFile(std::string filepath) {
                     CManifestActData *pFaiSucActDataItem = new CManifestActData();
                     if (pFaiSucActDataItem) {
                         pFaiSucActDataItem->setValues(act);
+                        pFaiSucActDataItem->phase = tag;
+                        pFaiSucActDataItem->phaseIndex = vPkgFaiSucActData[tag].size();
                         vPkgFaiSucActData[tag].push_back(pFaiSucActDataItem);
                         graph.insertNewNodeTags(pFaiSucActDataItem, tag, convertManifestToNodeData(*pFaiSucActDataItem));
                     }
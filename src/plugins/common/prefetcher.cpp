@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+
+#include "prefetcher.h"
+
+CPrefetcher::CPrefetcher(const std::string& sDir, rootRunner_t runAsRoot) {
+    msDir = sDir;
+    mRunAsRoot = std::move(runAsRoot);
+    mbStop = false;
+    mbCancel = false;
+}
+
+CPrefetcher::~CPrefetcher() {
+    stop();
+}
+
+void CPrefetcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mbStop = true;
+        mbCancel = true;
+    }
+    mCond.notify_all();
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+    mThreads.clear();
+}
+
+size_t CPrefetcher::add(stItem item) {
+    item.wallMs = 0;
+    if (item.kind != ePREFETCH_APT) {
+        //the name of the source, made unique by its hash
+        std::string sName = item.sSource;
+        while (!sName.empty() && sName.back() == '/') {
+            sName.pop_back();
+        }
+        sName = sName.substr(sName.find_last_of('/') + 1);
+        std::ostringstream oss;
+        oss << std::hex << std::hash<std::string>()(item.sSource) << "-" << sName;
+        item.sPath = (std::filesystem::path(msDir) / oss.str()).generic_string();
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mItems.push_back(std::move(item));
+    mCond.notify_one();
+    return mItems.size() - 1;
+}
+
+size_t CPrefetcher::addUrl(const std::string& sUrl) {
+    return add({ePREFETCH_URL, sUrl, {}, "", eQUEUED, 0});
+}
+
+size_t CPrefetcher::addGit(const std::string& sRepository) {
+    return add({ePREFETCH_GIT, sRepository, {}, "", eQUEUED, 0});
+}
+
+size_t CPrefetcher::addApt(const std::vector<std::string>& vPackages, bool bHeld) {
+    return add({ePREFETCH_APT, "", vPackages, "", bHeld ? eHELD : eQUEUED, 0});
+}
+
+void CPrefetcher::release(size_t id) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (id < mItems.size() && mItems[id].state == eHELD) {
+        mItems[id].state = eQUEUED;
+        mCond.notify_all();
+    }
+}
+
+void CPrefetcher::start(size_t threads) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    while (mThreads.size() < threads) {
+        mThreads.emplace_back(&CPrefetcher::workerLoop, this);
+    }
+}
+
+bool CPrefetcher::wait(size_t id, std::string& sPath, bool bDrop) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (id >= mItems.size()) {
+        return false;
+    }
+    stItem& item = mItems[id];
+    if (item.state == eHELD || item.state == eQUEUED) {
+        if (!bDrop) {
+            return false;
+        }
+        item.state = eSKIPPED;
+    }
+    mCond.wait(lock, [&item] { return item.state != eRUNNING; });
+    sPath = item.sPath;
+    return item.state == eDONE;
+}
+
+bool CPrefetcher::waitFetched(size_t id, std::string& sPath) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (id >= mItems.size()) {
+        return false;
+    }
+    stItem& item = mItems[id];
+    mCond.wait(lock, [this, &item] {
+        return item.state == eDONE || item.state == eFAILED || item.state == eSKIPPED ||
+               (mbStop && item.state != eRUNNING);
+    });
+    sPath = item.sPath;
+    return item.state == eDONE;
+}
+
+void CPrefetcher::workerLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mbStop) {
+        stItem* pItem = NULL;
+        for (stItem& item : mItems) {
+            if (item.state == eQUEUED) {
+                pItem = &item;
+                break;
+            }
+        }
+        if (!pItem) {
+            mCond.wait(lock);
+            continue;
+        }
+        pItem->state = eRUNNING;
+        stItem item = *pItem;
+        lock.unlock();
+
+        auto started = std::chrono::steady_clock::now();
+        bool bFetched = fetch(item);
+        long wallMs = (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+
+        lock.lock();
+        pItem->state = bFetched ? eDONE : eFAILED;
+        pItem->wallMs = wallMs;
+        mCond.notify_all();
+    }
+}
+
+bool CPrefetcher::fetch(const stItem& item) {
+    stProcessOptions options;
+    options.pCancel = &mbCancel;
+    options.maxOutput = PREFETCH_MAX_OUTPUT;
+
+    if (item.kind == ePREFETCH_APT) {
+        if (!mRunAsRoot) {
+            return false;
+        }
+        std::vector<std::string> vArgs = {"apt-get", "install", "--download-only", "-y"};
+        vArgs.insert(vArgs.end(), item.vPackages.begin(), item.vPackages.end());
+        return mRunAsRoot(vArgs, options).succeeded();
+    }
+
+    //fetched to <path>.part, a file or mirror in place is complete
+    std::string sPart = item.sPath + ".part";
+    try {
+        std::filesystem::create_directories(msDir);
+        std::filesystem::remove_all(sPart);
+        if (item.kind == ePREFETCH_GIT) {
+            if (std::filesystem::exists(item.sPath)) {
+                return CProcess::run({"git", "--git-dir=" + item.sPath, "remote", "update", "--prune"}, options).succeeded();
+            }
+            if (!CProcess::run({"git", "clone", "--mirror", "--quiet", item.sSource, sPart}, options).succeeded()) {
+                return false;
+            }
+        } else if (item.sSource.compare(0, 7, "file://") == 0) {
+            std::filesystem::copy_file(item.sSource.substr(7), sPart);
+        } else if (!CProcess::run({"wget", "-q", "-O", sPart, item.sSource}, options).succeeded()) {
+            std::filesystem::remove(sPart);
+            return false;
+        }
+        std::filesystem::remove_all(item.sPath);
+        std::filesystem::rename(sPart, item.sPath);
+    } catch (const std::exception&) {
+        std::error_code ec;
+        std::filesystem::remove_all(sPart, ec);
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json CPrefetcher::toJson() {
+    static const char* kinds[] = {"url", "git", "apt"};
+    static const char* states[] = {"held", "queued", "running", "done", "failed", "skipped"};
+    nlohmann::json jItems = nlohmann::json::array();
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const stItem& item : mItems) {
+        nlohmann::json jItem;
+        jItem["kind"] = kinds[item.kind];
+        jItem["source"] = item.kind == ePREFETCH_APT ? nlohmann::json(item.vPackages) : nlohmann::json(item.sSource);
+        jItem["state"] = states[item.state];
+        jItem["wall_ms"] = item.wallMs;
+        jItems.push_back(std::move(jItem));
+    }
+    return jItems;
+}
@@ -26,9 +26,10 @@
 
 /*
  * readSnapfile: Read the data from the platform snapshot file
+ * @param: pSnapshot - snapshot already in memory, file is read if NULL
  * @return: bool
  */
-bool CSysInfo::readSnapfile(sysinfoData& osInfo)
+bool CSysInfo::readSnapfile(sysinfoData& osInfo, const nlohmann::json* pSnapshot)
 {
     nlohmann::json snapInst;
 
@@ -38,28 +39,33 @@ bool CSysInfo::readSnapfile(sysinfoData& osInfo)
     std::filesystem::path PlatSnapFile = currentToolPath / "platform-snapshot.json";
 
   try {
-         if (!std::filesystem::exists(PlatSnapFile)) {
+         if (!pSnapshot && !std::filesystem::exists(PlatSnapFile)) {
            return false;
         }
         std::ifstream fileHandler;
-        fileHandler.open(PlatSnapFile);
+        if (!pSnapshot) {
+            fileHandler.open(PlatSnapFile);
+        }
         
-	    if (fileHandler.is_open()) {
-	        fileHandler >> snapInst;
-	        if(snapInst.empty() ) {
+	    if (pSnapshot || fileHandler.is_open()) {
+	        if (!pSnapshot) {
+	            fileHandler >> snapInst;
+	        }
+	        const nlohmann::json& snap = pSnapshot ? *pSnapshot : snapInst;
+	        if(snap.empty() ) {
 	           fileHandler.close();
               return false;
           } else
           {
-               nlohmann::json platform_info = snapInst["platform info"]; 
-               pltinfo.kversion = platform_info["kernel"]["version"];
-               std::string name = platform_info["os"]["name"]; 
-               available = platform_info["storage"]["available"]; 
-               pltName = platform_info["hardware"]["platform"]; 
+               const nlohmann::json& platform_info = snap.at("platform info"); 
+               pltinfo.kversion = platform_info.at("kernel").at("version");
+               std::string name = platform_info.at("os").at("name"); 
+               available = platform_info.at("storage").at("available"); 
+               pltName = platform_info.at("hardware").at("platform"); 
 
                trimKernelString(pltinfo.kversion);
 
-               osVersion = platform_info["os"]["version"]; 
+               osVersion = platform_info.at("os").at("version"); 
                osVersion = removeSpace(osVersion);
                removeSpace(name);
                pltinfo.distro = Helper::to_lower_copy(name);
@@ -259,7 +265,7 @@ bool CSysInfo::getPltInfo(std::vector<std::string> platversions)
  * @param: struct
  * @return: bool
  */ 
-bool CSysInfo::getSysInfo(const sysinfoData& sysdata ) {
+bool CSysInfo::getSysInfo(const sysinfoData& sysdata, const nlohmann::json* pSnapshot) {
 
   CSysInfo systemInfos;
   std::string diskspace;
@@ -267,7 +273,7 @@ bool CSysInfo::getSysInfo(const sysinfoData& sysdata ) {
   sysinfoData osInfo;
 
     try {
-        systemInfos.readSnapfile(osInfo);
+        systemInfos.readSnapfile(osInfo, pSnapshot);
         if(sysdata.pkgsets == "gimp") { 
           
           bool value = systemInfos.getKernelVersion(sysdata.kversion );
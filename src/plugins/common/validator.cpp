@@ -25,9 +25,9 @@
 
 bool CValidator::validateSchema(const std::string schemaFile, const std::string jsonDataFile) {
 
+    nlohmann::json jsonDataFileContents;
     try {
         //open data file
-        nlohmann::json jsonDataFileContents;
         std::ifstream dFile(jsonDataFile);
         if (dFile.is_open()) {
             jsonDataFileContents = nlohmann::json::parse(dFile);
@@ -36,9 +36,18 @@ bool CValidator::validateSchema(const std::string schemaFile, const std::string
             std::cout << "Error: Invalid data"  << std::endl;
             return false;
         }
+    } catch (const std::exception& e) {
+        std::cout << "Error: Invalid data"  << std::endl;
+        return false;
+    }
        
-        //todo:return if file is empty or data is null/not in json format.
-        
+    //todo:return if file is empty or data is null/not in json format.
+    return validateJson(schemaFile, jsonDataFileContents);
+}
+
+bool CValidator::validateJson(const std::string schemaFile, const nlohmann::json& jsonDataFileContents) {
+
+    try {
         //open schema file
         nlohmann::json schemaFileContents;
         std::ifstream sFile(schemaFile);
@@ -17,11 +17,35 @@
  *
  */
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
 #include "apihandlers.h"
 #include "sysinfo.h"
+#include "process.h"
+#include "deploy_definitions.h"
+#include "outputCapture.h"
+#include "actionScheduler.h"
+
+/** set on the threads of runParallel: commands run on them instead of the framework pool */
+static thread_local bool tlbActionThread = false;
 
 
-CAPIHandlers::CAPIHandlers() {
+CAPIHandlers::CAPIHandlers(artifacts_t* pArtifacts, const std::atomic<bool>* pCancelRequest, CResponseSink* pSink,
+                           CTaskExecutor* pExecutor) {
+    _pArtifacts = pArtifacts;
+    _pCancelRequest = pCancelRequest;
+    _pSink = pSink;
+    _pExecutor = pExecutor;
     init();
 }
 
@@ -39,11 +63,24 @@ int CAPIHandlers::init() {
  
     _bCancel = false; 
     m_continueCount = 0;
+    m_actionCount = 0;
+    _bRebootPending = false;
     
     map_string_fPtr["EXECUTE"] = &CAPIHandlers::executeScript;
 
     pCmdDict = new CCommandReference();
     pPkgAction = new CPkgActions();
+
+    try {
+        std::filesystem::path priorityFile = std::filesystem::current_path() / "config" / DEPLOY_PRIORITY_FILE;
+        if (std::filesystem::exists(priorityFile)) {
+            std::ifstream file(priorityFile);
+            _jPriorityConfig = nlohmann::json::parse(file);
+        }
+    } catch (const std::exception& e) {
+        logMsg(std::string("priority config ignored: ") + e.what());
+        _jPriorityConfig = nlohmann::json();
+    }
           
     return 0;
 }
@@ -70,6 +107,8 @@ int CAPIHandlers::deinit() {
         delete _pManifest;
         _pManifest = NULL; 
     }  
+
+    _privHelpers.stop();
        
   return 0;
 }
@@ -105,6 +144,24 @@ int CAPIHandlers::startDeploy(std::string manifestPath, int continueCount) {
     return coreHandler(manifestPath, false, sArchiveDir);
 }
 
+/**
+ * Starts the deployment process from a manifest already in memory.
+ * Relative paths in the manifest are resolved against the current path.
+ *
+ * @param jManifest The manifest content.
+ * @param continueCount The number of times the deployment process should continue.
+ * @return Returns the result of the coreHandler function.
+ */
+int CAPIHandlers::startDeploy(const nlohmann::json& jManifest, int continueCount) {
+    m_continueCount = continueCount;
+    _pManifestData = &jManifest;
+
+    std::string sManifestPath = (std::filesystem::current_path() / "pkg-manifest.json").generic_string();
+    sArchiveDir = std::filesystem::current_path().generic_string();
+    _bCancel = false; 
+    return coreHandler(sManifestPath, false, sArchiveDir);
+}
+
 /**
  * @brief Handles the core functionality of the API handlers.
  * @param manifestPath The path to the manifest file.
@@ -117,10 +174,11 @@ int CAPIHandlers::coreHandler(std::string manifestPath, bool bPrepare, std::stri
     //std::cout << "processing manifest :" << manifestPath <<  std::endl;
     
     bool bSuccess = true;
+    bool bStop = false; //not applicable or waiting for a reboot, included manifests are not started
     
     try {
         
-        if(!manifestPath.empty() && !std::filesystem::exists(manifestPath)) {
+        if(!_pManifestData && !manifestPath.empty() && !std::filesystem::exists(manifestPath)) {
             //todo check for permissions, validate against schema
             //todo handle error. open: should we continue to other manifest or stop here.
             return 1;
@@ -133,135 +191,29 @@ int CAPIHandlers::coreHandler(std::string manifestPath, bool bPrepare, std::stri
         _pManifest = new CPkgManifest();
         
         if(_pManifest) {
-            _pManifest->readFromFile(manifestPath);
-
-            cout << endl;
-            cout << "########################## FOLLOWING A PATH ###############################" << endl;
-            cout << endl;
-            cout << endl;
-
-            SNode = _pManifest->graph.vNodes[0];
-            while (SNode != _pManifest->graph.endNode) {
-
-                int tempVariable = rValue(static_cast<CManifestActData*>(SNode->pDataRef), bPrepare);
-
-                Node* getNextNode = _pManifest->graph.receive_next_node(SNode, tempVariable);
-
-                SNode = getNextNode;
-
-                cout << "Next Node Param: " << SNode->data->param << endl;
-                cout << endl;
+            if (_pManifestData) {
+                _pManifest->readFromJson(*_pManifestData);
+            } else {
+                _pManifest->readFromFile(manifestPath);
             }
-            
-            //std::cout << "updating status " << std::endl;
-            
-            //CStatusInfo::getInstance()->setStatus(DEPLOY_STATUS, "{ \"status\": \"deploy\",\"desc\":\"manifest file loaded\" ,\"progress\":\"10\"}");
-            
-            //todo: clean up
-            /*if(pCmdDict && _pManifest->vPkgReferData.size() > 0) {
-                pCmdDict->updateDict(_pManifest->vPkgReferData);
-            }*/
-            //todo: print active dict to confirm.
-
-            //std::cout << "handle actions" << std::endl;
-            //preact
-
-            cout << endl;
-            cout << "########################## FOLLOWING SEQUENTIAL ORDER ###############################" << endl;
-            cout << endl;
-            cout << endl;
-
-            //std::cout << "handle actions" << std::endl;
-            //preact
-            std::vector<CManifestActData*>::iterator pre_it;
-            int rebootActionCounter = 0;
-            for(pre_it = _pManifest->vPkgPreActData.begin(); pre_it != _pManifest->vPkgPreActData.end(); pre_it++ )    {
-                CManifestActData *pData = (CManifestActData*)*pre_it;
-                if(pData) {
-                    if(strcmp("REBOOT", pData->action.c_str()) == 0) {
-                        continue; //reboot not allowed in pre and post act - ignore
-                    }
-                    //precheck for system information 
-                    if(strcmp("PRE_CHECK", pData->action.c_str()) == 0) {
-                        std::string pkgset = pData->param.c_str();
-                       
-                        if(!getApplicablityData(pkgset)){
-                           return 0;
-                        }
-                    }
 
-                    handleAction(pData, bPrepare);
-                }
-                if (_bCancel == true){
-                            
-                    break; 
-                }
-            }
-            if (_bCancel != true){
-
-                //act
-                std::vector<CManifestActData*>::iterator act_it;
-                for(act_it = _pManifest->vPkgActData.begin(); act_it != _pManifest->vPkgActData.end(); act_it++ )    {
-                    CManifestActData *pData = (CManifestActData*)*act_it;
-                    if(pData) {
-                        //logic: if count == 0 execute till first reboot or end of manifest.
-                        //if count == n skip actions until n reboots or end; execute till n+1 reboot or end. skip remaining actions if any
-                        //example: if count == 1 skip actions until reboot or end; execute till next reboot if not end or until end.
-                        
-                        if (m_continueCount == 0 ) {
-                            if(strcmp("REBOOT", pData->action.c_str()) == 0) {
-                                 logMsg("## Please reboot to proceed ## " );
-                                //break; //stop execution of whole manifest here. to be continued after reboot.//throw expection and catch
-                                throw; //stop execution of whole manifest here. to be continued after reboot
-                            }
-                        } else if (m_continueCount > rebootActionCounter) {
-                            if(strcmp("REBOOT", pData->action.c_str()) != 0) {
-                                continue;//if action is not reboot - skip
-                            } else {
-                                rebootActionCounter++;
-                                 if ((m_continueCount + 1) <= rebootActionCounter) {
-                                    throw; //stop execution of whole manifest here. to be continued after reboot
-                                } 
-                            }
-                        }
-                    
-                        handleAction(pData, bPrepare);
-                    }
-                    if (_bCancel == true){
-                            
-                        break; 
-                    }                
-                }
+            openJournal(manifestPath, bPrepare);
+            startPrefetch(bPrepare);
+            if (!runGraph(bPrepare)) {
+                bStop = true;
             }
-            
-            if (_bCancel != true){            
-               
-                //postact
-                std::vector<CManifestActData*>::iterator post_it;
-                for(post_it = _pManifest->vPkgPostActData.begin(); post_it != _pManifest->vPkgPostActData.end(); post_it++ )    {
-                    CManifestActData *pData = (CManifestActData*)*post_it;
-                    if(pData) {
-                        if(strcmp("REBOOT", pData->action.c_str()) == 0) {
-                            continue; //reboot not allowed in pre and post act - ignore
-                        }
-                        handleAction(pData, bPrepare);
-                    }
-                    if (_bCancel == true){
-                       
-                        break; 
-                    }                   
-                }
-                
+            if (_pJournal && !_bRebootPending && !isCancelled()) {
+                _pJournal->remove(); //complete, the next run starts over
             }
          }
     } catch (const std::exception &e) {
         std::cout << e.what() << "error executing actions" << std::endl;
         bSuccess = false;
-    } catch (...) {
-        std::cout << "Reboot exception - program " << std::endl;       
     }
     
     //cleanup
+    stopPrefetch();
+    closeJournal();
     if (_pManifest) {
         delete _pManifest;
         _pManifest = NULL;
@@ -271,6 +223,12 @@ int CAPIHandlers::coreHandler(std::string manifestPath, bool bPrepare, std::stri
     if(bSuccess == false) {
         return 1;
     }
+    if (_pCancelRequest && *_pCancelRequest) {
+        return 1; //included manifests are not started either
+    }
+    if (bStop) {
+        return 0;
+    }
     //remove process manifest file.
     if(!qIncludedManifests.empty()){
         std::cout << "remove processed manifest file" << std::endl;
@@ -285,12 +243,448 @@ int CAPIHandlers::coreHandler(std::string manifestPath, bool bPrepare, std::stri
     return 0;
 }
 
+/**
+ * Package actions that can be merged into one apt/dpkg transaction: INSTALL,
+ * REMOVE and LOCAL_INSTALL with packages, without tags and without an expected
+ * value other than success, since their own result would be lost; their
+ * resources are derived. The actions after the first must not name
+ * dependencies, they follow the one before them.
+ *
+ * @param vNodes actions of a phase, in order.
+ * @param first the first action of the batch.
+ * @return the number of actions from first on that run as one transaction, 1 if none is merged.
+ */
+static size_t packageBatchSize(const std::vector<Node*>& vNodes, size_t first) {
+    auto batchable = [](const CManifestActData* pData) {
+        return (pData->action == "INSTALL" || pData->action == "REMOVE" || pData->action == "LOCAL_INSTALL") &&
+               !pData->param.empty() && pData->onFailure.empty() && pData->onSuccess.empty() &&
+               (pData->expected.empty() || pData->expected == "0") && pData->condition.empty() &&
+               pData->resources.is_null();
+    };
+    const CManifestActData* pFirst = static_cast<CManifestActData*>(vNodes[first]->pDataRef);
+    if (!batchable(pFirst)) {
+        return 1;
+    }
+    size_t end = first + 1;
+    while (end < vNodes.size()) {
+        const CManifestActData* pData = static_cast<CManifestActData*>(vNodes[end]->pDataRef);
+        if (pData->action != pFirst->action || pData->phase != pFirst->phase || !batchable(pData) ||
+            !pData->dependsOn.is_null()) {
+            break;
+        }
+        end++;
+    }
+    return end - first;
+}
+
+/** node of an action in the journal: its list and index there */
+static std::string journalId(const CManifestActData* pActItem) {
+    return pActItem->phase + "/" + std::to_string(pActItem->phaseIndex);
+}
+
+/**
+ * The graph node of a journal id, found from the list and index it names.
+ *
+ * @return NULL if the manifest has no such action.
+ */
+static Node* journalNode(CPkgManifest& manifest, const std::string& sId) {
+    size_t sep = sId.rfind('/');
+    if (sep == std::string::npos) {
+        return NULL;
+    }
+    std::string sPhase = sId.substr(0, sep);
+    size_t index = (size_t)std::strtoul(sId.c_str() + sep + 1, NULL, 10);
+    CGraph& graph = manifest.graph;
+    Node* pNode = NULL;
+    if (sPhase == "preact" || sPhase == "act" || sPhase == "postact") {
+        size_t offset = sPhase == "preact" ? 0 : sPhase == "act" ? manifest.vPkgPreActData.size() :
+                        manifest.vPkgPreActData.size() + manifest.vPkgActData.size();
+        if (offset + index < graph.vNodes.size()) {
+            pNode = graph.vNodes[offset + index];
+        }
+    } else {
+        auto it = graph.mapGraphList.find(sPhase);
+        if (it != graph.mapGraphList.end() && index < it->second.size()) {
+            pNode = it->second[index];
+        }
+    }
+    if (pNode && journalId(static_cast<CManifestActData*>(pNode->pDataRef)) != sId) {
+        return NULL;
+    }
+    return pNode;
+}
+
+/**
+ * Runs the actions of the manifest once, along its graph: preact, act and
+ * postact in order; after an action its on_success or on_failure tag when the
+ * manifest has it, else the following action. A tag ends the run after its
+ * last action.
+ * Every completed action goes to the journal (openJournal). An action the
+ * journal has, with the same content, is not run again: its recorded result
+ * selects the next action. Run one at a time, the run goes on right after the
+ * action recorded last.
+ * REBOOT in act is a checkpoint: the run records it and stops at the first one
+ * not passed yet. Without a journal m_continueCount counts the reboots done and
+ * the act actions before the passed checkpoints are skipped. REBOOT in preact
+ * and postact is ignored.
+ * With "parallel" in prop the actions between REBOOT and PRE_CHECK run
+ * through runParallel. Consecutive package actions of a verb run as one
+ * transaction, see packageBatchSize.
+ *
+ * @param bPrepare A boolean flag indicating whether to prepare for deployment or not.
+ * @return false if the run stopped for a reboot or because the manifest is not applicable.
+ * @throws std::runtime_error if on_success and on_failure tags form a cycle.
+ */
+bool CAPIHandlers::runGraph(bool bPrepare) {
+    CGraph& graph = _pManifest->graph;
+    if (graph.vNodes.empty()) {
+        return true;
+    }
+    auto phaseSize = [this](const std::string& sPhase) -> size_t {
+        if (sPhase == "preact") {
+            return _pManifest->vPkgPreActData.size();
+        } else if (sPhase == "act") {
+            return _pManifest->vPkgActData.size();
+        } else if (sPhase == "postact") {
+            return _pManifest->vPkgPostActData.size();
+        }
+        return _pManifest->vPkgFaiSucActData[sPhase].size();
+    };
+
+    int parallel = _pManifest->pPkgPropData ? _pManifest->pPkgPropData->parallel : 1;
+    //one helper per action running at the same time, sudo commands do not wait for each other
+    _privHelpers.setMax((size_t)std::clamp(parallel, 1, DEPLOY_PARALLEL_MAX));
+    int reboots = 0;
+    std::unordered_set<Node*> visited;
+    Node* pNode = graph.vNodes[0];
+    std::string sLastNode;
+    stJournalRecord lastRecord;
+    //with records the journal tells which actions before the last reboot are done, changed ones run
+    bool bJournalRecords = _pJournal && _pJournal->size() > 0;
+    //after a change of the manifest the actions are walked from the start, changed ones run again
+    if (parallel <= 1 && _bJournalCurrent && _pJournal->last(sLastNode, lastRecord)) {
+        Node* pLast = journalNode(*_pManifest, sLastNode);
+        CManifestActData* pLastData = pLast ? static_cast<CManifestActData*>(pLast->pDataRef) : NULL;
+        stJournalRecord record;
+        if (pLastData && journaled(pLastData, record)) {
+            logMsg("resuming after " + pLastData->action + " (" + sLastNode + ")");
+            pNode = graph.receive_next_node(pLast, record.result);
+            reboots = m_continueCount; //the reboots before it are passed
+            _resumedActions += _pJournal->size();
+        }
+    }
+    while (pNode && pNode != graph.endNode && !isCancelled()) {
+        if (!visited.insert(pNode).second) {
+            //the run fails, the manifest is not run further
+            throw std::runtime_error("actions of the manifest form a cycle at " + pNode->data->action + ", ");
+        }
+        CManifestActData* pData = static_cast<CManifestActData*>(pNode->pDataRef);
+        bool bReboot = pData->action == "REBOOT";
+
+        stJournalRecord record;
+        if (pData->phase == "act" && bReboot) {
+            if (++reboots > m_continueCount && !journaled(pData, record)) {
+                journalAction(pData, CExecutionJournal::nowMs(), 0);
+                if (_pJournal) {
+                    _pJournal->sync(); //passed once the device is up again
+                }
+                logMsg("## Please reboot to proceed ## ");
+                _bRebootPending = true;
+                return false;
+            }
+            pNode = pNode->pNext; //passed before the last reboot
+            continue;
+        }
+        if (bReboot || (pData->phase == "act" && reboots < m_continueCount && !bJournalRecords)) {
+            //reboot not allowed in pre and post act; actions done before the last reboot
+            pNode = pNode->pNext;
+            continue;
+        }
+        if (pData->phase == "preact" && pData->action == "PRE_CHECK" && !getApplicablityData(pData->param)) {
+            logMsg("manifest not applicable: " + pData->param);
+            return false;
+        }
+        if (journaled(pData, record)) {
+            _resumedActions++;
+            pNode = graph.receive_next_node(pNode, record.result);
+            continue;
+        }
+        if (parallel > 1 && pData->action != "PRE_CHECK" &&
+            (pData->phase == "preact" || pData->phase == "act" || pData->phase == "postact")) {
+            pNode = runParallel(pNode, (size_t)std::min(parallel, DEPLOY_PARALLEL_MAX), bPrepare);
+            continue;
+        }
+        std::vector<Node*> vBatch;
+        for (Node* p = pNode; p && p != graph.endNode; p = p->pNext) {
+            CManifestActData* pNextData = static_cast<CManifestActData*>(p->pDataRef);
+            if (pNextData->phase != pData->phase || pNextData->action != pData->action ||
+                (p != pNode && journaled(pNextData, record))) {
+                break;
+            }
+            vBatch.push_back(p);
+        }
+        size_t batchSize = packageBatchSize(vBatch, 0);
+        if (batchSize > 1) {
+            std::vector<CManifestActData*> vItems;
+            for (size_t i = 0; i < batchSize; i++) {
+                vItems.push_back(static_cast<CManifestActData*>(vBatch[i]->pDataRef));
+            }
+            reportProgress(pData->phase.c_str(), pData->phaseIndex + 1, phaseSize(pData->phase), pData->action);
+            int64_t startMs = CExecutionJournal::nowMs();
+            std::vector<int> vResults = runPackageBatch(vItems, bPrepare);
+            for (size_t i = 0; i < batchSize; i++) {
+                journalAction(vItems[i], startMs, vResults[i]);
+            }
+            pNode = vBatch[batchSize - 1]->pNext; //batched actions have no tags
+            continue;
+        }
+
+        reportProgress(pData->phase.c_str(), pData->phaseIndex + 1, phaseSize(pData->phase), pData->action);
+        int64_t startMs = CExecutionJournal::nowMs();
+        int result = handleAction(pData, bPrepare);
+        journalAction(pData, startMs, result);
+        pNode = graph.receive_next_node(pNode, result);
+    }
+    return true;
+}
+
+/** verbs that run apt or dpkg */
+static bool isPackageVerb(const std::string& sAction) {
+    static const std::set<std::string> packageVerbs = {"INSTALL", "REMOVE", "UPGRADE", "DIST_UPGRADE", "UPDATE",
+                                                       "AUTO_REMOVE", "LOCAL_INSTALL", "ADD_KEY", "ADD_TO_SOURCES"};
+    return packageVerbs.count(sAction) > 0;
+}
+
+/**
+ * What an action changes, for the actions running at the same time: "resources"
+ * of the action if it has them, else derived from the verb. apt and dpkg verbs
+ * share DEPLOY_RESOURCE_DPKG, file verbs hold their paths, service verbs their
+ * service, probes nothing; any other verb, scripts too, holds everything.
+ *
+ * @param pActItem the action.
+ * @return the resource names, see CActionScheduler::conflicts.
+ */
+static std::vector<std::string> resourcesOf(const CManifestActData* pActItem) {
+    static const std::set<std::string> pathVerbs = {"FILE_COPY", "FILE_MOVE", "FILE_REMOVE", "LINK_REMOVE",
+                                                    "FOLDER_ADD", "FOLDER_COPY", "FOLDER_MOVE", "FOLDER_REMOVE",
+                                                    "UNTAR", "UNZIP", "DOWNLOAD", "GIT_CLONE", "GIT_SYNC"};
+    static const std::set<std::string> serviceVerbs = {"START_SERVICE", "STOP_SERVICE", "RESTART_SERVICE",
+                                                       "UNMASK_SERVICE"};
+    static const std::set<std::string> probeVerbs = {"MODULE_LIST", "STATUS_SERVICE", "APT_CACHE_SEARCH",
+                                                     "APT_SEARCH", "CHECK_DEPENDENCIES", "KERNEL_VERSION"};
+    std::vector<std::string> vResources;
+    if (pActItem->resources.is_array()) {
+        for (const auto& jResource : pActItem->resources) {
+            if (jResource.is_string()) {
+                vResources.push_back(jResource.get<std::string>());
+            }
+        }
+    } else if (isPackageVerb(pActItem->action)) {
+        vResources.push_back(DEPLOY_RESOURCE_DPKG);
+    } else if (pathVerbs.count(pActItem->action)) {
+        //every path named by the action; options and urls are no paths
+        for (const std::string* pValue : {&pActItem->param, &pActItem->second_param, &pActItem->path, &pActItem->targetPath}) {
+            std::istringstream iss(*pValue);
+            std::string sToken;
+            while (iss >> sToken) {
+                if (sToken[0] == '-' || sToken.find("://") != std::string::npos) {
+                    continue;
+                }
+                std::string sPath = std::filesystem::path(sToken).lexically_normal().generic_string();
+                while (sPath.size() > 1 && sPath.back() == '/') {
+                    sPath.pop_back();
+                }
+                vResources.push_back(SCHEDULER_RESOURCE_PATH + sPath);
+            }
+        }
+    } else if (serviceVerbs.count(pActItem->action)) {
+        vResources.push_back("service:" + pActItem->param);
+    } else if (!probeVerbs.count(pActItem->action)) {
+        vResources.push_back(SCHEDULER_RESOURCE_ALL);
+    }
+    return vResources;
+}
+
+/**
+ * Runs the actions from pFirst on at the same time, up to the next REBOOT or
+ * PRE_CHECK or the end of its phase. An action waits for the ids in its
+ * "depends_on", without it for the action before it, and for running actions
+ * holding a conflicting resource (resourcesOf). A failed action does not stop
+ * the others, as in runGraph. If an action selects its on_success or
+ * on_failure tag, no further action starts and the tag follows once the running
+ * ones are done; the first such action in manifest order wins.
+ * The actions run on threads of their own: they wait for their command most of
+ * the time, the framework pool would limit them to the number of cpus.
+ *
+ * @param pFirst the first action, not REBOOT or PRE_CHECK.
+ * @param limit actions running at the same time.
+ * @param bPrepare A boolean flag indicating whether to prepare for deployment or not.
+ * @return the tag selected, else the node after the last action.
+ */
+Node* CAPIHandlers::runParallel(Node* pFirst, size_t limit, bool bPrepare) {
+    CGraph& graph = _pManifest->graph;
+    const std::string sPhase = static_cast<CManifestActData*>(pFirst->pDataRef)->phase;
+    std::vector<Node*> vNodes;
+    for (Node* pNode = pFirst; pNode && pNode != graph.endNode; pNode = pNode->pNext) {
+        CManifestActData* pData = static_cast<CManifestActData*>(pNode->pDataRef);
+        if (pData->phase != sPhase || (pNode != pFirst && (pData->action == "REBOOT" || pData->action == "PRE_CHECK"))) {
+            break;
+        }
+        vNodes.push_back(pNode);
+    }
+
+    std::vector<stScheduledAction> vActions(vNodes.size());
+    std::map<std::string, size_t> mIds;
+    for (size_t i = 0; i < vNodes.size(); i++) {
+        CManifestActData* pData = static_cast<CManifestActData*>(vNodes[i]->pDataRef);
+        if (!pData->dependsOn.is_array()) {
+            if (i > 0) {
+                vActions[i].vDepends.push_back(i - 1);
+            }
+        } else {
+            for (const auto& jId : pData->dependsOn) {
+                std::string sId = jId.is_string() ? jId.get<std::string>() : jId.dump();
+                auto it = mIds.find(sId);
+                if (it != mIds.end()) {
+                    vActions[i].vDepends.push_back(it->second);
+                } else if (i > 0) {
+                    //done before this run already, or no earlier action: keep the manifest order
+                    logMsg("depends_on " + sId + " of " + pData->action + ": no earlier action in this run, waits for the previous one");
+                    vActions[i].vDepends.push_back(i - 1);
+                }
+            }
+        }
+        vActions[i].vResources = resourcesOf(pData);
+        if (!pData->id.empty()) {
+            mIds[pData->id] = i;
+        }
+    }
+    CActionScheduler scheduler(std::move(vActions));
+
+    //actions done in an earlier run take their result from the journal
+    std::vector<bool> vJournaled(vNodes.size(), false);
+    std::vector<int> vJournalResults(vNodes.size(), 0);
+    for (size_t i = 0; i < vNodes.size(); i++) {
+        stJournalRecord record;
+        vJournaled[i] = journaled(static_cast<CManifestActData*>(vNodes[i]->pDataRef), record);
+        vJournalResults[i] = record.result;
+    }
+
+    //package actions merged into one transaction: the first runs it, the others take their result
+    std::vector<size_t> vBatchSize(vNodes.size(), 1);
+    std::vector<bool> vBatched(vNodes.size(), false);
+    std::vector<int> vBatchResults(vNodes.size(), 0);
+    for (size_t i = 0; i < vNodes.size(); i++) {
+        if (vJournaled[i]) {
+            continue;
+        }
+        vBatchSize[i] = packageBatchSize(vNodes, i);
+        for (size_t j = i + 1; j < i + vBatchSize[i]; j++) {
+            if (vJournaled[j]) {
+                vBatchSize[i] = j - i;
+                break;
+            }
+            vBatched[j] = true;
+        }
+        i += vBatchSize[i] - 1;
+    }
+
+    std::mutex mtxDone;
+    std::condition_variable condDone;
+    std::vector<std::pair<size_t, int>> vDone; //index, result of handleAction
+    std::vector<std::thread> vThreads;
+    Node* pBranch = nullptr;
+    size_t branchIndex = CActionScheduler::npos;
+
+    auto runAction = [this, &vNodes, &vBatchSize, &vBatchResults, &mtxDone, &condDone, &vDone, bPrepare](size_t index) {
+        tlbActionThread = true;
+        int result = 1;
+        try {
+            int64_t startMs = CExecutionJournal::nowMs();
+            if (vBatchSize[index] > 1) {
+                std::vector<CManifestActData*> vItems;
+                for (size_t i = index; i < index + vBatchSize[index]; i++) {
+                    vItems.push_back(static_cast<CManifestActData*>(vNodes[i]->pDataRef));
+                }
+                std::vector<int> vResults = runPackageBatch(vItems, bPrepare);
+                std::copy(vResults.begin(), vResults.end(), vBatchResults.begin() + (long)index);
+                for (size_t i = 0; i < vItems.size(); i++) {
+                    journalAction(vItems[i], startMs, vResults[i]);
+                }
+                result = vResults[0];
+            } else {
+                CManifestActData* pData = static_cast<CManifestActData*>(vNodes[index]->pDataRef);
+                result = handleAction(pData, bPrepare);
+                journalAction(pData, startMs, result);
+            }
+        } catch (...) {
+            logMsg("error: action failed with an exception");
+        }
+        std::lock_guard<std::mutex> lock(mtxDone);
+        vDone.emplace_back(index, result);
+        condDone.notify_one();
+    };
+
+    while (!scheduler.isDone()) {
+        size_t index = CActionScheduler::npos;
+        if (!pBranch && !isCancelled() && scheduler.running() < limit) {
+            index = scheduler.next();
+        }
+        if (index != CActionScheduler::npos && vJournaled[index]) {
+            _resumedActions++;
+            std::lock_guard<std::mutex> lock(mtxDone);
+            vDone.emplace_back(index, vJournalResults[index]);
+            continue;
+        }
+        if (index != CActionScheduler::npos && vBatched[index]) {
+            //ran in the transaction of the action before it, which is done
+            std::lock_guard<std::mutex> lock(mtxDone);
+            vDone.emplace_back(index, vBatchResults[index]);
+            continue;
+        }
+        if (index != CActionScheduler::npos) {
+            CManifestActData* pData = static_cast<CManifestActData*>(vNodes[index]->pDataRef);
+            reportProgress(pData->phase.c_str(), pData->phaseIndex + 1,
+                           sPhase == "preact" ? _pManifest->vPkgPreActData.size() :
+                           sPhase == "act" ? _pManifest->vPkgActData.size() : _pManifest->vPkgPostActData.size(),
+                           pData->action);
+            try {
+                vThreads.emplace_back(runAction, index);
+            } catch (const std::system_error& e) {
+                logMsg(std::string("no thread for the action, running it here: ") + e.what());
+                runAction(index);
+                tlbActionThread = false;
+            }
+            continue;
+        }
+        if (scheduler.running() == 0) {
+            break; //a tag follows or cancelled, the actions not started are skipped
+        }
+        std::unique_lock<std::mutex> lock(mtxDone);
+        condDone.wait(lock, [&vDone] { return !vDone.empty(); });
+        for (const auto& done : vDone) {
+            scheduler.finish(done.first);
+            Node* pNext = graph.receive_next_node(vNodes[done.first], done.second);
+            if (pNext != vNodes[done.first]->pNext && done.first < branchIndex) {
+                pBranch = pNext;
+                branchIndex = done.first;
+            }
+        }
+        vDone.clear();
+    }
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+    return pBranch ? pBranch : vNodes.back()->pNext;
+}
+
 /**
  * Handles the action specified in the given `CManifestActData` object.
  * 
  * @param pActItem A pointer to the `CManifestActData` object containing the action data.
  * @param bPrepare A boolean indicating whether the action is being prepared or executed.
- * @return Returns 0 if the action is successfully handled, otherwise returns 1.
+ * @return 0 if the action succeeded: ran with the expected result, or there is
+ *         nothing to check; 1 otherwise. Selects on_success or on_failure.
  */
 int CAPIHandlers::handleAction(CManifestActData *pActItem, bool bPrepare) {
     
@@ -301,10 +695,12 @@ int CAPIHandlers::handleAction(CManifestActData *pActItem, bool bPrepare) {
    
     try {
        
-        std::vector<std::string> vCommands = pCmdDict->getCommandsForVerb(pActItem->action);
+        //command of the verbs without parameters; the others build theirs below
+        stVerbCommand command = pCmdDict->getCommand(pActItem->action);
       
-        bool bCustomTask = false;
         bool bRunCmd = false;
+        /** the exit code is the result, not the output */
+        bool bExitCode = false;
         
         switch(pPkgAction->toEnum(pActItem->action)) {
 
@@ -325,9 +721,55 @@ int CAPIHandlers::handleAction(CManifestActData *pActItem, bool bPrepare) {
             }
             break;
 
+            case CPkgActions::eActionVerbs::eINSTALL:
+            case CPkgActions::eActionVerbs::eREMOVE:
+            case CPkgActions::eActionVerbs::eLOCAL_INSTALL:
+                command = pCmdDict->getCommand(pActItem->action, packageParams(pActItem));
+                bRunCmd = !bPrepare;
+                bExitCode = pActItem->expected.empty() || pActItem->expected == "0";
+                break;
+
+            case CPkgActions::eActionVerbs::eDOWNLOAD:
+            {
+                //the url in param, into path or target_path, else next to the manifest
+                std::string sDir = !pActItem->path.empty() ? pActItem->path :
+                                   !pActItem->targetPath.empty() ? pActItem->targetPath : sManifestParentPath;
+                std::string sFile;
+                if (!bPrepare && prefetched(pActItem, sFile)) {
+                    std::string sName = pActItem->param.substr(pActItem->param.find_last_of('/') + 1);
+                    command = pCmdDict->getCommand("FILE_COPY", {sFile, (std::filesystem::path(sDir) / sName).generic_string()});
+                } else if (pActItem->param.compare(0, 7, "file://") == 0) {
+                    command = pCmdDict->getCommand("FILE_COPY", {pActItem->param.substr(7), sDir});
+                } else {
+                    command = pCmdDict->getCommand(pActItem->action, {sDir, pActItem->param});
+                }
+                bRunCmd = !bPrepare;
+                bExitCode = pActItem->expected.empty() || pActItem->expected == "0";
+            }
+            break;
+
+            case CPkgActions::eActionVerbs::eGIT_CLONE:
+            {
+                //the repository in param, into path if it is set
+                std::vector<std::string> vParams;
+                std::string sMirror;
+                if (!bPrepare && prefetched(pActItem, sMirror)) {
+                    //objects come from the mirror, only what it lacks from the repository
+                    vParams = {"--reference-if-able", sMirror, "--dissociate"};
+                }
+                vParams.push_back(pActItem->param);
+                if (!pActItem->path.empty()) {
+                    vParams.push_back(pActItem->path);
+                }
+                command = pCmdDict->getCommand(pActItem->action, vParams);
+                bRunCmd = !bPrepare;
+                bExitCode = pActItem->expected.empty() || pActItem->expected == "0";
+            }
+            break;
+
             case CPkgActions::eActionVerbs::eCUSTOM_TASK:
-                bCustomTask = true; 
-                break; 
+                logMsg("action : " + pActItem->action + " ; custom command to run: " );
+                return rValue(pActItem, bPrepare);
             case CPkgActions::eActionVerbs::ePRE_CHECK:
                 break; 
              //precheck handled seperately                
@@ -336,47 +778,34 @@ int CAPIHandlers::handleAction(CManifestActData *pActItem, bool bPrepare) {
                 return 1;
         }
 
-        if (bCustomTask){
-            //todo: what do we do if failed?
-            logMsg("action : " + pActItem->action + " ; custom command to run: " );            
-
-            handleCustomAction(pActItem, bPrepare); 
-        } else {
-            std::stringstream ss_command;
-            for (size_t i = 0; i < vCommands.size(); i++) {
-                ss_command << vCommands[i] << " ";
+        if(bRunCmd == true && !command.sCommandLine.empty()) {
+            logMsg("action : " + pActItem->action + " ; command to run: " + command.sCommandLine
+                   + (command.bShell ? "(shell)" : ""));
+            bool bMatched = false;
+            stProcessResult result;
+            bool bPackage = isPackageVerb(pActItem->action);
+            if (bPackage) {
+                waitForAptPrefetch(pActItem->action == "INSTALL");
             }
-
-            if(bRunCmd == true && !ss_command.str().empty()) {
-                //std::cout << ss_command.str() << std::endl;
-                //todo: add result checking                    
-                //std::cout << "command to run: " << ss_command.str() << std::endl;
-                logMsg("action : " + pActItem->action + " ; command to run: " + ss_command.str());
-                std::string strRes = Helper::runCmd(ss_command.str(), 0);
-                if (!pActItem->expected.empty()){ //non empty means we need to check the result            
-                        
-                    //std::cout << "command expected: " << pActItem->expected<< std::endl;                     
-                    trimString(strRes); 
-                    bool bSuccess = true;                         
-                    if (strRes == pActItem->expected) { //if onSuccess
-                        if (!pActItem->onSuccess.empty()) {
-                            checkandStartAction(pActItem->onSuccess);
-                        }
-                    } else if (!pActItem->condition.empty()) { //if there is a condition for result
-                        bSuccess = evalCondition(pActItem->expected, strRes, pActItem->condition);
-                    } else {
-                        bSuccess = false;
-                    }
-                         //if onFailure
-                    if (!bSuccess && !pActItem->onFailure.empty()) {
-                        checkandStartAction(pActItem->onFailure);
-                    }                        
-                    
+            std::string strRes = runActionCmd(command, pActItem, bMatched, &result);
+            if (bPackage) {
+                aptActionDone(pActItem);
+            }
+            if (bExitCode) {
+                return result.succeeded() ? 0 : 1;
+            }
+            if (!pActItem->expected.empty()){ //non empty means we need to check the result            
+                trimString(strRes); 
+                if (bMatched) {
+                    return 0;
                 }
-            } else {
-                //std::cout << "skipped command to run: " << ss_command.str() << std::endl;
-                logMsg("action : " + pActItem->action + " ; skipped command to run: " + ss_command.str());
+                if (!pActItem->condition.empty()) { //if there is a condition for result
+                    return evalCondition(pActItem->expected, strRes, pActItem->condition) ? 0 : 1;
+                }
+                return 1;
             }
+        } else {
+            logMsg("action : " + pActItem->action + " ; skipped command to run: " + command.sCommandLine);
         }
     } catch (const std::exception &e) {
         std::cout << e.what() << "error executing action command"<< std::endl;        
@@ -389,37 +818,6 @@ int CAPIHandlers::handleAction(CManifestActData *pActItem, bool bPrepare) {
 }
 
 
-/**
- * @brief Checks if the given action is valid and starts the corresponding action.
- * 
- * @param strAction The action to be checked and started.
- * @return True if the action is found and started, false otherwise.
- */
-bool CAPIHandlers::checkandStartAction(std::string strAction)
-{
-    bool bFound = false; 
-    
-    if (strAction == "PACKAGE_STOP" || strAction == "MANIFEST_EXIT" ){
-        //this action means we will exit the current manifest actions
-        bFound = true; 
-        cancelPackage(); 
-    }
-    
-    //check act data first
-    std::vector<CManifestActData*>::iterator act_it;
-    for(act_it = _pManifest->vPkgActData.begin(); act_it != _pManifest->vPkgActData.end(); act_it++ )    {
-        CManifestActData *pData = (CManifestActData*)*act_it;
-        if(pData->action == strAction) {
-            bFound = true; 
-            handleAction(pData, false);
-            break;
-        }
-    }
-
-    
-    return bFound;
-}
-
 // Return 0 if the expected value is the same as return value; otherwise 1
 int CAPIHandlers::rValue(CManifestActData *pActItem, bool bPrepare) {
 
@@ -447,73 +845,6 @@ int CAPIHandlers::rValue(CManifestActData *pActItem, bool bPrepare) {
     }
 }
 
-/**
- * Handles a custom action specified in the manifest.
- *
- * @param pActItem A pointer to the CManifestActData object representing the custom action.
- * @param bPrepare A boolean indicating whether the action is being prepared or executed.
- * @return Returns 0 if the custom action is successfully handled, -1 otherwise.
- */
-int CAPIHandlers::handleCustomAction(CManifestActData *pActItem, bool bPrepare){
-
-	if (pActItem->action.empty()){	
-		//log error
-		std::cout << "No action specified for custom action" <<  std::endl;
-		return -1; 	
-		
-	} else {
-    	        std::cout << "handle custom action: " <<  pActItem->action <<  std::endl;
-		std::map<std::string, fPtr>::iterator it = map_string_fPtr.find(pActItem->action);
-		if (it != map_string_fPtr.end()) {
-			fPtr func_addr = it->second;
-			int returnVal = (this->*func_addr)(pActItem, bPrepare);
-			if (pActItem->expected != ""){
-			    if (pActItem->expected == std::to_string(returnVal)){
-			        //check on_success
-			        std::cout << "custom action pass: " <<  std::to_string(returnVal) << std::endl;
-			        if ((pActItem->onSuccess).empty())
-                        return 0; 
-                    else{
-                        //call handleAction again
-                        bool bFound = checkandStartAction(pActItem->onSuccess);
-                        
-                        if (!bFound){
-                            std::cout << "No found action for success case" << std::endl; 
-                            return -1; 
-                        }
-                        return 0;                 
-                    }  
-			    } else {
-			        //check on_failure
-			        std::cout << "custom action fail: " <<  std::to_string(returnVal) << std::endl;			    
-			        if ((pActItem->onFailure).empty()){
-        			    std::cout << "no onFailure action specified" <<  std::endl;				    
-                        return -1; 
-                    }
-                    else{
-                        //call handleAction again
-        			    std::cout << "onFailure action specified, call: " <<  pActItem->onFailure << std::endl;		                    
-                        
-                        bool bFound = checkandStartAction(pActItem->onFailure);                   
-                        
-                        if (!bFound){
-                            std::cout << "No found action for failure case" << std::endl; 
-                            return -1; 
-                        }
-                        return 0; 
-                    }
-			    }
-			}
-		} else {
-		    //log error
-		    std::cout << "custom action not supported " << std::endl; 
-		    return -1; 
-		}
-		return 0; 
-	} 
-
-}
-
 /**
  * Executes a script specified by the given `pActItem` parameter.
  * 
@@ -537,15 +868,32 @@ int CAPIHandlers::executeScript(CManifestActData *pActItem, bool bPrepare) {
             Helper::runCmd(terminal_command, 0);
         }
         
-        retVal = system(sScriptPath.c_str());
-        // std::cout << WEXITSTATUS(retVal) << std::endl; 
+        //script output goes to the terminal, as with system()
+        stProcessOptions options;
+        options.bCapture = false;
+        options.pCancel = _pCancelRequest;
+        options.timeoutMs = DEPLOY_ACTION_TIMEOUT_MS;
+        options.sched = schedPolicyFor(pActItem);
+        stProcessResult result = CProcess::runShell(sScriptPath, options);
+        recordAction(pActItem->action, sScriptPath, result, -1, options.sched);
+        std::cout << "script exit code: " << result.exitCode << " signal: " << result.signal
+                  << " wall ms: " << result.wallMs << " cpu ms: " << result.userCpuMs + result.systemCpuMs
+                  << " max rss kB: " << result.maxRssKb << std::endl;
+
+        if (!result.bStarted || result.bCancelled || result.bTimedOut) {
+            retVal = -1;
+        } else if (result.signal != 0) {
+            retVal = 128 + result.signal;
+        } else {
+            retVal = result.exitCode;
+        }
         
     } catch (...) {
         
         std::cout << "Exception" << std::endl; 
     }
     
-    return WEXITSTATUS(retVal);
+    return retVal;
 }
 
 /**
@@ -561,7 +909,12 @@ int CAPIHandlers::kernelCheck(CManifestActData *pActItem, bool bPrepare){
     std::string sVersion("Unsupported"); 
     std::string sCommand = "grep -oP \"model name\\K.*\" /proc/cpuinfo | head -1";  
     //std::cout << "run kernelCheck command " << sCommand << std::endl;        
-    std::string sResult = Helper::runCmd(sCommand, 0);
+    //the cpu does not change, probed once per deployment
+    std::string sResult;
+    if (!_probeCache.lookup(sCommand, nlohmann::json::array(), 0, sResult)) {
+        sResult = Helper::runCmd(sCommand, 0);
+        _probeCache.store(sCommand, nlohmann::json::array(), sResult);
+    }
     
     if (sResult.empty())
         return -1; 
@@ -672,6 +1025,497 @@ void CAPIHandlers::cancelPackage(){
     _bCancel = true; 
 }
 
+bool CAPIHandlers::isCancelled() {
+    return _bCancel || (_pCancelRequest && *_pCancelRequest);
+}
+
+/**
+ * Reports the action about to run to the progress sink, if any.
+ *
+ * @param sPhase preact, act or postact.
+ * @param step 1 based index of the action in its phase.
+ * @param total number of actions in the phase.
+ * @param sAction the action verb.
+ */
+void CAPIHandlers::reportProgress(const char* sPhase, size_t step, size_t total, const std::string& sAction) {
+    if (!_pSink) {
+        return;
+    }
+    nlohmann::json jProgress;
+    jProgress["phase"] = sPhase;
+    jProgress["step"] = step;
+    jProgress["total"] = total;
+    jProgress["action"] = sAction;
+    _pSink->writeProgress(std::move(jProgress));
+}
+
+/**
+ * Strips sudo and its options from an argv command.
+ *
+ * @param command the command of a verb.
+ * @return the argv to run as root, empty for shell commands and commands without sudo.
+ */
+static std::vector<std::string> withoutSudo(const stVerbCommand& command) {
+    if (command.bShell || command.vArgs.empty() || command.vArgs[0] != "sudo") {
+        return {};
+    }
+    size_t first = 1;
+    while (first < command.vArgs.size() && command.vArgs[first][0] == '-') {
+        first++;
+    }
+    return std::vector<std::string>(command.vArgs.begin() + (long)first, command.vArgs.end());
+}
+
+/**
+ * Runs an action command as a high priority task of the framework thread pool,
+ * so deployments share the workers with everything else in the process.
+ * Actions depend on each other, the command is waited for before the next one.
+ * sudo argv commands run in a privileged helper, without sudo when the process is root.
+ *
+ * @param command argv, or a command line for the shell; stopped after DEPLOY_ACTION_TIMEOUT_MS.
+ * @param pActItem the action: its verb names the output file, its expected value is
+ *                 compared with the output while it streams, its priority is applied.
+ * @param bMatched set if the complete output equals the expected value.
+ * @param pResult receives the outcome of the command, may be NULL.
+ * @return the output of the command, only its start and end if it is long
+ *         (at least the size of the expected value of the start); empty if cancelled.
+ */
+std::string CAPIHandlers::runActionCmd(const stVerbCommand& command, const CManifestActData* pActItem, bool& bMatched,
+                                       stProcessResult* pResult) {
+    const std::string& sAction = pActItem->action;
+    stSchedPolicy sched = schedPolicyFor(pActItem);
+    //memory is bounded by the capture policy, the complete output goes to a file of the action
+    COutputCapture capture(DEPLOY_OUTPUT_HEAD, DEPLOY_OUTPUT_TAIL);
+    capture.expect(pActItem->expected);
+    try {
+        std::filesystem::path outputDir = std::filesystem::current_path() / DEPLOY_OUTPUT_DIR;
+        std::filesystem::create_directories(outputDir);
+        std::string sName;
+        {
+            std::lock_guard<std::mutex> lock(_mtxRun);
+            sName = std::to_string(++m_actionCount) + "-" + sAction + ".log";
+        }
+        capture.spillTo((outputDir / sName).generic_string(), DEPLOY_OUTPUT_FILE_MAX);
+    } catch (const std::exception& e) {
+        logMsg(std::string("no output file: ") + e.what());
+    }
+
+    stProcessResult result;
+    //on a thread of runParallel the command runs right here, that thread is there to wait for it
+    CTaskGroup tasks(tlbActionThread ? NULL : _pExecutor, TASK_PRIORITY_HIGH, _pCancelRequest);
+    tasks.run([&]() {
+        stProcessOptions options;
+        options.bClearEnv = true;
+        options.pCancel = _pCancelRequest;
+        options.timeoutMs = DEPLOY_ACTION_TIMEOUT_MS;
+        options.onOutput = [&capture](std::string_view chunk) { capture.write(chunk); };
+        options.sched = sched;
+        std::vector<std::string> vArgs = withoutSudo(command);
+        if (!vArgs.empty() && geteuid() == 0) {
+            result = CProcess::run(vArgs, options);
+        } else if (vArgs.empty() || !_privHelpers.run(vArgs, options, result)) {
+            result = command.bShell ? CProcess::runShell(command.sCommandLine, options)
+                                    : CProcess::run(command.vArgs, options);
+        }
+        if (result.bTimedOut) {
+            logMsg("command timed out: " + command.sCommandLine);
+        }
+    });
+    tasks.wait();
+    recordAction(sAction, command.sCommandLine, result, (long)capture.total(), sched);
+    bMatched = capture.matched();
+    if (pResult) {
+        *pResult = result;
+    }
+    return capture.text();
+}
+
+/**
+ * The packages of an INSTALL or REMOVE action, or the .deb files of a
+ * LOCAL_INSTALL action, relative to the manifest.
+ *
+ * @param pActItem the action, its param lists them separated by spaces.
+ * @return one argument per package or file.
+ */
+std::vector<std::string> CAPIHandlers::packageParams(const CManifestActData* pActItem) {
+    std::vector<std::string> vParams;
+    std::istringstream iss(pActItem->param);
+    std::string sToken;
+    while (iss >> sToken) {
+        if (pActItem->action == "LOCAL_INSTALL" && sToken[0] != '-') {
+            sToken = (std::filesystem::path(sManifestParentPath) / sToken).generic_string();
+        }
+        vParams.push_back(sToken);
+    }
+    return vParams;
+}
+
+/**
+ * Runs package actions of one verb as one apt-get or dpkg transaction, so the
+ * package lists are read, dependencies resolved and triggers (initramfs,
+ * ldconfig, man-db) run once. If the transaction fails, the actions run one
+ * by one, for the result of each.
+ *
+ * @param vItems INSTALL, REMOVE or LOCAL_INSTALL actions of the same verb, see packageBatchSize.
+ * @param bPrepare A boolean indicating whether the action is being prepared or executed.
+ * @return the result of every action as handleAction returns it.
+ */
+std::vector<int> CAPIHandlers::runPackageBatch(const std::vector<CManifestActData*>& vItems, bool bPrepare) {
+    std::vector<int> vResults(vItems.size(), 0);
+    const std::string& sAction = vItems[0]->action;
+    std::vector<std::string> vParams;
+    for (const CManifestActData* pItem : vItems) {
+        std::vector<std::string> vItemParams = packageParams(pItem);
+        vParams.insert(vParams.end(), vItemParams.begin(), vItemParams.end());
+    }
+    stVerbCommand command = pCmdDict->getCommand(sAction, vParams);
+    if (bPrepare || command.sCommandLine.empty()) {
+        logMsg("action : " + sAction + " ; skipped command to run: " + command.sCommandLine);
+        return vResults;
+    }
+
+    logMsg("action : " + sAction + " ; " + std::to_string(vItems.size()) + " actions in one transaction: "
+           + command.sCommandLine);
+    bool bMatched = false;
+    stProcessResult result;
+    waitForAptPrefetch(sAction == "INSTALL");
+    runActionCmd(command, vItems[0], bMatched, &result);
+    for (const CManifestActData* pItem : vItems) {
+        aptActionDone(pItem);
+    }
+    if (result.succeeded()) {
+        return vResults;
+    }
+    if (result.bCancelled || isCancelled()) {
+        std::fill(vResults.begin(), vResults.end(), 1);
+        return vResults;
+    }
+    logMsg("transaction failed, running the " + sAction + " actions one by one");
+    for (size_t i = 0; i < vItems.size(); i++) {
+        vResults[i] = handleAction(vItems[i], bPrepare);
+    }
+    return vResults;
+}
+
+/**
+ * Adds an action command to the run report and to the histograms of its verb.
+ *
+ * @param sAction the action verb.
+ * @param sCommand the command line.
+ * @param result the outcome of the command.
+ * @param outputBytes bytes of output, -1 if it went to the terminal.
+ * @param sched the priority the command was started with.
+ */
+void CAPIHandlers::recordAction(const std::string& sAction, const std::string& sCommand, const stProcessResult& result,
+                                long outputBytes, const stSchedPolicy& sched) {
+    std::lock_guard<std::mutex> lock(_mtxRun);
+    nlohmann::json jRecord;
+    jRecord["action"] = sAction;
+    jRecord["command"] = sCommand;
+    jRecord["started"] = result.bStarted;
+    jRecord["exit_code"] = result.exitCode;
+    jRecord["signal"] = result.signal;
+    jRecord["timed_out"] = result.bTimedOut;
+    jRecord["cancelled"] = result.bCancelled;
+    jRecord["spawn_us"] = result.spawnUs;
+    jRecord["wall_ms"] = result.wallMs;
+    jRecord["user_cpu_ms"] = result.userCpuMs;
+    jRecord["system_cpu_ms"] = result.systemCpuMs;
+    jRecord["max_rss_kb"] = result.maxRssKb;
+    if (outputBytes >= 0) {
+        jRecord["output_bytes"] = outputBytes;
+    }
+    if (sched.isSet()) {
+        static const char* ioClasses[] = {"none", "realtime", "best-effort", "idle"};
+        jRecord["priority"] = {{"nice", sched.nice}, {"io_class", ioClasses[sched.ioClass]},
+                               {"io_level", sched.ioLevel}, {"idle", sched.bIdle},
+                               {"applied", result.bSchedApplied}};
+    }
+    _jActionRecords.push_back(std::move(jRecord));
+
+    stVerbStats& stats = _verbStats[sAction];
+    if (!result.bStarted) {
+        stats.failed++;
+        return;
+    }
+    stats.wallMs.record((uint64_t)result.wallMs);
+    stats.spawnUs.record((uint64_t)result.spawnUs);
+    stats.cpuMs.record((uint64_t)(result.userCpuMs + result.systemCpuMs));
+    if (!result.succeeded()) {
+        stats.failed++;
+    }
+}
+
+/**
+ * Starts fetching the artifacts of the manifest in the background, in the
+ * order their actions run: DOWNLOAD urls, GIT_CLONE repositories and one apt
+ * download pass for the packages of all INSTALL actions. The apt pass waits for
+ * the package actions before the first INSTALL (UPDATE above all), the package
+ * lists have to be current. Actions skipped after a reboot or done according
+ * to the journal are left out.
+ * Nothing is fetched for prepare or with "prefetch": false in prop.
+ *
+ * @param bPrepare A boolean flag indicating whether to prepare for deployment or not.
+ */
+void CAPIHandlers::startPrefetch(bool bPrepare) {
+    if (bPrepare || (_pManifest->pPkgPropData && !_pManifest->pPkgPropData->prefetch)) {
+        return;
+    }
+    std::vector<const CManifestActData*> vActions;
+    auto addAction = [this, &vActions](CManifestActData* pData) {
+        stJournalRecord record;
+        if (!journaled(pData, record)) {
+            vActions.push_back(pData);
+        }
+    };
+    std::for_each(_pManifest->vPkgPreActData.begin(), _pManifest->vPkgPreActData.end(), addAction);
+    int reboots = 0;
+    for (CManifestActData* pData : _pManifest->vPkgActData) {
+        if (pData->action == "REBOOT") {
+            reboots++;
+        } else if (reboots >= m_continueCount) {
+            addAction(pData);
+        }
+    }
+    std::for_each(_pManifest->vPkgPostActData.begin(), _pManifest->vPkgPostActData.end(), addAction);
+
+    //apt must not run as root without asking sudo in the background
+    _pPrefetcher = new CPrefetcher((std::filesystem::current_path() / DEPLOY_PREFETCH_DIR).generic_string(),
+        [this](const std::vector<std::string>& vArgs, const stProcessOptions& options) {
+            if (geteuid() == 0) {
+                return CProcess::run(vArgs, options);
+            }
+            //a helper of its own: the download may take long, the actions keep theirs.
+            //Only once sudo authenticated for the actions, sudo -n does not ask again
+            if (!_privHelpers.isReady()) {
+                return stProcessResult();
+            }
+            std::lock_guard<std::mutex> lock(_mtxPrefetchHelper);
+            if (!_pPrefetchHelper) {
+                _pPrefetchHelper = new CPrivilegedHelper();
+                if (!_pPrefetchHelper->start(_pCancelRequest, false)) {
+                    logMsg("privileged helper of the prefetch not started");
+                }
+            }
+            if (_pPrefetchHelper->isRunning()) {
+                return _pPrefetchHelper->run(vArgs, options);
+            }
+            return stProcessResult();
+        });
+    std::vector<std::string> vPackages;
+    bool bInstallSeen = false;
+    for (const CManifestActData* pData : vActions) {
+        if (pData->action == "DOWNLOAD" && !pData->param.empty()) {
+            _mPrefetchIds[pData] = _pPrefetcher->addUrl(pData->param);
+        } else if (pData->action == "GIT_CLONE" && !pData->param.empty()) {
+            _mPrefetchIds[pData] = _pPrefetcher->addGit(pData->param);
+        } else if (pData->action == "INSTALL") {
+            std::vector<std::string> vItemPackages = packageParams(pData);
+            vPackages.insert(vPackages.end(), vItemPackages.begin(), vItemPackages.end());
+            bInstallSeen = true;
+        } else if (isPackageVerb(pData->action) && !bInstallSeen) {
+            _aptGateActions.insert(pData);
+        }
+    }
+    if (!vPackages.empty()) {
+        _aptPrefetchId = _pPrefetcher->addApt(vPackages, !_aptGateActions.empty());
+        _bAptPrefetch = true;
+    }
+    if (_mPrefetchIds.empty() && !_bAptPrefetch) {
+        delete _pPrefetcher;
+        _pPrefetcher = NULL;
+        return;
+    }
+    _pPrefetcher->start(DEPLOY_PREFETCH_THREADS);
+}
+
+/**
+ * Stops the fetches still running, the artifacts are not needed any more,
+ * and keeps their state for the report.
+ */
+void CAPIHandlers::stopPrefetch() {
+    if (_pPrefetcher) {
+        _pPrefetcher->stop();
+        for (auto& jItem : _pPrefetcher->toJson()) {
+            _jPrefetchRecords.push_back(std::move(jItem));
+        }
+        delete _pPrefetcher;
+        _pPrefetcher = NULL;
+    }
+    if (_pPrefetchHelper) {
+        delete _pPrefetchHelper;
+        _pPrefetchHelper = NULL;
+    }
+    _mPrefetchIds.clear();
+    _aptGateActions.clear();
+    _bAptPrefetch = false;
+}
+
+bool CAPIHandlers::prefetched(const CManifestActData* pActItem, std::string& sPath) {
+    auto it = _mPrefetchIds.find(pActItem);
+    if (!_pPrefetcher || it == _mPrefetchIds.end()) {
+        return false;
+    }
+    return _pPrefetcher->wait(it->second, sPath);
+}
+
+void CAPIHandlers::waitForAptPrefetch(bool bInstall) {
+    if (_pPrefetcher && _bAptPrefetch) {
+        std::string sPath;
+        _pPrefetcher->wait(_aptPrefetchId, sPath, bInstall);
+    }
+}
+
+void CAPIHandlers::aptActionDone(const CManifestActData* pActItem) {
+    std::lock_guard<std::mutex> lock(_mtxRun);
+    if (_pPrefetcher && _aptGateActions.erase(pActItem) && _aptGateActions.empty()) {
+        _pPrefetcher->release(_aptPrefetchId);
+    }
+}
+
+/**
+ * Opens the journal of the manifest, DEPLOY_JOURNAL_DIR/<hash>.journal in the
+ * working directory; the hash is taken from the manifest path, identifier and
+ * version. It is kept while the run stops for a reboot, is cancelled or fails,
+ * and deleted when the run completes. Nothing is journaled for prepare.
+ * The journal keeps a hash of the manifest content: while it is unchanged the
+ * recorded actions are taken by id, otherwise each one by its content.
+ *
+ * @param manifestPath The path to the manifest file.
+ * @param bPrepare A boolean flag indicating whether to prepare for deployment or not.
+ */
+void CAPIHandlers::openJournal(const std::string& manifestPath, bool bPrepare) {
+    if (bPrepare) {
+        return;
+    }
+    std::string sKey = std::filesystem::absolute(manifestPath).lexically_normal().generic_string();
+    if (_pManifest->pPkgMetaData) {
+        sKey += "\n" + _pManifest->pPkgMetaData->identifier + "\n" + _pManifest->pPkgMetaData->version;
+    }
+    std::filesystem::path journalFile = std::filesystem::current_path() / DEPLOY_JOURNAL_DIR /
+                                        (CExecutionJournal::hash(sKey) + ".journal");
+    if (_bRestart) {
+        std::error_code ec;
+        std::filesystem::remove(journalFile, ec);
+    }
+    std::string sContent;
+    if (_pManifestData) {
+        sContent = _pManifestData->dump();
+    } else {
+        std::ifstream manifestFile(manifestPath, std::ios::binary);
+        sContent.assign(std::istreambuf_iterator<char>(manifestFile), std::istreambuf_iterator<char>());
+    }
+    _pJournal = new CExecutionJournal();
+    if (!_pJournal->open(journalFile.generic_string(), CExecutionJournal::hash(sContent))) {
+        logMsg("journal cannot be written, the run cannot be resumed: " + journalFile.generic_string());
+        delete _pJournal;
+        _pJournal = NULL;
+    } else if (_pJournal->size() > 0) {
+        logMsg("resuming the run of " + journalFile.generic_string() + ": " +
+               std::to_string(_pJournal->size()) + " actions done");
+    }
+    _bJournalCurrent = _pJournal && _pJournal->isContentCurrent();
+}
+
+void CAPIHandlers::closeJournal() {
+    if (_pJournal) {
+        delete _pJournal; //synced
+        _pJournal = NULL;
+    }
+    _bJournalCurrent = false;
+}
+
+bool CAPIHandlers::journaled(CManifestActData* pActItem, stJournalRecord& record) {
+    if (_bJournalCurrent) {
+        return _pJournal && _pJournal->lookup(journalId(pActItem), record);
+    }
+    return _pJournal && _pJournal->lookup(journalId(pActItem), CExecutionJournal::hash(pActItem->tojsonString()), record);
+}
+
+void CAPIHandlers::journalAction(CManifestActData* pActItem, int64_t startMs, int result) {
+    //an action stopped by the cancel did not complete, it runs again on resume
+    if (!_pJournal || isCancelled()) {
+        return;
+    }
+    stJournalRecord record;
+    record.sHash = CExecutionJournal::hash(pActItem->tojsonString());
+    record.startMs = startMs;
+    record.endMs = CExecutionJournal::nowMs();
+    record.result = result;
+    _pJournal->record(journalId(pActItem), record);
+}
+
+/**
+ * Overlays a priority object ({"nice": 10, "io_class": "idle", "io_level": 7, "idle": true})
+ * onto a policy. Only lowering is supported: nice is kept in 0 .. 19, realtime i/o is not.
+ *
+ * @param jPriority the priority, anything else than an object is ignored.
+ * @param sched receives the values present.
+ */
+static void applyPriority(const nlohmann::json& jPriority, stSchedPolicy& sched) {
+    if (!jPriority.is_object()) {
+        return;
+    }
+    if (jPriority.contains("nice")) {
+        sched.nice = std::min(std::max(jPriority.at("nice").get<int>(), 0), 19);
+    }
+    if (jPriority.contains("io_class")) {
+        std::string sClass = jPriority.at("io_class").get<std::string>();
+        if (sClass == "idle") {
+            sched.ioClass = PROCESS_IO_CLASS_IDLE;
+        } else if (sClass == "best-effort") {
+            sched.ioClass = PROCESS_IO_CLASS_BEST_EFFORT;
+        } else {
+            sched.ioClass = PROCESS_IO_CLASS_NONE;
+        }
+    }
+    if (jPriority.contains("io_level")) {
+        sched.ioLevel = std::min(std::max(jPriority.at("io_level").get<int>(), 0), 7);
+    }
+    if (jPriority.contains("idle")) {
+        sched.bIdle = jPriority.at("idle").get<bool>();
+    }
+}
+
+stSchedPolicy CAPIHandlers::schedPolicyFor(const CManifestActData* pActItem) {
+    stSchedPolicy sched;
+    try {
+        if (_jPriorityConfig.is_object()) {
+            applyPriority(_jPriorityConfig.value("default", nlohmann::json()), sched);
+            const nlohmann::json jVerbs = _jPriorityConfig.value("verbs", nlohmann::json::object());
+            if (jVerbs.is_object() && jVerbs.contains(pActItem->action)) {
+                applyPriority(jVerbs.at(pActItem->action), sched);
+            }
+        }
+        if (_pManifest && _pManifest->pPkgPropData) {
+            applyPriority(_pManifest->pPkgPropData->priority, sched);
+        }
+        applyPriority(pActItem->priority, sched);
+    } catch (const std::exception& e) {
+        logMsg(std::string("invalid priority, ") + pActItem->action + ": " + e.what());
+    }
+    return sched;
+}
+
+nlohmann::json CAPIHandlers::getRunReport() const {
+    nlohmann::json jReport;
+    jReport["actions"] = _jActionRecords;
+    nlohmann::json jVerbs = nlohmann::json::object();
+    for (const auto& verb : _verbStats) {
+        nlohmann::json jVerb;
+        jVerb["wall_ms"] = verb.second.wallMs.toJson();
+        jVerb["spawn_us"] = verb.second.spawnUs.toJson();
+        jVerb["cpu_ms"] = verb.second.cpuMs.toJson();
+        jVerb["failed"] = verb.second.failed;
+        jVerbs[verb.first] = std::move(jVerb);
+    }
+    jReport["verbs"] = std::move(jVerbs);
+    jReport["reboot_required"] = _bRebootPending;
+    jReport["resumed_actions"] = _resumedActions;
+    jReport["prefetch"] = _jPrefetchRecords;
+    return jReport;
+}
+
 /**
  * Retrieves the applicability data for a given package name.
  *
@@ -688,6 +1532,11 @@ bool CAPIHandlers::getApplicablityData(std::string pkgname)
     sysData.platform = _pManifest->pPkgApplicabilityData->vPlatforms;
     sysData.pkgsets = pkgname;
     //sysData.hardware = _pManifest->pPkgApplicabilityData->vHW;
-    bool retVal = CSysInfo::getSysInfo(sysData);
+    //snapshot handed over by the discovery stage of a pipeline
+    const nlohmann::json* pSnapshot = NULL;
+    if (_pArtifacts && _pArtifacts->count(ARTIFACT_PLATFORM_SNAPSHOT)) {
+        pSnapshot = &_pArtifacts->at(ARTIFACT_PLATFORM_SNAPSHOT);
+    }
+    bool retVal = CSysInfo::getSysInfo(sysData, pSnapshot);
     return retVal;
 }
@@ -18,6 +18,7 @@
  */
 
 #include <iostream>
+#include <sstream>
 
 #include "actions.h"
 #include "commandreference.h"
@@ -109,3 +110,62 @@ std::vector<std::string> CCommandReference::getCommandsForVerb(std::string verb)
     }
     return vCommands;
 }
+
+/**
+ * Checks whether a dictionary entry needs the shell: pipes, redirections,
+ * quoting, variables, globs, or a shell builtin as the program.
+ *
+ * @param sEntry The dictionary entry.
+ * @param bFirst The entry holds the program name.
+ * @return true if the entry has to run with /bin/sh -c.
+ */
+static bool needsShell(const std::string& sEntry, bool bFirst) {
+    if (sEntry.find_first_of("|&;<>()$`\\\"'*?[]{}~#") != std::string::npos) {
+        return true;
+    }
+    if (bFirst) {
+        std::string sProgram = sEntry.substr(0, sEntry.find(' '));
+        return sProgram == "source" || sProgram == "." || sProgram == "cd" || sProgram == "export";
+    }
+    return false;
+}
+
+/**
+ * Retrieves the command for a given verb. Entries of plain words are split into
+ * argv, so the command runs without a shell; the shell is only used for entries
+ * that need it. Entries may hold several words ("--purge -y").
+ *
+ * @param verb The verb for which to retrieve the command.
+ * @param vParams Parameters, appended as separate arguments; appended to the
+ *                command line as they are if the verb needs the shell.
+ * @return The command, with empty vArgs and sCommandLine if the verb is not defined.
+ */
+stVerbCommand CCommandReference::getCommand(const std::string& verb, const std::vector<std::string>& vParams) {
+    stVerbCommand command;
+    std::vector<std::string> vCommands = getCommandsForVerb(verb);
+    if (vCommands.empty()) {
+        return command;
+    }
+
+    std::stringstream ss_command;
+    for (size_t i = 0; i < vCommands.size(); i++) {
+        ss_command << vCommands[i] << " ";
+        command.bShell = command.bShell || needsShell(vCommands[i], i == 0);
+    }
+    for (const auto& sParam : vParams) {
+        ss_command << sParam << " ";
+    }
+    command.sCommandLine = ss_command.str();
+
+    if (!command.bShell) {
+        for (const auto& sEntry : vCommands) {
+            std::istringstream iss(sEntry);
+            std::string sArg;
+            while (iss >> sArg) {
+                command.vArgs.push_back(sArg);
+            }
+        }
+        command.vArgs.insert(command.vArgs.end(), vParams.begin(), vParams.end());
+    }
+    return command;
+}
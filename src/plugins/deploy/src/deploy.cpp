@@ -82,7 +82,6 @@ int CDeploy::init() {
         std::string msg = "deploy log start";
         pLog->Log(msg, (int)pLog->_log_type::info);
 
-        map_string_fPtr["info"] = &CDeploy::handleInfo;
         map_string_fPtr["deploy"] = &CDeploy::handleDeployment;
         map_string_fPtr["validate"] = &CDeploy::handleValidate;
 
@@ -120,20 +119,19 @@ std::string CDeploy::handleInfo(std::string sReq) {
 
 /**
  * Handles the cancellation of a deployment request.
+ * Called from another thread while the deployment runs; the deployment stops
+ * before the next action and the running command is terminated.
  * 
- * @param sReq The request data in string format.
+ * @param sReq The request being cancelled.
  * @return The response data in JSON format.
  */
 std::string CDeploy::handleCancel(std::string sReq) {
     
-    json jsonRequest = json::parse(sReq);
     std::cout << "deploy: handleCancel" << std::endl;
-    //todo: publish schema
-    CRequest reqInfo;
-    if(jsonRequest.contains("id")) { reqInfo.sId = jsonRequest.at("id").get<std::string>(); }
     
     auto response = json::object();
     try{
+        mbCancel = true;
         response[STATUS] = SUCCESS;
 	} catch (const std::exception& e) {
         std::string msg = "Exception : ";
@@ -148,25 +146,33 @@ std::string CDeploy::handleCancel(std::string sReq) {
 /**
  * Handles the entry point for the deploy functionality.
  *
- * @param sReq The request string to be processed.
- * @return A JSON string containing the response.
+ * @param jReq The parsed request.
+ * @param pCancel cancel flag of the framework, reset before the request starts; NULL: handleCancel sets our own.
+ * @return The response.
  */
-std::string CDeploy::handleEntry(std::string sReq) {
+json CDeploy::handleEntry(const json& jReq, artifacts_t* pArtifacts, CResponseSink* pSink, CTaskExecutor* pExecutor,
+                          const std::atomic<bool>* pCancel) {
 
-    std::cout << "handleEntry: " << sReq << std::endl;
+    std::cout << "handleEntry: " << jReq << std::endl;
     auto response = json::object();
+    mpArtifacts = pArtifacts;
+    mpSink = pSink;
+    mpExecutor = pExecutor;
+    if (!pCancel) {
+        mbCancel = false; //a framework without its own flag, a cancel before this point is lost
+    }
+    mpCancel = pCancel ? pCancel : &mbCancel;
     //todo: publish schema
     try {
         //parse request
         std::string api = "";//, manifestPath = "";
         //int continueCounter = 0;
-        json jReq = json::parse(sReq);
         if(jReq.contains("api")) { api = jReq.at("api").get<std::string>(); }
 
         if(api.compare("deploy") ==0) {
-            return handleDeployment(sReq);
+            return handleDeployment(jReq);
         } else if(api.compare("validate") ==0) {
-            return handleValidate(sReq);
+            return handleValidate(jReq);
         }
           else {
             response[STATUS] = FAILURE;
@@ -179,7 +185,7 @@ std::string CDeploy::handleEntry(std::string sReq) {
         response[DESCRIPTION] = msg;
 	}
 
-	return response.dump();
+	return response;
     
 }
 
@@ -190,21 +196,34 @@ std::string CDeploy::handleEntry(std::string sReq) {
 * @return json std::string on success, empty std::string on failure.
 * @return summary of what actions are enforced.         
 */
-std::string CDeploy::handleDeployment(std::string sReq) {
+json CDeploy::handleDeployment(const json& jReq) {
     
     auto response = json::object();	
     std::string manifestPath = "";
+    const json* pManifest = NULL; //manifest already in memory
     int continueCounter = 0;
-    json jReq = json::parse(sReq);
-    if(jReq.contains("manifest")) { manifestPath = jReq.at("manifest").get<std::string>(); }
+    if(jReq.contains("manifest")) {
+        const json& jManifest = jReq.at("manifest");
+        if (jManifest.is_object()) {
+            pManifest = &jManifest;
+        } else {
+            manifestPath = jManifest.get<std::string>();
+            //handed over by an earlier pipeline stage
+            if (mpArtifacts && mpArtifacts->count(manifestPath)) {
+                pManifest = &mpArtifacts->at(manifestPath);
+            }
+        }
+    }
     if(jReq.contains("continue")) { continueCounter = jReq.at("continue").get<int>(); }
+    bool bRestart = false; //discard the journal of an earlier run
+    if(jReq.contains("restart")) { bRestart = jReq.at("restart").get<bool>(); }
     
     std::cout << "handleDeployment: " << manifestPath << std::endl;
 
-	if (manifestPath.empty()) {//1 param
+	if (manifestPath.empty() && !pManifest) {//1 param
 		response[STATUS] = FAILURE;
         response[DESCRIPTION] = INVALID_REQUEST;
-        return response.dump();
+        return response;
 	}
     
     CAPIHandlers *pAPIhandler = NULL; 
@@ -212,10 +231,16 @@ std::string CDeploy::handleDeployment(std::string sReq) {
             //std::cout << "manifest path: " << manifestPath << std::endl;
         
             //load manifest
-            pAPIhandler = new CAPIHandlers();
+            pAPIhandler = new CAPIHandlers(mpArtifacts, mpCancel, mpSink, mpExecutor);
             if(pAPIhandler) {
-                int retVal = pAPIhandler->startDeploy(manifestPath, continueCounter);
-                if(retVal == 0) {
+                pAPIhandler->setRestart(bRestart);
+                int retVal = pManifest ?
+                    pAPIhandler->startDeploy(*pManifest, continueCounter) :
+                    pAPIhandler->startDeploy(manifestPath, continueCounter);
+                if(*mpCancel) {
+                    response[STATUS] = FAILURE;
+                    response[DESCRIPTION] = CANCELLED;
+                } else if(retVal == 0) {
                     response[STATUS] = SUCCESS;
                     
                 } else {
@@ -250,17 +275,25 @@ std::string CDeploy::handleDeployment(std::string sReq) {
 	}
     
     if (pAPIhandler){
+        //what ran, also for failed and cancelled deployments
+        response[REPORT] = pAPIhandler->getRunReport();
+        try {
+            std::ofstream reportFile(std::filesystem::current_path() / DEPLOY_REPORT_FILE);
+            reportFile << response[REPORT].dump(2) << std::endl;
+        } catch (const std::exception& e) {
+            std::cout << "run report not written: " << e.what() << std::endl;
+        }
         delete pAPIhandler; 
         pAPIhandler = NULL; 
     }
-	return response.dump();
+	return response;
 }
 
 
 /**
 * validate the schema
 */
-std::string CDeploy::handleValidate(std::string message)
+json CDeploy::handleValidate(const json& jReq)
 {
     auto response = json::object();  
    try {
@@ -286,6 +319,6 @@ std::string CDeploy::handleValidate(std::string message)
            response[DESCRIPTION] = INTERNAL_ERROR;
  
 	}
-    return response.dump();
+    return response;
 
 }
@@ -114,6 +114,7 @@ public:
         eREBOOT2,
         
         eDOWNLOAD,
+        eGIT_CLONE,
         eKPATCH_APPLY,
         
         eSTART_SERVICE,
@@ -188,6 +189,7 @@ public:
         s_mapStringVerbs["REBOOT2"] = eREBOOT2;
         
         s_mapStringVerbs["DOWNLOAD"] = eDOWNLOAD;
+        s_mapStringVerbs["GIT_CLONE"] = eGIT_CLONE;
         s_mapStringVerbs["KPATCH_APPLY"] = eKPATCH_APPLY;    
 
         s_mapStringVerbs["START_SERVICE"] = eSTART_SERVICE;
@@ -19,15 +19,25 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <queue>
+#include <set>
 
 #include "manifestDataStructure.h"
 #include "commandreference.h"
 #include "actions.h"
+#include "pluginInterface.h"
+#include "privilegedHelper.h"
+#include "commandCache.h"
+#include "latencyHistogram.h"
+#include "prefetcher.h"
+#include "executionJournal.h"
+#include "process.h"
 
 /*! Class to handle APIs */
 class CAPIHandlers {
@@ -36,7 +46,86 @@ private:
 
     /** manifest datastructure for parsing */
     CPkgManifest* _pManifest = NULL;
+
+    /** manifest already in memory, read instead of the manifest file */
+    const nlohmann::json* _pManifestData = NULL;
+
+    /** pipeline artifacts, NULL outside a pipeline */
+    artifacts_t* _pArtifacts = NULL;
+
+    /** set by the framework to stop the deployment, may be NULL */
+    const std::atomic<bool>* _pCancelRequest = NULL;
+
+    /** receives progress, may be NULL */
+    CResponseSink* _pSink = NULL;
+
+    /** framework thread pool the action commands run on, may be NULL */
+    CTaskExecutor* _pExecutor = NULL;
+
+    /** results of probes that do not change during a deployment, in memory */
+    CCommandCache _probeCache;
+
+    /** run the sudo commands, one helper per action running at the same time, started when needed */
+    CPrivilegedHelperPool _privHelpers;
+    /** runs the apt pass of the prefetcher, so it does not hold the helper of the actions */
+    CPrivilegedHelper* _pPrefetchHelper = NULL;
+    std::mutex _mtxPrefetchHelper;
     
+    /** resource use of the action commands of one verb */
+    struct stVerbStats {
+        CLatencyHistogram wallMs;
+        CLatencyHistogram spawnUs;
+        CLatencyHistogram cpuMs;
+        uint64_t failed = 0;
+    };
+    /** guards the run report and m_actionCount, actions may run at the same time */
+    std::mutex _mtxRun;
+    /** one entry per action command run, in order */
+    nlohmann::json _jActionRecords = nlohmann::json::array();
+    std::map<std::string, stVerbStats> _verbStats;
+    /** adds a command to the run report; outputBytes -1 if the output was not captured */
+    void recordAction(const std::string& sAction, const std::string& sCommand, const stProcessResult& result,
+                      long outputBytes, const stSchedPolicy& sched);
+
+    /** fetches the artifacts of the manifest being run, NULL if there are none */
+    CPrefetcher* _pPrefetcher = NULL;
+    /** prefetch item of a DOWNLOAD or GIT_CLONE action */
+    std::map<const CManifestActData*, size_t> _mPrefetchIds;
+    /** the apt download pass, held until the package actions before the first INSTALL are done */
+    size_t _aptPrefetchId = 0;
+    bool _bAptPrefetch = false;
+    std::set<const CManifestActData*> _aptGateActions;
+    /** prefetch items of the manifests run, for the report */
+    nlohmann::json _jPrefetchRecords = nlohmann::json::array();
+    void startPrefetch(bool bPrepare);
+    void stopPrefetch();
+    /** waits while the item of the action is fetched; false if it has none or it is not there */
+    bool prefetched(const CManifestActData* pActItem, std::string& sPath);
+    /** before a package action: waits for the apt pass while it runs, bInstall drops it if not started */
+    void waitForAptPrefetch(bool bInstall);
+    /** after a package action: releases the apt pass once the actions before the first INSTALL are done */
+    void aptActionDone(const CManifestActData* pActItem);
+
+    /** actions completed by this and earlier runs of the manifest, NULL for prepare or if it cannot be written */
+    CExecutionJournal* _pJournal = NULL;
+    /** true if the journal was made for the same manifest content, its actions are taken by id */
+    bool _bJournalCurrent = false;
+    /** the journal of an earlier run is discarded */
+    bool _bRestart = false;
+    /** actions taken as done from the journal, for the report */
+    size_t _resumedActions = 0;
+    void openJournal(const std::string& manifestPath, bool bPrepare);
+    void closeJournal();
+    /** true and its record if the action completed in an earlier run, unchanged */
+    bool journaled(CManifestActData* pActItem, stJournalRecord& record);
+    /** records a completed action, started at startMs; nothing once the run is cancelled */
+    void journalAction(CManifestActData* pActItem, int64_t startMs, int result);
+
+    /** "default" and "verbs" priorities of DEPLOY_PRIORITY_FILE, empty without the file */
+    nlohmann::json _jPriorityConfig;
+    /** priority of an action: config default, config verb, manifest prop, action - the later wins */
+    stSchedPolicy schedPolicyFor(const CManifestActData* pActItem);
+
     /*! target directory to archive */
     std::string sArchiveDir;
     
@@ -67,12 +156,16 @@ private:
     std::string sManifestParentPath;
     std::string sPkgPath;
 
-    // First Node of the graph (Root Node)
-    Node* SNode;
-    std::string succFailVar;
+    /** the run stopped at a reboot checkpoint */
+    bool _bRebootPending = false;
         
     int handleAction(CManifestActData *pActItem, bool bPrepare);
     int coreHandler(std::string manifestPath, bool bPrepare, std::string archivePath);
+    /** runs the actions of the manifest along its graph, once */
+    bool runGraph(bool bPrepare);
+    /** runs the actions from pFirst to the next REBOOT or PRE_CHECK of its phase at the same time,
+     *  up to limit; returns the node to go on with */
+    Node* runParallel(Node* pFirst, size_t limit, bool bPrepare);
     
     //! private variable 
     /*! function pointer */            
@@ -83,11 +176,6 @@ private:
     // Return 0 if the expected value is the same as return value; otherwise 1s
     int rValue(CManifestActData *pActItem, bool bPrepare);     
     
-    //handle custom action which is normally not a standard action defined by commands
-    int handleCustomAction(CManifestActData *pActItem, bool bPreapre);
-    
-    bool checkandStartAction(std::string strAction);        
-    
     //custom function for kernel version
 
     int kernelCheck(CManifestActData *pActItem, bool bPrepare);    
@@ -96,14 +184,28 @@ private:
     bool evalCondition(std::string sSource, std::string sTarget, std::string sCondition);
     bool _bCancel = false; 
     void cancelPackage();
+    /** manifest asked to stop or the request was cancelled */
+    bool isCancelled();
+    /** report the action about to run */
+    void reportProgress(const char* sPhase, size_t step, size_t total, const std::string& sAction);
+    /** run an action command on the framework threads and wait for it */
+    std::string runActionCmd(const stVerbCommand& command, const CManifestActData* pActItem, bool& bMatched,
+                             stProcessResult* pResult = NULL);
+    /** packages or .deb files of an INSTALL, REMOVE or LOCAL_INSTALL action */
+    std::vector<std::string> packageParams(const CManifestActData* pActItem);
+    /** runs package actions of one verb as one apt/dpkg transaction; results per action */
+    std::vector<int> runPackageBatch(const std::vector<CManifestActData*>& vItems, bool bPrepare);
     bool getApplicablityData(std::string pkgname);
     
     int m_continueCount;
+    /** numbers the output files of the action commands */
+    int m_actionCount;
     std::string pltName;
   
 public:
 
-    CAPIHandlers();
+    CAPIHandlers(artifacts_t* pArtifacts = NULL, const std::atomic<bool>* pCancelRequest = NULL, CResponseSink* pSink = NULL,
+                 CTaskExecutor* pExecutor = NULL);
     ~CAPIHandlers();
     
  
@@ -113,5 +215,19 @@ public:
     *   returns success (0)/Errors(invalid path, corrupted file, permission issues, incomplete manifest)
     */
     int startDeploy(std::string manifestPath, int continueCount);
+
+    /** deploy components from a manifest already in memory
+    *   param: manifest content
+    *   param: continueCount - play actions after reboot.
+    */
+    int startDeploy(const nlohmann::json& jManifest, int continueCount);
+
+    /** bRestart - start over, the actions done by an earlier run that did not complete are run again */
+    void setRestart(bool bRestart) { _bRestart = bRestart; }
+
+    /** run report: the action commands run so far and per verb histograms of
+    *   wall time (ms), spawn latency (us) and cpu time (ms)
+    */
+    nlohmann::json getRunReport() const;
 };
 
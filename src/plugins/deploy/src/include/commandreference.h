@@ -19,8 +19,20 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
+/** command to run for a verb */
+struct stVerbCommand {
+    /** entries with pipes, redirections, quoting or shell builtins run with /bin/sh -c */
+    bool bShell = false;
+    /** argv, if not bShell */
+    std::vector<std::string> vArgs;
+    /** command line for the shell, and for logs */
+    std::string sCommandLine;
+};
+
 /** Command Reference class */
 class CCommandReference {
 
@@ -54,4 +66,8 @@ public:
      /** return commands for given verb
      */
     std::vector<std::string> getCommandsForVerb(std::string verb);
+
+    /** return the command for given verb; vParams are appended as separate arguments
+     */
+    stVerbCommand getCommand(const std::string& verb, const std::vector<std::string>& vParams = {});
 };
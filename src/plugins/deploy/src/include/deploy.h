@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <string>
 
@@ -27,6 +28,7 @@ using json = nlohmann::json;
 
 
 #include "applog.h"
+#include "pluginInterface.h"
 
 class CRequest {
 public:
@@ -62,7 +64,8 @@ public:
      * @return json std::string on success, empty std::string on failure.
      */        
     std::string handleInfo(std::string sReq);
-    std::string handleEntry(std::string sReq);
+    json handleEntry(const json& jReq, artifacts_t* pArtifacts = NULL, CResponseSink* pSink = NULL,
+                     CTaskExecutor* pExecutor = NULL, const std::atomic<bool>* pCancel = NULL);
     std::string handleCancel(std::string sReq);
 
 private:
@@ -72,31 +75,45 @@ private:
 
 	/** log manager */
 	applog *pLog = NULL;
+
+    /** pipeline artifacts of the current request, NULL outside a pipeline */
+    artifacts_t *mpArtifacts = NULL;
+
+    /** response sink of the current request, receives progress */
+    CResponseSink *mpSink = NULL;
+
+    /** framework thread pool, NULL if the framework has none */
+    CTaskExecutor *mpExecutor = NULL;
+
+    /** set by handleCancel from another thread, polled by the running deployment */
+    std::atomic<bool> mbCancel {false};
+    /** cancel flag of the current request: the framework one, else mbCancel */
+    const std::atomic<bool>* mpCancel = &mbCancel;
         
     /*! function pointer definition */            
-    typedef std::string (CDeploy::*fPtr)(std::string);
+    typedef json (CDeploy::*fPtr)(const json&);
       
     /*! map of functional pointers and std::string API string */
     std::map<std::string, fPtr> map_string_fPtr;
 
          
     /*! function to enforce manifest action items.
-     * @param[in] std::string message
+     * @param[in] parsed request
      * @param[in] integer - continue after reboot
      * @throws none
-     * @return json std::string on success, empty std::string on failure.
+     * @return json response.
      */         
     //std::string handleDeployment(std::string message, int continueCounter);
-    std::string handleDeployment(std::string sReq);
+    json handleDeployment(const json& jReq);
 
 
     /*! function to enforce manifest action items.
-     * @param[in] std::string message
+     * @param[in] parsed request
      * @throws none
-     * @return json std::string on success, empty std::string on failure.
+     * @return json response.
      */         
     //std::string handleDeployment(std::string message, int continueCounter);
-    std::string handleValidate(std::string sReq);
+    json handleValidate(const json& jReq);
 
     /*! initialization function
      * @return 0 on success.
@@ -26,3 +26,35 @@
 #define STATUS "status" 
 #define DESCRIPTION "desc" 
 #define INTERNAL_ERROR "Internal error" 
+#define CANCELLED "request cancelled"
+#define REPORT "report"
+
+/** cpu and i/o priority of the action commands per verb, under config/ of the working directory */
+#define DEPLOY_PRIORITY_FILE "deploy_priority.json"
+
+/** run report of a deployment: every action command and per verb latency histograms, in the working directory */
+#define DEPLOY_REPORT_FILE "deploy-report.json"
+
+/** most actions of a phase running at the same time, whatever the manifest asks for */
+#define DEPLOY_PARALLEL_MAX 16
+/** resource of the actions that run apt or dpkg, they wait for each other */
+#define DEPLOY_RESOURCE_DPKG "dpkg-lock"
+
+/** artifacts fetched ahead of their actions (files, git mirrors), under the working directory */
+#define DEPLOY_PREFETCH_DIR "deploy-prefetch"
+/** artifacts fetched at the same time */
+#define DEPLOY_PREFETCH_THREADS 4
+
+/** journal of the actions a deployment completed, <hash of the manifest>.journal under the working directory */
+#define DEPLOY_JOURNAL_DIR "deploy-journal"
+
+/** wall clock limit of an action command or script (ms), it is stopped after that */
+#define DEPLOY_ACTION_TIMEOUT_MS (60L * 60 * 1000)
+
+/** output of an action command kept in memory: its first and last bytes */
+#define DEPLOY_OUTPUT_HEAD (16 * 1024)
+#define DEPLOY_OUTPUT_TAIL (16 * 1024)
+/** complete output of every action command, <n>-<action>.log under the working directory */
+#define DEPLOY_OUTPUT_DIR "deploy-output"
+/** an output file is moved to <file>.1 when it reaches this size */
+#define DEPLOY_OUTPUT_FILE_MAX (16 * 1024 * 1024)
@@ -52,7 +52,7 @@ public:
     EXPORT void deinit(void* pCxt);
 };*/
 
-class CPlugin : public CPluginInterface {
+class CPlugin : public CPluginInterfaceV2 {
 private:
     CDeploy* pInstance;
     
@@ -64,7 +64,7 @@ public:
     void deinit(void* pCxt);
 
     std::string getInfo(void* pCxt);
-    std::string entry(void* pCxt, std::string sReq);
+    void entryV2(void* pCxt, const nlohmann::json& jReq, CResponseSink& sink);
     void cancel(void* pCxt, std::string sReq);
     
 };
@@ -27,14 +27,24 @@
 
 //extern std::string getInfoC(void* pCtx);
 
-extern "C" CPluginInterface* create() {
+PLUGIN_FACTORY CPluginInterface* create() {
     return new CPlugin;
 }
 
-extern "C" void destroy(CPluginInterface* pPlugin) {
+PLUGIN_FACTORY void destroy(CPluginInterface* pPlugin) {
     delete pPlugin;
 }
 
+PLUGIN_FACTORY CPluginInterfaceV2* create_v2() {
+    return new CPlugin;
+}
+
+PLUGIN_FACTORY int abi_version() {
+    return PLUGIN_ABI_VERSION;
+}
+
+REGISTER_BUILTIN_PLUGIN("deploy")
+
 CPlugin::CPlugin() {
     init(NULL);
 }
@@ -60,12 +70,14 @@ std::string CPlugin::getInfo(void* pCxt) {
 /**
  * \brief Entry point for the deploy service.
  * \param pCxt A pointer to the context.
- * \param sReq The request string.
- * \return The response string.
+ * \param jReq The parsed request.
+ * \param sink Receives the response.
  */
-std::string CPlugin::entry(void* pCxt, std::string sReq) {
+void CPlugin::entryV2(void* pCxt, const nlohmann::json& jReq, CResponseSink& sink) {
     CLogger::getInstance().log(PROGRAM_DEBUG_LEVEL, "deploy service entry");
-    return pInstance->handleEntry(sReq);
+    CProgramContext* pCtx = (CProgramContext*)pCxt;
+    sink.write(pInstance->handleEntry(jReq, pCtx ? pCtx->pArtifacts : NULL, &sink, pCtx ? pCtx->pExecutor : NULL,
+                                      pCtx ? pCtx->pCancel : NULL));
 }
 
 void CPlugin::cancel(void* pCxt, std::string sReq) {
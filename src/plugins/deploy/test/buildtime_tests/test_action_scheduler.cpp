@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <iostream>        // Console output of the test results.
+#include <cassert>         // Assertions to validate test conditions.
+#include "actionScheduler.h"    // CActionScheduler under test.
+
+/**
+ * @class CActionSchedulerTest
+ * @brief Tests of the scheduler deciding which deploy actions run at the same time.
+ */
+class CActionSchedulerTest {
+public:
+
+    /**
+     * @brief Independent actions start together, a dependent one after its dependency.
+     */
+    void testDependencies() {
+        std::vector<stScheduledAction> vActions(3);
+        vActions[2].vDepends = {0};
+        CActionScheduler scheduler(vActions);
+        assert(scheduler.next() == 0);
+        assert(scheduler.next() == 1);
+        assert(scheduler.next() == CActionScheduler::npos);
+        assert(scheduler.running() == 2);
+        scheduler.finish(0);
+        assert(scheduler.next() == 2);
+        scheduler.finish(1);
+        scheduler.finish(2);
+        assert(scheduler.isDone());
+        std::cout << "testDependencies passed!" << std::endl;
+    }
+
+    /**
+     * @brief Actions sharing a resource never run together, later ready ones may pass them.
+     */
+    void testResources() {
+        std::vector<stScheduledAction> vActions(3);
+        vActions[0].vResources = {"dpkg-lock"};
+        vActions[1].vResources = {"dpkg-lock"};
+        vActions[2].vResources = {"path:/opt/x"};
+        CActionScheduler scheduler(vActions);
+        assert(scheduler.next() == 0);
+        assert(scheduler.next() == 2);
+        assert(scheduler.next() == CActionScheduler::npos);
+        scheduler.finish(0);
+        assert(scheduler.next() == 1);
+        std::cout << "testResources passed!" << std::endl;
+    }
+
+    /**
+     * @brief Paths conflict with their parents and children, everything with "*".
+     */
+    void testConflicts() {
+        assert(CActionScheduler::conflicts("path:/opt/x", "path:/opt/x/y"));
+        assert(CActionScheduler::conflicts("path:/opt/x/y", "path:/opt/x"));
+        assert(!CActionScheduler::conflicts("path:/opt/x", "path:/opt/xy"));
+        assert(CActionScheduler::conflicts("path:/", "path:/opt"));
+        assert(CActionScheduler::conflicts("*", "service:a"));
+        assert(!CActionScheduler::conflicts("service:a", "service:b"));
+        std::cout << "testConflicts passed!" << std::endl;
+    }
+
+    /**
+     * @brief Dependencies on the own or later actions are dropped, so there is no cycle.
+     */
+    void testNoCycle() {
+        std::vector<stScheduledAction> vActions(2);
+        vActions[0].vDepends = {1};
+        vActions[1].vDepends = {0, 0, 1};
+        CActionScheduler scheduler(vActions);
+        assert(scheduler.next() == 0);
+        assert(scheduler.next() == CActionScheduler::npos);
+        scheduler.finish(0);
+        assert(scheduler.next() == 1);
+        scheduler.finish(1);
+        assert(scheduler.isDone());
+        std::cout << "testNoCycle passed!" << std::endl;
+    }
+};
+
+/**
+ * @brief Entry function for the test program.
+ * @return 0 on successful execution of all tests.
+ */
+int main() {
+    CActionSchedulerTest schedulerTest;
+    schedulerTest.testDependencies();
+    schedulerTest.testResources();
+    schedulerTest.testConflicts();
+    schedulerTest.testNoCycle();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <iostream>        // Console output of the test results.
+#include <cassert>         // Assertions to validate test conditions.
+#include <filesystem>      // Temporary directory of the journal.
+#include <fstream>         // Appends a cut off line to the journal.
+#include <unistd.h>        // getpid for a unique directory.
+#include "executionJournal.h"   // CExecutionJournal under test.
+
+/**
+ * @class CExecutionJournalTest
+ * @brief Tests of the journal a deployment resumes from.
+ */
+class CExecutionJournalTest {
+private:
+    std::filesystem::path mDir;
+
+public:
+    CExecutionJournalTest() {
+        mDir = std::filesystem::temp_directory_path() / ("execution_journal_test_" + std::to_string(getpid()));
+    }
+
+    ~CExecutionJournalTest() {
+        std::filesystem::remove_all(mDir);
+    }
+
+    /**
+     * @brief Records outlive the journal object; a changed input hash is not done.
+     */
+    void testResume() {
+        std::string sFile = (mDir / "journal" / "run.journal").generic_string();
+        {
+            CExecutionJournal journal;
+            assert(journal.open(sFile));
+            assert(journal.size() == 0);
+            stJournalRecord record;
+            record.sHash = CExecutionJournal::hash("INSTALL curl");
+            record.startMs = 10;
+            record.endMs = 20;
+            journal.record("act/0", record);
+            record.sHash = CExecutionJournal::hash("UNTAR a.tar");
+            record.result = 1;
+            journal.record("act/1", record);
+        }
+        CExecutionJournal journal;
+        assert(journal.open(sFile));
+        assert(journal.size() == 2);
+        stJournalRecord record;
+        assert(journal.lookup("act/0", CExecutionJournal::hash("INSTALL curl"), record));
+        assert(record.startMs == 10 && record.endMs == 20 && record.result == 0);
+        assert(!journal.lookup("act/1", CExecutionJournal::hash("UNTAR b.tar"), record));
+        std::string sNode;
+        assert(journal.last(sNode, record));
+        assert(sNode == "act/1" && record.result == 1);
+
+        journal.remove();
+        assert(!std::filesystem::exists(sFile));
+        std::cout << "testResume passed!" << std::endl;
+    }
+
+    /**
+     * @brief A line cut off by a crash is dropped, the records after it are appended cleanly.
+     */
+    void testTornLine() {
+        std::string sFile = (mDir / "torn.journal").generic_string();
+        {
+            CExecutionJournal journal;
+            assert(journal.open(sFile));
+            stJournalRecord record;
+            record.sHash = CExecutionJournal::hash("a");
+            journal.record("preact/0", record);
+        }
+        std::ofstream(sFile, std::ios::app) << "act/0\t00ab";
+        {
+            CExecutionJournal journal;
+            assert(journal.open(sFile));
+            assert(journal.size() == 1);
+            stJournalRecord record;
+            record.sHash = CExecutionJournal::hash("b");
+            journal.record("act/0", record);
+        }
+        CExecutionJournal journal;
+        assert(journal.open(sFile));
+        assert(journal.size() == 2);
+        stJournalRecord record;
+        assert(journal.lookup("act/0", CExecutionJournal::hash("b"), record));
+        std::cout << "testTornLine passed!" << std::endl;
+    }
+
+    /**
+     * @brief Records are taken by id while the content hash is the one they were made for.
+     */
+    void testContent() {
+        std::string sFile = (mDir / "content.journal").generic_string();
+        {
+            CExecutionJournal journal;
+            assert(journal.open(sFile, "A"));
+            assert(journal.isContentCurrent());
+            stJournalRecord record;
+            record.sHash = CExecutionJournal::hash("a");
+            journal.record("act/0", record);
+        }
+        stJournalRecord record;
+        {
+            CExecutionJournal journal;
+            assert(journal.open(sFile, "A"));
+            assert(journal.isContentCurrent());
+            assert(journal.lookup("act/0", record));
+        }
+        {
+            CExecutionJournal journal;
+            assert(journal.open(sFile, "B"));
+            assert(!journal.isContentCurrent());
+            assert(journal.lookup("act/0", CExecutionJournal::hash("a"), record));
+            record.sHash = CExecutionJournal::hash("b");
+            journal.record("act/1", record);
+        }
+        //act/0 was made for "A", the node hashes still decide
+        CExecutionJournal journal;
+        assert(journal.open(sFile, "B"));
+        assert(!journal.isContentCurrent());
+        assert(journal.size() == 2);
+        journal.remove();
+        assert(journal.open(sFile, "B"));
+        assert(journal.isContentCurrent());
+        std::cout << "testContent passed!" << std::endl;
+    }
+};
+
+/**
+ * @brief Entry function for the test program.
+ * @return 0 on successful execution of all tests.
+ */
+int main() {
+    CExecutionJournalTest journalTest;
+    journalTest.testResume();
+    journalTest.testTornLine();
+    journalTest.testContent();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -108,6 +108,53 @@ public:
         assert(actions[0]->next_nodes[0] == actions[1]);
         std::cout << "testBuildDAG passed!" << std::endl;
     }
+
+    /**
+     * @brief Test to check the node that follows an action, as the manifest runner walks the graph.
+     *
+     * This function validates that `receive_next_node` selects the on_success and on_failure tags,
+     * falls back to the following node without a matching tag, and ends the run after the last
+     * action of a tag.
+     */
+    void testReceiveNextNode() {
+        //act: both tags, none, on_success only, none, a tag that does not exist
+        insertNewNode(nullptr, new NodeData{"install", "a", "bad", "ok"});
+        insertNewNode(nullptr, new NodeData{"install", "b", "", ""});
+        insertNewNode(nullptr, new NodeData{"install", "d", "", "ok"});
+        insertNewNode(nullptr, new NodeData{"install", "c", "", ""});
+        insertNewNode(nullptr, new NodeData{"install", "e", "missing", ""});
+        insertNewNodeTags(nullptr, "ok", new NodeData{"execute", "ok.sh", "", ""});
+        insertNewNodeTags(nullptr, "bad", new NodeData{"execute", "bad1.sh", "", ""});
+        insertNewNodeTags(nullptr, "bad", new NodeData{"execute", "bad2.sh", "", ""});
+        buildingDAG();
+
+        Node* pA = vNodes[0];
+        Node* pB = vNodes[1];
+        Node* pD = vNodes[2];
+        Node* pC = vNodes[3];
+        Node* pE = vNodes[4];
+        Node* pOk = mapGraphList["ok"][0];
+        Node* pBad1 = mapGraphList["bad"][0];
+        Node* pBad2 = mapGraphList["bad"][1];
+
+        //on_success / on_failure selection
+        assert(receive_next_node(pA, 0) == pOk);
+        assert(receive_next_node(pA, 1) == pBad1);
+        //following node without a tag for the result
+        assert(receive_next_node(pB, 0) == pD);
+        assert(receive_next_node(pB, 1) == pD);
+        assert(receive_next_node(pD, 0) == pOk);
+        assert(receive_next_node(pD, 1) == pC);
+        assert(receive_next_node(pE, 1) == endNode);
+        //the last action of the list and of a tag end the run
+        assert(receive_next_node(pC, 0) == pE);
+        assert(receive_next_node(pE, 0) == endNode);
+        assert(receive_next_node(pBad1, 1) == pBad2);
+        assert(receive_next_node(pBad2, 0) == endNode);
+        assert(receive_next_node(pOk, 1) == endNode);
+        assert(receive_next_node(nullptr, 0) == endNode);
+        std::cout << "testReceiveNextNode passed!" << std::endl;
+    }
 };
 
 /**
@@ -122,6 +169,7 @@ int main() {
     graphTest.testAddEdge();
     graphTest.testParseJsonToNodes();
     graphTest.testBuildDAG();
+    graphTest.testReceiveNextNode();
  
     std::cout << "All tests passed!" << std::endl;
     return 0;
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <iostream>        // Console output of the test results.
+#include <cassert>         // Assertions to validate test conditions.
+
+#include "latencyHistogram.h"   // CLatencyHistogram under test.
+
+/**
+ * @class CLatencyHistogramTest
+ * @brief Tests of the fixed memory latency histogram of the deploy run report.
+ */
+class CLatencyHistogramTest {
+public:
+
+    /**
+     * @brief Small values are counted exactly.
+     */
+    void testExactValues() {
+        CLatencyHistogram hist;
+        for (uint64_t value = 1; value <= 10; value++) {
+            hist.record(value);
+        }
+        assert(hist.count() == 10);
+        assert(hist.min() == 1);
+        assert(hist.max() == 10);
+        assert(hist.valueAtPercentile(50) == 5);
+        assert(hist.valueAtPercentile(100) == 10);
+        assert(hist.mean() == 5.5);
+        std::cout << "testExactValues passed!" << std::endl;
+    }
+
+    /**
+     * @brief Large values keep their percentile within the bucket precision.
+     */
+    void testPrecision() {
+        CLatencyHistogram hist;
+        for (uint64_t value = 1; value <= 100000; value++) {
+            hist.record(value * 1000);
+        }
+        uint64_t p99 = hist.valueAtPercentile(99);
+        assert(p99 >= 99000000 && p99 <= 99000000 + 99000000 / 32);
+        uint64_t p50 = hist.valueAtPercentile(50);
+        assert(p50 >= 50000000 && p50 <= 50000000 + 50000000 / 32);
+        std::cout << "testPrecision passed!" << std::endl;
+    }
+
+    /**
+     * @brief Values above the range are clamped, merged histograms add up.
+     */
+    void testClampAndMerge() {
+        CLatencyHistogram first;
+        CLatencyHistogram second;
+        first.record(3);
+        second.record(UINT64_MAX);
+        first.merge(second);
+        assert(first.count() == 2);
+        assert(first.min() == 3);
+        assert(first.max() == LATENCY_HISTOGRAM_MAX);
+        assert(first.valueAtPercentile(100) == LATENCY_HISTOGRAM_MAX);
+        assert(first.toJson()["p50"] == 3);
+
+        CLatencyHistogram empty;
+        assert(empty.valueAtPercentile(99) == 0);
+        assert(empty.toJson()["count"] == 0);
+        std::cout << "testClampAndMerge passed!" << std::endl;
+    }
+};
+
+/**
+ * @brief Entry function for the test program.
+ * @return 0 on successful execution of all tests.
+ */
+int main() {
+    CLatencyHistogramTest histTest;
+    histTest.testExactValues();
+    histTest.testPrecision();
+    histTest.testClampAndMerge();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <iostream>        // Console output of the test results.
+#include <cassert>         // Assertions to validate test conditions.
+#include <filesystem>      // Temporary files for the fetched artifacts.
+#include <fstream>         // Writes and reads the test artifacts.
+#include <thread>          // Serves the http stand-in.
+#include <unistd.h>        // getpid for a unique directory.
+#include <arpa/inet.h>     // Loopback address of the http stand-in.
+#include <sys/socket.h>    // Socket of the http stand-in.
+#include "prefetcher.h"         // CPrefetcher under test.
+
+/**
+ * @class CHttpStandIn
+ * @brief Answers http requests on the loopback interface with one fixed body.
+ */
+class CHttpStandIn {
+private:
+    int mFd = -1;
+    int mPort = 0;
+    std::thread mThread;
+
+    //coverity
+    CHttpStandIn(CHttpStandIn const&) = delete;
+    void operator=(CHttpStandIn const&) = delete;
+
+public:
+    /** serves sBody to the next nRequests requests */
+    CHttpStandIn(const std::string& sBody, int nRequests) {
+        mFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (mFd < 0 || bind(mFd, (sockaddr*)&addr, len) != 0 || listen(mFd, nRequests) != 0 ||
+            getsockname(mFd, (sockaddr*)&addr, &len) != 0) {
+            return;
+        }
+        mPort = ntohs(addr.sin_port);
+        mThread = std::thread([this, sBody, nRequests] {
+            std::string sResponse = "HTTP/1.0 200 OK\r\nContent-Length: " + std::to_string(sBody.size()) +
+                                    "\r\n\r\n" + sBody;
+            for (int i = 0; i < nRequests; i++) {
+                int client = accept(mFd, NULL, NULL);
+                if (client < 0) {
+                    return;
+                }
+                std::string sRequest;
+                char buf[512];
+                ssize_t n;
+                while (sRequest.find("\r\n\r\n") == std::string::npos && (n = read(client, buf, sizeof(buf))) > 0) {
+                    sRequest.append(buf, (size_t)n);
+                }
+                ssize_t written = write(client, sResponse.data(), sResponse.size());
+                (void)written;
+                close(client);
+            }
+        });
+    }
+
+    ~CHttpStandIn() {
+        if (mFd >= 0) {
+            shutdown(mFd, SHUT_RDWR);
+        }
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        if (mFd >= 0) {
+            close(mFd);
+        }
+    }
+
+    /** 0 if it could not listen */
+    int port() const { return mPort; }
+};
+
+/**
+ * @class CPrefetcherTest
+ * @brief Tests of the background fetching of deploy artifacts, with file:// urls
+ *        and a local http stand-in for wget.
+ */
+class CPrefetcherTest {
+private:
+    std::filesystem::path mDir;
+
+    std::string readFile(const std::string& sPath) {
+        std::ifstream file(sPath);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+public:
+    CPrefetcherTest() {
+        mDir = std::filesystem::temp_directory_path() / ("prefetcher_test_" + std::to_string(getpid()));
+        std::filesystem::create_directories(mDir);
+        std::ofstream(mDir / "artifact.tar") << "payload";
+    }
+
+    ~CPrefetcherTest() {
+        std::filesystem::remove_all(mDir);
+    }
+
+    /**
+     * @brief A file:// url is copied into the prefetch directory.
+     */
+    void testFetch() {
+        CPrefetcher prefetcher((mDir / "cache").generic_string());
+        size_t id = prefetcher.addUrl("file://" + (mDir / "artifact.tar").generic_string());
+        size_t missing = prefetcher.addUrl("file://" + (mDir / "missing.tar").generic_string());
+        prefetcher.start(2);
+        std::string sPath;
+        bool bFetched = prefetcher.waitFetched(id, sPath);
+        assert(bFetched);
+        assert(readFile(sPath) == "payload");
+        assert(sPath.find("artifact.tar") != std::string::npos);
+        bool bMissing = prefetcher.waitFetched(missing, sPath);
+        assert(!bMissing);
+        assert(prefetcher.toJson()[0]["state"] == "done");
+        assert(prefetcher.toJson()[1]["state"] == "failed");
+        (void)bFetched;
+        (void)bMissing;
+        std::cout << "testFetch passed!" << std::endl;
+    }
+
+    /**
+     * @brief An http url is fetched with wget, here from a local stand-in.
+     */
+    void testHttp() {
+        if (!CProcess::run({"wget", "--version"}).succeeded()) {
+            std::cout << "testHttp skipped, no wget" << std::endl;
+            return;
+        }
+        CHttpStandIn server("http payload", 1);
+        assert(server.port() != 0);
+        CPrefetcher prefetcher((mDir / "cache").generic_string());
+        size_t id = prefetcher.addUrl("http://127.0.0.1:" + std::to_string(server.port()) + "/remote.tar");
+        prefetcher.start(1);
+        std::string sPath;
+        bool bFetched = prefetcher.waitFetched(id, sPath);
+        assert(bFetched);
+        assert(readFile(sPath) == "http payload");
+        assert(sPath.find("remote.tar") != std::string::npos);
+        (void)bFetched;
+        std::cout << "testHttp passed!" << std::endl;
+    }
+
+    /**
+     * @brief An item not started when it is waited for is dropped; held items wait for release.
+     */
+    void testSkipAndHold() {
+        CPrefetcher prefetcher((mDir / "cache").generic_string());
+        size_t id = prefetcher.addUrl("file://" + (mDir / "artifact.tar").generic_string());
+        std::string sPath;
+        bool bFetched = prefetcher.wait(id, sPath); //no thread started
+        assert(!bFetched);
+        assert(prefetcher.toJson()[0]["state"] == "skipped");
+
+        size_t apt = prefetcher.addApt({"pkg"}, true);
+        prefetcher.start(1);
+        assert(prefetcher.toJson()[1]["state"] == "held");
+        prefetcher.release(apt);
+        //no root runner: it fails
+        bool bApt = prefetcher.waitFetched(apt, sPath);
+        assert(!bApt);
+        assert(prefetcher.toJson()[1]["state"] == "failed");
+        (void)bFetched;
+        (void)bApt;
+        std::cout << "testSkipAndHold passed!" << std::endl;
+    }
+};
+
+/**
+ * @brief Entry function for the test program.
+ * @return 0 on successful execution of all tests.
+ */
+int main() {
+    CPrefetcherTest prefetcherTest;
+    prefetcherTest.testFetch();
+    prefetcherTest.testHttp();
+    prefetcherTest.testSkipAndHold();
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <iostream>        // Console output of the test results.
+#include <cassert>         // Assertions to validate test conditions.
+#include <chrono>          // Wall time of the commands.
+#include <cstring>         // Compares the helper option.
+#include <thread>          // Runs commands at the same time.
+#include <unistd.h>        // geteuid, the helpers start without sudo as root.
+#include "privilegedHelper.h"   // CPrivilegedHelperPool under test.
+
+/**
+ * @class CPrivilegedHelperPoolTest
+ * @brief Tests that sudo commands of parallel actions overlap in their helpers.
+ *        The helpers are this executable, started with PRIVILEGED_HELPER_OPTION.
+ */
+class CPrivilegedHelperPoolTest {
+private:
+    /** runs nCommands "sleep <sSeconds>" at the same time, returns the wall time (ms) */
+    long runConcurrently(CPrivilegedHelperPool& pool, size_t nCommands, const std::string& sSeconds) {
+        auto started = std::chrono::steady_clock::now();
+        std::vector<std::thread> vThreads;
+        for (size_t i = 0; i < nCommands; i++) {
+            vThreads.emplace_back([&pool, &sSeconds] {
+                stProcessResult result;
+                bool bRun = pool.run({"sleep", sSeconds}, stProcessOptions(), result);
+                assert(bRun && result.succeeded());
+                (void)bRun;
+            });
+        }
+        for (std::thread& thread : vThreads) {
+            thread.join();
+        }
+        return (long)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+    }
+
+public:
+    /**
+     * @brief With max 1 the commands take turns, with max n they overlap.
+     */
+    void testOverlap() {
+        CPrivilegedHelperPool serial;
+        long serialMs = runConcurrently(serial, 3, "0.4");
+        assert(serial.started() == 1);
+        assert(serialMs >= 1200);
+
+        CPrivilegedHelperPool pool;
+        pool.setMax(3);
+        assert(!pool.isReady());
+        runConcurrently(pool, 3, "0.4");
+        assert(pool.isReady());
+        assert(pool.started() >= 2 && pool.started() <= 3);
+        //the helpers are running now and reused, the commands take as long as one
+        long parallelMs = runConcurrently(pool, pool.started(), "0.4");
+        assert(parallelMs < 800);
+        std::cout << "serial " << serialMs << " ms, " << pool.started() << " helpers " << parallelMs << " ms" << std::endl;
+
+        pool.stop();
+        assert(pool.started() == 0 && !pool.isReady());
+        (void)serialMs;
+        (void)parallelMs;
+        std::cout << "testOverlap passed!" << std::endl;
+    }
+};
+
+/**
+ * @brief Entry function for the test program, and of the helpers it starts.
+ * @return 0 on successful execution of all tests.
+ */
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], PRIVILEGED_HELPER_OPTION) == 0) {
+        return CPrivilegedHelper::serve();
+    }
+    //without root the helpers need sudo, which may ask for a password
+    if (geteuid() != 0) {
+        std::cout << "testOverlap skipped, not root" << std::endl;
+    } else {
+        CPrivilegedHelperPoolTest poolTest;
+        poolTest.testOverlap();
+    }
+
+    std::cout << "All tests passed!" << std::endl;
+    return 0;
+}
@@ -38,11 +38,15 @@ json j = {
     {"os", json::array({  
         json{
             {"name", "name"},
-            {"command", "cat /etc/os-release |grep PRETTY_NAME= |cut -f2 -d="}
+            {"command", "cat /etc/os-release |grep PRETTY_NAME= |cut -f2 -d="},
+            {"readonly", true},
+            {"depends", {"/etc/os-release"}}
         },
         json{
             {"name","version"},       
-            {"command", "cat /etc/os-release |grep VERSION= |cut -f2 -d="}  
+            {"command", "cat /etc/os-release |grep VERSION= |cut -f2 -d="},
+            {"readonly", true},
+            {"depends", {"/etc/os-release"}}
         }
     })},
 
@@ -63,15 +67,21 @@ json j = {
     {"software", json::array({  
         json{
             {"name","dpkglist"},
-            {"command", "dpkg -l | grep ^ii | awk '{print $2 \" \" $3}'"}
+            {"command", "dpkg -l | grep ^ii | awk '{print $2 \" \" $3}'"},
+            {"readonly", true},
+            {"depends", {"/var/lib/dpkg/status"}}
         }, 
         json{
             {"name","snaplist"},
-            {"command", "snap list |grep \"^[^Name]\" | awk '{print $1 \" \" $2}'"}
+            {"command", "snap list |grep \"^[^Name]\" | awk '{print $1 \" \" $2}'"},
+            {"readonly", true},
+            {"depends", {"/var/lib/snapd/state.json"}}
         },
         json{        
             {"name","appimage"},
-            {"command", "find / -type f -name ''*.AppImage'' 2>/dev/null"}
+            {"command", "find / -type f -name ''*.AppImage'' 2>/dev/null"},
+            {"readonly", true},
+            {"cache_ttl", 60 * 60} //no file tells of a new AppImage, age only
         }
     })},
     
@@ -29,16 +29,23 @@
 #include <fstream>
 #include "statusInfo.h"
 #include "helper.h"
+#include "process.h"
+#include "commandCache.h"
 #include "apihandlers.h"
 #include "metricsinfo.h"
 #include <sstream> 
+#include <vector>
 #include <unistd.h>
 #include "Config.h"
+#include "snapshotWriter.h"
 
 using namespace std::chrono;
 
-CAPIHandlers::CAPIHandlers(int loglevel) {
+CAPIHandlers::CAPIHandlers(int loglevel, const std::atomic<bool>* pCancelRequest, CTaskExecutor* pExecutor)
+    : _commandCache(DISCOVERY_CACHE_DIR) {
     _log_level = loglevel; 
+    _pCancelRequest = pCancelRequest;
+    _pExecutor = pExecutor;
     init();
 }
 
@@ -56,21 +63,51 @@ int CAPIHandlers::deinit() {
     return 0;
 }
 
+/**
+ * Parses a line of a software list command: "<name> <version>".
+ *
+ * @param line The line, without newline.
+ * @param packages Receives name and version.
+ */
+void CAPIHandlers::parsePackageLine(std::string_view line, std::vector<std::pair<std::string, std::string>>& packages) {
+    if (line.empty()) {
+        return;
+    }
+    std::string msg = "each line: " + std::string(line);
+    applog::Log((int)applog::_log_type::info, msg, _log_level);
+    size_t pos = line.find(" ");
+    if (pos != std::string_view::npos) {
+        std::string sfversion(line.substr(pos + 1));
+        msg = "sf version: " + sfversion;
+        applog::Log((int)applog::_log_type::info, msg, _log_level);
+        if (pos > 0) {
+            packages.emplace_back(std::string(line.substr(0, pos)), std::move(sfversion));
+        }
+    }
+}
+
 /**
  * @brief Collects platform information and saves it as a JSON file.
  * 
  * This function collects platform information such as OS details, software components, and hardware details.
  * It saves the collected information as a JSON file with metadata and platform-specific information.
+ * The snapshot is written entry by entry, it is only held in memory as a whole if it is
+ * handed to a pipeline or returned in a non streaming response.
  * 
  * @param bNameOnly A boolean flag indicating whether to return only the filename or the entire JSON content. 
  *                  If true, it returns only the filename. If false, it returns the entire JSON content.
+ * @param pArtifacts If set, the snapshot is handed to the next pipeline stage in memory.
+ * @param bSave If false, the snapshot file is not written.
+ * @param pSink If set, receives progress; if also streaming, the content is sent as chunks instead of returned.
  * @return If bNameOnly is true, it returns the filename of the JSON file. 
- *         If bNameOnly is false, it returns the entire JSON content as a string.
+ *         If bNameOnly is false, it returns the entire JSON content, or the metadata
+ *         and number of chunks if the content was streamed.
  * @throws std::runtime_error if there is an error in collecting or processing the platform information.
  */
-std::string CAPIHandlers::collect(bool bNameOnly) {
+json CAPIHandlers::collect(bool bNameOnly, artifacts_t* pArtifacts, bool bSave, CResponseSink* pSink, bool bUseCache) {
   
     Config* pConfig = NULL; 
+    _bUseCache = bUseCache;
     try {
   
         CStatusInfo* pStatusInfo = CStatusInfo::getInstance();
@@ -86,9 +123,6 @@ std::string CAPIHandlers::collect(bool bNameOnly) {
         }
         std::string strOS = Helper::to_lower_copy(sfinfo._os);
             
-        //this json object will be saved as file 
-        json output;
-
         //read config file
         std::filesystem::path fs_config = std::filesystem::current_path() / "config";
         std::string str_configpath = fs_config.generic_string();    
@@ -118,132 +152,225 @@ std::string CAPIHandlers::collect(bool bNameOnly) {
             throw std::runtime_error(errorMessage);
         }	    
         
-        output[("metadata")][("name")] = "platform-snapshot.json";
-        output[("metadata")][("schema")] = "/usr/share/kit/schema/platform-snapshot-schema.json";
-        output[("metadata")][("identifier")] = "9743895863498";
-        output[("metadata")][("version")] = MICRO_SERVICE_VERSION;        
-        output[("metadata")][("desc")] = DESC;
-        output[("metadata")][("build")][("date")] = BUILDDATE;
+        json metadata;
+        metadata[("name")] = "platform-snapshot.json";
+        metadata[("schema")] = "/usr/share/kit/schema/platform-snapshot-schema.json";
+        metadata[("identifier")] = "9743895863498";
+        metadata[("version")] = MICRO_SERVICE_VERSION;        
+        metadata[("desc")] = DESC;
+        metadata[("build")][("date")] = BUILDDATE;
+
+        //where the snapshot goes: pipeline artifact, file, response chunks or response
+        bool bStream = (pArtifacts == NULL) && !bNameOnly && pSink && pSink->isStreaming();
+        bool bDocument = (pArtifacts != NULL) || (!bNameOnly && !bStream);
+        std::string str_fspath;
+        if (bSave) {
+            std::filesystem::path fspath = std::filesystem::current_path() / OUTPUT_FILE;
+            str_fspath = fspath.generic_string();         
+        }
+
+        //this json object will be the artifact or response, if needed at all
+        json output;
+        CSnapshotWriter writer(metadata, bDocument ? &output : NULL, str_fspath, bStream ? pSink : NULL);
                     	    	       
-        //auto nodeobj = osNode;            //nodeobj is node under os name such as: ubuntu: {...}
+        //localinstall is listed as a seperate node but belongs to the software category,
+        //it is written together with the software entries
+        bool bLocalInstall = osNode.contains("localInstall") && !osNode["localInstall"].is_array();
+        auto addLocalInstall = [&]() {
+            json& itemArray = osNode["localInstall"];
+            json jValue = checkLocalInstalls(itemArray) ? itemArray : json();
+            bLocalInstall = false;
+            return writer.addValue("software", "localInstall", std::move(jValue));
+        };
 
         for (auto Iter = osNode.begin(); Iter != osNode.end(); Iter++) {
             //node "kernel": [...], "software": [...]
             
             auto itemName = Iter.key(); //kernel, software, hardware     
                   
-            auto itemArray = Iter.value();
+            auto& itemArray = Iter.value();
 
             if (itemArray.is_array()){ //has to be array contents         
                 std::string newkey;
                 std::string newvalue; 
-                std::string items; 
-            
-                                 
+
+                //the commands of a category run at the same time, their output is drained
+                //by one CProcessMux; the results are written in config order below
+                std::vector<std::string> vResults(itemArray.size());
+                std::vector<bool> vLocalInstall(itemArray.size(), false);
+                //software lists: name and version of each line, parsed while the command runs
+                std::vector<std::vector<std::pair<std::string, std::string>>> vPackages(itemArray.size());
+                {
+                    size_t maxRunning = _pExecutor ? _pExecutor->concurrency() * DISCOVERY_COMMANDS_PER_CPU : 0;
+                    CProcessMux mux(maxRunning);
+                    std::vector<std::pair<size_t, size_t>> vCommands; //item index, mux id
+                    std::map<size_t, json> mStamps; //item index, dependency stamp of read-only commands that ran
+                    size_t idx = 0;
+                    for (auto& property : itemArray) {
+                        newkey = property["name"];
+                        newvalue = property.value("command", std::string());
+                        if (!newkey.empty() && !newvalue.empty()) {
+                            pStatusInfo->setStatusDetails("running", newkey);
+                            if (pSink) {
+                                pSink->writeProgress({{"running", newkey}});
+                            }
+                            //to include localInstalls; replaces the command result
+                            if (itemName == "software" && property.contains("items") && checkLocalInstalls(property["items"])) {
+                                vLocalInstall[idx] = true;
+                            } else {
+                                //"readonly" commands come from the cache while their "depends" paths are unchanged
+                                bool bReadOnly = property.value("readonly", false);
+                                json jStamp;
+                                std::string sCached;
+                                if (bReadOnly) {
+                                    jStamp = CCommandCache::stamp(property.value("depends", std::vector<std::string>()));
+                                }
+                                if (bReadOnly && _bUseCache &&
+                                    _commandCache.lookup(newvalue, jStamp, property.value("cache_ttl", (long)DISCOVERY_CACHE_TTL), sCached)) {
+                                    applog::Log((int)applog::_log_type::info, "cached result: " + newkey, _log_level);
+                                    if (itemName == "software") {
+                                        std::istringstream iss(sCached);
+                                        std::string line;
+                                        while (std::getline(iss, line)) {
+                                            parsePackageLine(line, vPackages[idx]);
+                                        }
+                                    } else {
+                                        vResults[idx] = std::move(sCached);
+                                    }
+                                } else {
+                                    stProcessOptions options;
+                                    options.bClearEnv = true;
+                                    options.pCancel = _pCancelRequest;
+                                    options.timeoutMs = property.value("timeout_ms", 0L);
+                                    options.maxOutput = DISCOVERY_MAX_OUTPUT;
+                                    if (itemName == "software") {
+                                        auto* pPackages = &vPackages[idx];
+                                        //the output is only kept for the cache
+                                        std::string* pOutput = bReadOnly ? &vResults[idx] : NULL;
+                                        options.onLine = [this, pPackages, pOutput](std::string_view line) {
+                                            parsePackageLine(line, *pPackages);
+                                            if (pOutput) {
+                                                pOutput->append(line).push_back('\n');
+                                            }
+                                        };
+                                    }
+                                    vCommands.emplace_back(idx, mux.addShell(newvalue, options));
+                                    if (bReadOnly) {
+                                        mStamps[idx] = std::move(jStamp);
+                                    }
+                                }
+                            }
+                        }
+                        idx++;
+                    }
+                    mux.wait();
+
+                    for (auto& command : vCommands) {
+                        stProcessResult& result = mux.result(command.second);
+                        if (result.bTimedOut || result.bTruncated) {
+                            std::string msg = "command " + std::string(result.bTimedOut ? "timed out" : "output truncated")
+                                              + ": " + itemArray[command.first].value("command", std::string());
+                            applog::Log((int)applog::_log_type::warning, msg, _log_level);
+                        }
+                        if (itemName != "software") {
+                            vResults[command.first] = std::move(result.output);
+                        }
+                        //the exit code is not checked, the output is used either way
+                        auto itStamp = mStamps.find(command.first);
+                        if (itStamp != mStamps.end() && result.bStarted && !result.bCancelled && !result.bTimedOut && !result.bTruncated) {
+                            _commandCache.store(itemArray[command.first].value("command", std::string()),
+                                                itStamp->second, vResults[command.first]);
+                        }
+                    }
+                }
+
+                size_t idx = 0;
                 for (auto& IterArray : itemArray.items()){
                 
-                    auto sfcomponents = json::array();                
-                    std::string strResult("");
+                    std::string strResult = std::move(vResults[idx]);
+                    bool bLocalInstallItems = vLocalInstall[idx];
+                    auto& packages = vPackages[idx];
+                    idx++;
 
-                    json property = IterArray.value();
+                    json& property = IterArray.value();
                     newkey = property["name"];
+                    if (isCancelled()) {
+                        throw std::runtime_error("cancelled");
+                    }
                     if (!newkey.empty()){
-                        pStatusInfo->setStatusDetails("running", newkey);                                        
              
                     newvalue = property["command"];
                     if (!newvalue.empty()){                                          
-                        //call popen to execute the command
-                        strResult = Helper::runCmd(newvalue, 0);                             
+                        bool bConsumer = true;
+
+                        if (bLocalInstallItems) {
+                            bConsumer = writer.addValue(itemName, newkey, json(property["items"]));
+                        } else if (itemName == "software"){                        
                            
-                        //this one needs special handling
-                        int i = 0;                        
-                        if (itemName == "software"){                        
-                            if (!strResult.empty()){ 
-                                //std::cout << "parsing software result contents: " << std::endl;       
-                        	    std::istringstream iss(strResult);
-                        	    std::string line;
-                        	    json sfdata; 
-                        	    
-                                while (std::getline(iss, line)){	                            
-                                    size_t pos = std::string::npos; 
-                                    if (!line.empty()){		
-                                        std::string msg = "each line: " + line; 
-    		                            applog::Log((int)applog::_log_type::info, msg, _log_level);     			
-	                                    pos = line.find(" ");
-					                    if (pos != std::string::npos){
-
-						                    std::string sfname = line.substr(0, pos); 
-						                    //std::cout << "sf name: " << sfname << std::endl;      
-						                    std::string sfversion = line.substr(pos+1);
-						                    msg = "sf version: " + sfversion;      
-						                    applog::Log((int)applog::_log_type::info, msg, _log_level);
-						                    if (!sfname.empty()){
-						                        sfdata[("name")] = sfname;
-						                        sfdata[("version")] = sfversion;
-						                        sfcomponents[i] = sfdata; 
-						                        i++; 
-						                    }
-					                    }
-					                }
-					            }
-
-                                    std::string msg = "total software components for this command is " + std::to_string(i); 
-                            		applog::Log((int)applog::_log_type::info, msg, _log_level);
-                                }
-                            }else {
-                                std::string str = Helper::erase_all(strResult, "\"");                
-                                strResult = Helper::erase_all(str, "\n");   
-                                //std::cout << "command result: " << strResult << std::endl;         
-                            }                        
-                        }
-                        
-                   if (itemName == "software"){                               
-                        output["platform info"][itemName][newkey] = sfcomponents;
-                        //to include localInstalls
-                        if(property.contains("items")){
-                             json itemsList =  property["items"];
-                          if (checkLocalInstalls(itemsList)) {
-                              output["platform info"][itemName][newkey] = property["items"] ;
+                            //this one needs special handling, the lines were parsed as they arrived
+                            bConsumer = writer.beginList(itemName, newkey);
+                            for (size_t i = 0; bConsumer && i < packages.size(); i++) {
+                                json sfdata;
+                                sfdata[("name")] = std::move(packages[i].first);
+                                sfdata[("version")] = std::move(packages[i].second);
+                                bConsumer = writer.addItem(std::move(sfdata));
                             }
+                            if (!packages.empty()) {
+                                std::string msg = "total software components for this command is " + std::to_string(packages.size());
+                                applog::Log((int)applog::_log_type::info, msg, _log_level);
+                            }
+                            std::vector<std::pair<std::string, std::string>>().swap(packages);
+                            bConsumer = writer.endList() && bConsumer;
+                        } else {
+                            std::string str = Helper::erase_all(strResult, "\"");                
+                            strResult = Helper::erase_all(str, "\n");   
+                            if( newkey == "platform") {
+                                strResult = getPltName(strResult);
+                            }   
+                            bConsumer = writer.addValue(itemName, newkey, strResult);
+                        }
+
+                        if (!bConsumer) {
+                            throw std::runtime_error("response consumer is gone");
                         }
-                    } else {
-                         if( newkey == "platform") {
-                           strResult = getPltName(strResult);
-                        }   
-                        output["platform info"][itemName][newkey] = strResult;
-                    }                  
                     }  
+                    }
                 }
 
-            } else {
-                //for built in config support: have difficulties to nest the loalinstall inside software node
-                //localinstall is listed as a seperate node but still output in the software category as it belongs to software list
-                //localinstall is not an array
-                if (itemName == "localInstall"){
-                    if (checkLocalInstalls(itemArray)) {
-                        output["platform info"]["software"][itemName] = itemArray; 
-                    } else {
-                        output["platform info"]["software"][itemName] = {}; 
-                    }
-                }                             
-            }                         
-        } 	    
-                                            
-        std::filesystem::path fspath = std::filesystem::current_path() / OUTPUT_FILE;
-        std::string str_fspath = fspath.generic_string();         
-        //std::cout << "output path: " << str_fspath << std::endl;                               
-        std::ofstream f(str_fspath,std::ios_base::trunc |std::ios_base::out);
-        f << std::setw(4) << output.dump();
-        f.close(); 
+                if (itemName == "software" && bLocalInstall && !addLocalInstall()) {
+                    throw std::runtime_error("response consumer is gone");
+                }
+            }
+        }
+
+        //no software category, localinstall stands alone
+        if (bLocalInstall && !addLocalInstall()) {
+            throw std::runtime_error("response consumer is gone");
+        }
+
+        if (!writer.finish()) {
+            std::string msg = "unable to write " + str_fspath;
+            applog::Log((int)applog::_log_type::error, msg, _log_level);
+        }
                
         if (pConfig){               
             delete pConfig;
         }
             
+        if (pArtifacts) {
+            //next stage reads it from memory, nothing to serialize
+            (*pArtifacts)[ARTIFACT_PLATFORM_SNAPSHOT] = std::move(output);
+            return ARTIFACT_PLATFORM_SNAPSHOT;
+        }
         if (bNameOnly){
             return OUTPUT_FILE;
+        } else if (bStream) {
+            json streamed;
+            streamed["metadata"] = std::move(metadata);
+            streamed["chunks"] = writer.chunks();
+            return streamed;
         } else {
-            return output.dump();
+            return output;
         }
 
     } catch (const std::exception &e) {
@@ -323,3 +450,7 @@ bool CAPIHandlers::checkDirExist(const std::string& directory) {
 void CAPIHandlers::cancelPackage(){
     _bCancel = true; 
 }
+
+bool CAPIHandlers::isCancelled() {
+    return _bCancel || (_pCancelRequest && *_pCancelRequest);
+}
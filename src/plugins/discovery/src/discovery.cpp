@@ -60,6 +60,7 @@ std::string CDiscovery::handleCancel(std::string sReq) {
     
     auto response = json::object();
     try{
+        mbCancel = true;
         response[MSG_STATUS] = MSG_SUCCESS;
 	} catch (const std::exception& e) {
         std::string msg = "Exception : ";
@@ -74,7 +75,7 @@ std::string CDiscovery::handleCancel(std::string sReq) {
 
 //! private function 
 /*! retrive the information of the microservice itself such as version, name, description and what os it intends for*/
-std::string CDiscovery::handleStatus(std::string message) {
+json CDiscovery::handleStatus(const json& jReq) {
 
 	auto response = json::object();
 
@@ -103,13 +104,13 @@ std::string CDiscovery::handleStatus(std::string message) {
 		response[MSG_STATUS] = MSG_FAILURE;
 	}
 
-	return response.dump();
+	return response;
 }
 
 
 //! private function 
 /*! advertise the capabilties, reserved for future*/
-std::string CDiscovery::handleCollect(std::string message) {  
+json CDiscovery::handleCollect(const json& jReq) {  
   
     auto response = json::object(); 
     response[MSG_STATUS] = MSG_FAILURE;       
@@ -118,14 +119,23 @@ std::string CDiscovery::handleCollect(std::string message) {
 	
     try{ 	
         bool bNameOnly = true; 
-        json jReq = json::parse(message);
+        //in a pipeline the snapshot is handed over in memory, file is optional
+        bool bSave = (mpArtifacts == NULL);
         if(jReq.contains("nameonly")) { bNameOnly = jReq.at("nameonly").get<bool>(); }      
+        if(jReq.contains(ARTIFACT_SAVE)) { bSave = jReq.at(ARTIFACT_SAVE).get<bool>(); }
+        bool bNoCache = jReq.value("nocache", false);
             
-        pAPIhandler = new CAPIHandlers();
+        pAPIhandler = new CAPIHandlers(1, mpCancel, mpExecutor);
         if(pAPIhandler) {
-            response[MSG_DATA] = pAPIhandler->collect(bNameOnly);            
-            pStatusInfo->setStatus(COLLECT_STATUS, "100");                
-            response[MSG_STATUS] = MSG_SUCCESS;                  
+            response[MSG_DATA] = pAPIhandler->collect(bNameOnly, mpArtifacts, bSave, mpSink, !bNoCache);            
+            if (*mpCancel) {
+                pStatusInfo->setStatus(COLLECT_STATUS, "0");                
+                response.erase(MSG_DATA);
+                response[MSG_DESC] = MSG_CANCELLED;
+            } else {
+                pStatusInfo->setStatus(COLLECT_STATUS, "100");                
+                response[MSG_STATUS] = MSG_SUCCESS;                  
+            }
         }                                             
 
     } catch (const std::exception &exc) {
@@ -140,29 +150,35 @@ std::string CDiscovery::handleCollect(std::string message) {
         pAPIhandler = NULL;
         CStatusInfo::deleteInstance();
     }    
-    return response.dump();
+    return response;
 }
 
 
 /**
 *  the entry point of this libaray
 */
-std::string CDiscovery::handleEntry(std::string sReq) {
+json CDiscovery::handleEntry(const json& jReq, artifacts_t* pArtifacts, CResponseSink* pSink, CTaskExecutor* pExecutor,
+                             const std::atomic<bool>* pCancel) {
 
-    std::cout << "discovery handleEntry: " << sReq << std::endl;
+    std::cout << "discovery handleEntry: " << jReq << std::endl;
     auto response = json::object();
+    mpArtifacts = pArtifacts;
+    mpSink = pSink;
+    mpExecutor = pExecutor;
+    if (!pCancel) {
+        mbCancel = false; //a framework without its own flag, a cancel before this point is lost
+    }
+    mpCancel = pCancel ? pCancel : &mbCancel;
    
     //todo: publish schema
     try {
-        //parse request
         std::string api = "";
-        json jReq = json::parse(sReq);
         if(jReq.contains("api")) { api = jReq.at("api").get<std::string>(); }
         
         if(api.compare("collect") ==0) {
-            return handleCollect(sReq);
+            return handleCollect(jReq);
         } else if(api.compare("status") ==0) {
-            return handleStatus(sReq);
+            return handleStatus(jReq);
         } else {
             response[MSG_STATUS] = MSG_FAILURE;
             response[MSG_DESC] = MSG_INVALID_REQUEST;
@@ -174,7 +190,7 @@ std::string CDiscovery::handleEntry(std::string sReq) {
         response[MSG_DESC] = msg;
 	}        
         
-	return response.dump();
+	return response;
 }        
 
 
@@ -19,8 +19,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <list>
 #include <vector>
@@ -28,6 +30,8 @@
 #include <queue>
 #include "discovery_definitions.h"
 #include "log.h"
+#include "pluginInterface.h"
+#include "commandCache.h"
 
 /*! Class to handle APIs */
 class CAPIHandlers {
@@ -53,6 +57,17 @@ private:
      
     bool _bCancel = false; 
     void cancelPackage();    
+
+    /** set by the framework to stop collecting, may be NULL */
+    const std::atomic<bool>* _pCancelRequest = NULL;
+    bool isCancelled();
+
+    /** framework thread pool, sizes how many commands run at once; NULL for no limit */
+    CTaskExecutor* _pExecutor = NULL;
+
+    /** results of "readonly" config commands */
+    CCommandCache _commandCache;
+    bool _bUseCache = true;
     
     int _log_level{1};
     
@@ -71,17 +86,26 @@ private:
     *   return bool
     */
     bool checkDirExist(const std::string& directory);
+   /** parsePackageLine: parse a line of a software list command
+    *   param: line, packages - receives name and version
+    */
+    void parsePackageLine(std::string_view line, std::vector<std::pair<std::string, std::string>>& packages);
   
 public:
 
-    CAPIHandlers(int loglevel=1);
+    CAPIHandlers(int loglevel=1, const std::atomic<bool>* pCancelRequest = NULL, CTaskExecutor* pExecutor = NULL);
     ~CAPIHandlers();
     
     /** collect the platform information in a json file 
     *   param: bool
+    *   param: pArtifacts - if set, snapshot is published as pipeline artifact
+    *   param: bSave - write the snapshot file
+    *   param: pSink - if streaming, the contents are sent in chunks
+    *   param: bUseCache - false reruns cached commands, their results are cached again
     *   return either a file name or file contents
     */
-    std::string collect(bool bNameOnly); 
+    nlohmann::json collect(bool bNameOnly, artifacts_t* pArtifacts = NULL, bool bSave = true, CResponseSink* pSink = NULL,
+                           bool bUseCache = true); 
     
 };
 
@@ -19,10 +19,12 @@
 
 #pragma once
 
+#include <atomic>
 
 #include "statusInfo.h"
 #include "metricsinfo.h"
 #include "log.h"
+#include "pluginInterface.h"
 
 
 //! A public class
@@ -36,16 +38,31 @@ class CDiscovery
     public:
       
     std::string handleInfo(std::string sReq);
-    std::string handleEntry(std::string sReq);
+    nlohmann::json handleEntry(const nlohmann::json& jReq, artifacts_t* pArtifacts = NULL, CResponseSink* pSink = NULL,
+                               CTaskExecutor* pExecutor = NULL, const std::atomic<bool>* pCancel = NULL);
     std::string handleCancel(std::string sReq);        
 
     private:       
                      
         int _log_level {1};                      
+
+        /*! pipeline artifacts of the current request, NULL outside a pipeline */
+        artifacts_t* mpArtifacts = NULL;
+
+        /*! response sink of the current request, large results are streamed to it */
+        CResponseSink* mpSink = NULL;
+
+        /*! framework thread pool, NULL if the framework has none */
+        CTaskExecutor* mpExecutor = NULL;
+
+        /*! set by handleCancel from another thread, polled while collecting */
+        std::atomic<bool> mbCancel {false};
+        /*! cancel flag of the current request: the framework one, else mbCancel */
+        const std::atomic<bool>* mpCancel = &mbCancel;
                
         //! private variable 
         /*! function pointer */            
-        typedef std::string (CDiscovery::*fPtr)(std::string);
+        typedef nlohmann::json (CDiscovery::*fPtr)(const nlohmann::json&);
         //! private variable 
         /*! map of functional pointers and http_request string */            
         std::map<std::string, fPtr> map_string_fPtr;            
@@ -53,19 +70,19 @@ class CDiscovery
                 
         //! private function 
         /* function to collect the data using the snap config file     
-         * @param[in] http_request message
+         * @param[in] parsed request
          * @throws none
-         * @return json std::string on success, empty std::string on failure.
+         * @return json response.
          */         
-        std::string handleCollect(std::string message);
+        nlohmann::json handleCollect(const nlohmann::json& jReq);
         
         //! private function 
         /* function to get the status of collecting operation             
-         * @param[in] http_request message
+         * @param[in] parsed request
          * @throws none
-         * @return json std::string on success, empty std::string on failure.
+         * @return json response.
          */        
-        std::string handleStatus(std::string message);      
+        nlohmann::json handleStatus(const nlohmann::json& jReq);      
                
         //! private function 
         /* initialization function
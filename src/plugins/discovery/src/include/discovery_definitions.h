@@ -34,6 +34,7 @@
 #define MSG_NOT_IMPLEMENTED "service not Implemented"
 #define MSG_INTERNAL_ERROR "internal error"
 #define MSG_MISSING_CLIENTINFO "Invalid request or request missing client info"
+#define MSG_CANCELLED "Request cancelled"
 
 //todo: move to a different file later
 #define COLLECT_STATUS "collect"
@@ -41,3 +42,12 @@
 //#define CONFIG_FILE "/usr/share/kit/json/snapshot_config.json"
 #define OUTPUT_FILE "platform-snapshot.json"
 #define CONFIG_FILE "snapshot_config.json"
+
+/** collection commands running at the same time, per cpu of the framework thread pool */
+#define DISCOVERY_COMMANDS_PER_CPU 4
+/** output kept per collection command (bytes) */
+#define DISCOVERY_MAX_OUTPUT (64 * 1024 * 1024)
+/** cached results of "readonly" collection commands, relative to the working directory */
+#define DISCOVERY_CACHE_DIR "command-cache"
+/** age of a cached result (s), if the config entry has no "cache_ttl" */
+#define DISCOVERY_CACHE_TTL (24 * 60 * 60)
@@ -26,7 +26,7 @@
 #include "pluginInterface.h"
 
 
-class CPlugin : public CPluginInterface {
+class CPlugin : public CPluginInterfaceV2 {
 private:
     CDiscovery* pInstance;
     
@@ -38,7 +38,7 @@ public:
     void deinit(void* pCxt);
 
     std::string getInfo(void* pCxt);
-    std::string entry(void* pCxt, std::string sReq);
+    void entryV2(void* pCxt, const nlohmann::json& jReq, CResponseSink& sink);
     void cancel(void* pCxt, std::string sReq);
     
 };
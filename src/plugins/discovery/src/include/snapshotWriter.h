@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "pluginInterface.h"
+
+/** max list entries (packages) per response chunk */
+#define SNAPSHOT_CHUNK_ITEMS 256
+
+/*! Builds the platform snapshot entry by entry.
+ *
+ * Every entry goes to any of
+ *  - a json document (pipeline artifact, non streaming response)
+ *  - the snapshot file, written while the entries arrive
+ *  - a streaming response sink as chunks:
+ *    {"chunk": <seq>, "category": "software", "name": "dpkg", "data": [...], "append": true}
+ *    lists are split after SNAPSHOT_CHUNK_ITEMS entries, "append" marks the
+ *    continuation of the list of the previous chunk.
+ * Without a document only the current chunk is held in memory.
+ *
+ * Entries of one category have to be added one after the other.
+ */
+class CSnapshotWriter {
+
+private:
+    nlohmann::json* mpDocument;
+    CResponseSink* mpSink;
+
+    std::string msFile;
+    std::string msTmpFile;
+    std::ofstream mFile;
+
+    std::string msCategory;  //category currently open in the file
+    bool mbFirstCategory;
+    bool mbFirstEntry;
+
+    std::string msListName;  //list currently open
+    nlohmann::json mListChunk;
+    bool mbListAppend;
+    bool mbFirstItem;
+
+    size_t mChunks;
+    bool mbConsumerGone;
+
+    //coverity
+    CSnapshotWriter(CSnapshotWriter const&) = delete;
+    void operator=(CSnapshotWriter const&) = delete;
+
+    /** start an entry in the file, switching category if needed */
+    void fileBeginEntry(const std::string& sCategory, const std::string& sName);
+
+    /** send one chunk to the sink */
+    bool emitChunk(const std::string& sCategory, const std::string& sName, nlohmann::json&& jData, bool bAppend);
+
+    /** send the buffered list entries */
+    bool flushList();
+
+public:
+    /** pDocument, sFile and pSink are optional (NULL / empty) */
+    CSnapshotWriter(const nlohmann::json& jMetadata, nlohmann::json* pDocument,
+                    const std::string& sFile, CResponseSink* pSink);
+    ~CSnapshotWriter();
+
+    /** add a single value entry; returns false if the consumer is gone */
+    bool addValue(const std::string& sCategory, const std::string& sName, nlohmann::json&& jValue);
+
+    /** list entry: beginList, addItem for every entry, endList */
+    bool beginList(const std::string& sCategory, const std::string& sName);
+    bool addItem(nlohmann::json&& jItem);
+    bool endList();
+
+    /** complete the snapshot file; returns false if it could not be written */
+    bool finish();
+
+    /** number of chunks sent */
+    size_t chunks() const { return mChunks; }
+};
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2024, Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+
+ * http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+
+#include <filesystem>
+
+#include "snapshotWriter.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief Opens the snapshot file (written to a temporary file, renamed by finish)
+ *        and writes the metadata.
+ */
+CSnapshotWriter::CSnapshotWriter(const json& jMetadata, json* pDocument,
+                                 const std::string& sFile, CResponseSink* pSink) {
+    mpDocument = pDocument;
+    mpSink = pSink;
+    msFile = sFile;
+    mbFirstCategory = true;
+    mbFirstEntry = true;
+    mbListAppend = false;
+    mbFirstItem = true;
+    mChunks = 0;
+    mbConsumerGone = false;
+
+    if (mpDocument) {
+        (*mpDocument)["metadata"] = jMetadata;
+    }
+    if (!msFile.empty()) {
+        msTmpFile = msFile + ".tmp";
+        mFile.open(msTmpFile, std::ios_base::trunc | std::ios_base::out);
+        if (mFile.is_open()) {
+            mFile << "{\"metadata\":" << jMetadata.dump() << ",\"platform info\":{";
+        }
+    }
+}
+
+CSnapshotWriter::~CSnapshotWriter() {
+    //not finished - do not leave a truncated snapshot behind
+    if (mFile.is_open()) {
+        mFile.close();
+        std::error_code ec;
+        std::filesystem::remove(msTmpFile, ec);
+    }
+}
+
+void CSnapshotWriter::fileBeginEntry(const std::string& sCategory, const std::string& sName) {
+    if (!mFile.is_open()) {
+        return;
+    }
+    if (mbFirstCategory || sCategory != msCategory) {
+        if (!mbFirstCategory) {
+            mFile << "},";
+        }
+        mFile << json(sCategory).dump() << ":{";
+        msCategory = sCategory;
+        mbFirstCategory = false;
+        mbFirstEntry = true;
+    }
+    if (!mbFirstEntry) {
+        mFile << ",";
+    }
+    mFile << json(sName).dump() << ":";
+    mbFirstEntry = false;
+}
+
+bool CSnapshotWriter::emitChunk(const std::string& sCategory, const std::string& sName, json&& jData, bool bAppend) {
+    if (mbConsumerGone) {
+        return false;
+    }
+    json jChunk = json::object();
+    jChunk["chunk"] = mChunks;
+    jChunk["category"] = sCategory;
+    jChunk["name"] = sName;
+    jChunk["data"] = std::move(jData);
+    if (bAppend) {
+        jChunk["append"] = true;
+    }
+    if (!mpSink->writeChunk(std::move(jChunk))) {
+        mbConsumerGone = true;
+        return false;
+    }
+    mChunks++;
+    return true;
+}
+
+bool CSnapshotWriter::flushList() {
+    bool bRet = emitChunk(msCategory, msListName, std::move(mListChunk), mbListAppend);
+    mListChunk = json::array();
+    mbListAppend = true;
+    return bRet;
+}
+
+bool CSnapshotWriter::addValue(const std::string& sCategory, const std::string& sName, json&& jValue) {
+    fileBeginEntry(sCategory, sName);
+    if (mFile.is_open()) {
+        mFile << jValue.dump();
+    }
+    msCategory = sCategory;
+
+    if (mpSink && !emitChunk(sCategory, sName, mpDocument ? json(jValue) : std::move(jValue), false)) {
+        return false;
+    }
+    if (mpDocument) {
+        (*mpDocument)["platform info"][sCategory][sName] = std::move(jValue);
+    }
+    return true;
+}
+
+bool CSnapshotWriter::beginList(const std::string& sCategory, const std::string& sName) {
+    fileBeginEntry(sCategory, sName);
+    if (mFile.is_open()) {
+        mFile << "[";
+    }
+    msCategory = sCategory;
+    msListName = sName;
+    mListChunk = json::array();
+    mbListAppend = false;
+    mbFirstItem = true;
+
+    if (mpDocument) {
+        (*mpDocument)["platform info"][sCategory][sName] = json::array();
+    }
+    return !mbConsumerGone;
+}
+
+bool CSnapshotWriter::addItem(json&& jItem) {
+    if (mFile.is_open()) {
+        if (!mbFirstItem) {
+            mFile << ",";
+        }
+        mFile << jItem.dump();
+    }
+    mbFirstItem = false;
+
+    if (mpDocument) {
+        (*mpDocument)["platform info"][msCategory][msListName].push_back(mpSink ? json(jItem) : std::move(jItem));
+    }
+    if (mpSink) {
+        mListChunk.push_back(std::move(jItem));
+        if (mListChunk.size() >= SNAPSHOT_CHUNK_ITEMS) {
+            return flushList();
+        }
+    }
+    return !mbConsumerGone;
+}
+
+bool CSnapshotWriter::endList() {
+    if (mFile.is_open()) {
+        mFile << "]";
+    }
+    //an empty list is still sent once
+    if (mpSink && (!mListChunk.empty() || !mbListAppend)) {
+        return flushList();
+    }
+    return !mbConsumerGone;
+}
+
+bool CSnapshotWriter::finish() {
+    if (!mFile.is_open()) {
+        return msFile.empty();
+    }
+    if (!mbFirstCategory) {
+        mFile << "}";
+    }
+    mFile << "}}";
+    mFile.close();
+    if (mFile.fail()) {
+        std::error_code ec;
+        std::filesystem::remove(msTmpFile, ec);
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(msTmpFile, msFile, ec);
+    return !ec;
+}